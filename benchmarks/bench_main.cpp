@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <tbb/global_control.h>
+
+#include "analysis_pipeline/config/config_manager.h"
+#include "analysis_pipeline/pipeline/pipeline.h"
+#include "dag_shapes.h"
+#include "synthetic_stages.h"
+
+namespace {
+
+struct BenchOptions {
+    uint64_t events = 20000;
+    uint64_t warmupEvents = 200;
+    size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t size = 8;
+    size_t inFlight = 4;
+    std::string stage = "noop";
+    uint64_t costNs = 1000;
+    size_t bytes = 4096;
+    size_t allocations = 16;
+    std::vector<std::string> shapes = {"chain", "fanout", "diamond", "tree"};
+    std::vector<std::string> modes = {"graph", "stream"};
+    bool profiling = false;
+    bool arena = false;
+    std::string jsonPath;
+};
+
+void printUsage() {
+    std::cout << "Usage: analysis_pipeline_bench [OPTIONS]\n"
+              << "\n"
+              << "Options:\n"
+              << "  --events <n>        Events per measurement (default 20000)\n"
+              << "  --warmup <n>        Warm-up events before each measurement (default 200)\n"
+              << "  --max-threads <n>   Scale TBB threads 1, 2, 4, ... up to n (default: all cores)\n"
+              << "  --shapes <list>     Comma-separated: chain,fanout,diamond,tree (default: all)\n"
+              << "  --size <n>          Chain length / fan-out width / tree depth (default 8)\n"
+              << "  --stage <type>      noop | fixed | alloc (default noop)\n"
+              << "  --cost-ns <n>       Work per fixed-cost stage call (default 1000)\n"
+              << "  --bytes <n>         Bytes per allocation for alloc stages (default 4096)\n"
+              << "  --allocations <n>   Allocations per alloc stage call (default 16)\n"
+              << "  --modes <list>      Comma-separated: graph,stream (default: both)\n"
+              << "  --in-flight <n>     Max events in flight for stream mode (default 4)\n"
+              << "  --profiling         Keep per-stage instrumentation enabled\n"
+              << "  --arena             Allocate alloc-stage memory from the per-event arena\n"
+              << "  --json <path>       Also write results as JSON\n"
+              << "  -h, --help          Display this help message\n";
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--events") {
+            opts.events = std::stoull(value());
+        } else if (arg == "--warmup") {
+            opts.warmupEvents = std::stoull(value());
+        } else if (arg == "--max-threads") {
+            opts.maxThreads = std::max<size_t>(1, std::stoul(value()));
+        } else if (arg == "--shapes") {
+            opts.shapes = splitList(value());
+        } else if (arg == "--size") {
+            opts.size = std::max<size_t>(1, std::stoul(value()));
+        } else if (arg == "--stage") {
+            opts.stage = value();
+        } else if (arg == "--cost-ns") {
+            opts.costNs = std::stoull(value());
+        } else if (arg == "--bytes") {
+            opts.bytes = std::stoul(value());
+        } else if (arg == "--allocations") {
+            opts.allocations = std::stoul(value());
+        } else if (arg == "--modes") {
+            opts.modes = splitList(value());
+        } else if (arg == "--in-flight") {
+            opts.inFlight = std::max<size_t>(1, std::stoul(value()));
+        } else if (arg == "--profiling") {
+            opts.profiling = true;
+        } else if (arg == "--arena") {
+            opts.arena = true;
+        } else if (arg == "--json") {
+            opts.jsonPath = value();
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage();
+            std::exit(0);
+        } else {
+            throw std::invalid_argument("unknown option: " + arg);
+        }
+    }
+    return true;
+}
+
+std::vector<size_t> threadCounts(size_t maxThreads) {
+    std::vector<size_t> counts;
+    for (size_t t = 1; t < maxThreads; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(maxThreads);
+    return counts;
+}
+
+// Runs 'events' events in the given mode and returns the elapsed seconds
+double runEvents(Pipeline& pipeline, const std::string& mode, uint64_t events) {
+    const auto start = std::chrono::steady_clock::now();
+    if (mode == "graph") {
+        for (uint64_t i = 0; i < events; ++i) {
+            pipeline.execute();
+        }
+    } else {
+        uint64_t remaining = events;
+        auto input = std::make_shared<const InputBundle>();
+        pipeline.executeStream([&remaining, &input](std::shared_ptr<const InputBundle>& next) {
+            if (remaining == 0) {
+                return false;
+            }
+            --remaining;
+            next = input;
+            return true;
+        });
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    try {
+        parseArgs(argc, argv, opts);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    spdlog::set_level(spdlog::level::warn);
+    registerSyntheticStages();
+
+    std::string stageType;
+    nlohmann::json params = nlohmann::json::object();
+    if (opts.stage == "noop") {
+        stageType = "NoOpStage";
+    } else if (opts.stage == "fixed") {
+        stageType = "FixedCostStage";
+        params["cost_ns"] = opts.costNs;
+    } else if (opts.stage == "alloc") {
+        stageType = "AllocatingStage";
+        params["bytes"] = opts.bytes;
+        params["allocations"] = opts.allocations;
+        params["use_arena"] = opts.arena;
+    } else {
+        std::cerr << "Error: unknown stage type '" << opts.stage << "'" << std::endl;
+        return 1;
+    }
+
+    nlohmann::json results = nlohmann::json::array();
+
+    std::cout << std::left
+              << std::setw(9) << "shape" << std::setw(8) << "stages" << std::setw(8) << "mode"
+              << std::setw(9) << "threads" << std::setw(14) << "events/s"
+              << std::setw(14) << "ns/event" << std::setw(16) << "ns/stage-call"
+              << "speedup" << std::endl;
+
+    for (const auto& shape : opts.shapes) {
+        auto stages = makeShape(shape, opts.size, stageType, params);
+        if (stages.empty()) {
+            std::cerr << "Error: unknown shape '" << shape << "'" << std::endl;
+            return 1;
+        }
+
+        for (const auto& mode : opts.modes) {
+            if (mode != "graph" && mode != "stream") {
+                std::cerr << "Error: unknown mode '" << mode << "'" << std::endl;
+                return 1;
+            }
+
+            double singleThreadRate = 0.0;
+            for (size_t threads : threadCounts(opts.maxThreads)) {
+                tbb::global_control threadLimit(tbb::global_control::max_allowed_parallelism, threads);
+
+                auto configManager = std::make_shared<ConfigManager>();
+                configManager->setPipelineStages(stages);
+
+                Pipeline pipeline(configManager);
+                pipeline.setProfilingEnabled(opts.profiling);
+                pipeline.setMaxEventsInFlight(opts.inFlight);
+                pipeline.setEventArenaEnabled(opts.arena);
+                if (!pipeline.buildFromConfig()) {
+                    std::cerr << "Error: Failed to build pipeline for shape " << shape << std::endl;
+                    return 1;
+                }
+
+                runEvents(pipeline, mode, opts.warmupEvents);
+                const double seconds = runEvents(pipeline, mode, opts.events);
+
+                const double rate = static_cast<double>(opts.events) / seconds;
+                const double nsPerEvent = seconds * 1e9 / static_cast<double>(opts.events);
+                const double nsPerCall = nsPerEvent / static_cast<double>(stages.size());
+                if (threads == 1) {
+                    singleThreadRate = rate;
+                }
+                const double speedup = singleThreadRate > 0.0 ? rate / singleThreadRate : 0.0;
+
+                std::cout << std::left << std::fixed << std::setprecision(1)
+                          << std::setw(9) << shape << std::setw(8) << stages.size() << std::setw(8) << mode
+                          << std::setw(9) << threads << std::setw(14) << rate
+                          << std::setw(14) << nsPerEvent << std::setw(16) << nsPerCall
+                          << std::setprecision(2) << speedup << std::endl;
+
+                nlohmann::json row;
+                row["shape"] = shape;
+                row["stages"] = stages.size();
+                row["stage_type"] = stageType;
+                row["mode"] = mode;
+                row["threads"] = threads;
+                row["events"] = opts.events;
+                row["events_per_sec"] = rate;
+                row["ns_per_event"] = nsPerEvent;
+                row["ns_per_stage_call"] = nsPerCall;
+                row["speedup"] = speedup;
+                if (opts.profiling) {
+                    row["stage_metrics"] = pipeline.getStageMetrics();
+                }
+                if (opts.arena) {
+                    row["event_arena"] = pipeline.getEventArenaStats();
+                }
+                results.push_back(std::move(row));
+            }
+        }
+    }
+
+    if (!opts.jsonPath.empty()) {
+        std::ofstream out(opts.jsonPath);
+        if (!out.is_open()) {
+            std::cerr << "Error: Could not open " << opts.jsonPath << std::endl;
+            return 1;
+        }
+        out << results.dump(4) << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "dag_shapes.h"
+
+namespace {
+
+StageConfig makeStage(size_t index, const std::string& type, const nlohmann::json& params) {
+    StageConfig sc;
+    sc.id = "s" + std::to_string(index);
+    sc.type = type;
+    sc.parameters = params;
+    return sc;
+}
+
+} // anonymous namespace
+
+std::vector<StageConfig> makeChain(size_t length, const std::string& type, const nlohmann::json& params) {
+    std::vector<StageConfig> stages;
+    for (size_t i = 0; i < length; ++i) {
+        stages.push_back(makeStage(i, type, params));
+        if (i + 1 < length) {
+            stages.back().next.push_back("s" + std::to_string(i + 1));
+        }
+    }
+    return stages;
+}
+
+std::vector<StageConfig> makeFanOut(size_t width, const std::string& type, const nlohmann::json& params) {
+    std::vector<StageConfig> stages;
+    stages.push_back(makeStage(0, type, params));
+    for (size_t i = 1; i <= width; ++i) {
+        stages.front().next.push_back("s" + std::to_string(i));
+        stages.push_back(makeStage(i, type, params));
+    }
+    return stages;
+}
+
+std::vector<StageConfig> makeDiamond(size_t width, const std::string& type, const nlohmann::json& params) {
+    std::vector<StageConfig> stages = makeFanOut(width, type, params);
+    const std::string joinId = "s" + std::to_string(width + 1);
+    for (size_t i = 1; i <= width; ++i) {
+        stages[i].next.push_back(joinId);
+    }
+    stages.push_back(makeStage(width + 1, type, params));
+    return stages;
+}
+
+std::vector<StageConfig> makeTree(size_t depth, size_t branching, const std::string& type, const nlohmann::json& params) {
+    std::vector<StageConfig> stages;
+    if (depth == 0) {
+        return stages;
+    }
+
+    stages.push_back(makeStage(0, type, params));
+    size_t levelBegin = 0;
+    size_t levelEnd = 1;
+    for (size_t level = 1; level < depth; ++level) {
+        for (size_t parent = levelBegin; parent < levelEnd; ++parent) {
+            for (size_t b = 0; b < branching; ++b) {
+                const size_t child = stages.size();
+                stages[parent].next.push_back("s" + std::to_string(child));
+                stages.push_back(makeStage(child, type, params));
+            }
+        }
+        levelBegin = levelEnd;
+        levelEnd = stages.size();
+    }
+    return stages;
+}
+
+std::vector<StageConfig> makeShape(const std::string& shape, size_t size, const std::string& type, const nlohmann::json& params) {
+    if (shape == "chain") {
+        return makeChain(size, type, params);
+    }
+    if (shape == "fanout") {
+        return makeFanOut(size, type, params);
+    }
+    if (shape == "diamond") {
+        return makeDiamond(size, type, params);
+    }
+    if (shape == "tree") {
+        return makeTree(size, 2, type, params);
+    }
+    return {};
+}
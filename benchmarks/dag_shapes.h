@@ -0,0 +1,30 @@
+#ifndef ANALYSISPIPELINE_BENCH_DAGSHAPES_H
+#define ANALYSISPIPELINE_BENCH_DAGSHAPES_H
+
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/config/config_manager.h"
+
+// Generators for synthetic pipeline graphs. Every stage gets the same type and
+// parameters; ids are "s0", "s1", ... in creation order.
+
+// s0 -> s1 -> ... -> s(length-1)
+std::vector<StageConfig> makeChain(size_t length, const std::string& type, const nlohmann::json& params);
+
+// s0 -> {s1 .. s(width)}, no join
+std::vector<StageConfig> makeFanOut(size_t width, const std::string& type, const nlohmann::json& params);
+
+// s0 -> {s1 .. s(width)} -> s(width+1)
+std::vector<StageConfig> makeDiamond(size_t width, const std::string& type, const nlohmann::json& params);
+
+// Complete tree of the given depth where every inner stage has 'branching' children
+std::vector<StageConfig> makeTree(size_t depth, size_t branching, const std::string& type, const nlohmann::json& params);
+
+// Dispatches on "chain", "fanout", "diamond" or "tree" with 'size' as the main
+// dimension (tree: depth with branching 2); returns an empty vector otherwise
+std::vector<StageConfig> makeShape(const std::string& shape, size_t size, const std::string& type, const nlohmann::json& params);
+
+#endif // ANALYSISPIPELINE_BENCH_DAGSHAPES_H
@@ -0,0 +1,78 @@
+#include "synthetic_stages.h"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "analysis_pipeline/memory/event_arena.h"
+#include "analysis_pipeline/pipeline/pipeline.h"
+
+namespace {
+// Keeps the optimizer from discarding the allocating stage's work
+std::atomic<uint64_t> sink{0};
+} // anonymous namespace
+
+NoOpStage::NoOpStage(const nlohmann::json&) {}
+
+void NoOpStage::Process() {}
+
+std::string NoOpStage::Name() const {
+    return "NoOpStage";
+}
+
+FixedCostStage::FixedCostStage(const nlohmann::json& params)
+    : costNs_(params.value("cost_ns", 1000ULL)) {}
+
+void FixedCostStage::Process() {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::nanoseconds(costNs_);
+    while (std::chrono::steady_clock::now() < deadline) {
+    }
+}
+
+std::string FixedCostStage::Name() const {
+    return "FixedCostStage";
+}
+
+AllocatingStage::AllocatingStage(const nlohmann::json& params)
+    : bytes_(params.value("bytes", size_t{4096})),
+      allocations_(params.value("allocations", size_t{16})),
+      useArena_(params.value("use_arena", false)) {}
+
+void AllocatingStage::Process() {
+    EventArena* arena = useArena_ ? EventArena::current() : nullptr;
+    if (arena) {
+        uint64_t checksum = 0;
+        for (size_t i = 0; i < allocations_; ++i) {
+            auto* block = static_cast<char*>(arena->allocate(bytes_, alignof(std::max_align_t)));
+            std::memset(block, static_cast<int>(i), bytes_);
+            checksum += static_cast<unsigned char>(block[bytes_ / 2]);
+        }
+        sink.fetch_add(checksum, std::memory_order_relaxed);
+        return;
+    }
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    blocks.reserve(allocations_);
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < allocations_; ++i) {
+        blocks.emplace_back(new char[bytes_]);
+        std::memset(blocks.back().get(), static_cast<int>(i), bytes_);
+        checksum += static_cast<unsigned char>(blocks.back()[bytes_ / 2]);
+    }
+    sink.fetch_add(checksum, std::memory_order_relaxed);
+}
+
+std::string AllocatingStage::Name() const {
+    return "AllocatingStage";
+}
+
+void registerSyntheticStages() {
+    Pipeline::registerStageFactory("NoOpStage",
+        [](const nlohmann::json& params) -> BaseStage* { return new NoOpStage(params); });
+    Pipeline::registerStageFactory("FixedCostStage",
+        [](const nlohmann::json& params) -> BaseStage* { return new FixedCostStage(params); });
+    Pipeline::registerStageFactory("AllocatingStage",
+        [](const nlohmann::json& params) -> BaseStage* { return new AllocatingStage(params); });
+}
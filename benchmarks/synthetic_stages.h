@@ -0,0 +1,51 @@
+#ifndef ANALYSISPIPELINE_BENCH_SYNTHETICSTAGES_H
+#define ANALYSISPIPELINE_BENCH_SYNTHETICSTAGES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/core/stages/base_stage.h"
+
+// Stages with a known, configurable cost used to measure framework overhead.
+// They are created through Pipeline::registerStageFactory(), not ROOT.
+
+// Does nothing; every nanosecond spent on it is scheduling overhead
+class NoOpStage : public BaseStage {
+public:
+    explicit NoOpStage(const nlohmann::json& params);
+    void Process() override;
+    std::string Name() const override;
+};
+
+// Spins for "cost_ns" nanoseconds of wall time
+class FixedCostStage : public BaseStage {
+public:
+    explicit FixedCostStage(const nlohmann::json& params);
+    void Process() override;
+    std::string Name() const override;
+
+private:
+    uint64_t costNs_;
+};
+
+// Makes "allocations" allocations of "bytes" each, touches and frees them.
+// With "use_arena" they come from the pipeline's per-event arena when enabled.
+class AllocatingStage : public BaseStage {
+public:
+    explicit AllocatingStage(const nlohmann::json& params);
+    void Process() override;
+    std::string Name() const override;
+
+private:
+    size_t bytes_;
+    size_t allocations_;
+    bool useArena_;
+};
+
+// Registers the stages above as "NoOpStage", "FixedCostStage", "AllocatingStage"
+void registerSyntheticStages();
+
+#endif // ANALYSISPIPELINE_BENCH_SYNTHETICSTAGES_H
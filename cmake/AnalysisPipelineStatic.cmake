@@ -0,0 +1,59 @@
+# analysis_pipeline_add_static_pipeline(<target>
+#   CONFIGS <config.json>...
+#   [HEADERS <header>...]
+#   [TYPES <Type=CppType>...]
+#   [SOURCES <source>...]
+#   [LINK_LIBRARIES <library>...])
+#
+# Compiles a frozen pipeline config ahead of time. analysis_pipeline_static_gen
+# turns the merged CONFIGS into <target>_pipeline.cpp, which constructs the
+# concrete stage types and calls them in topological order (see
+# static_pipeline.h). The executable <target> is built from it. HEADERS are the
+# headers declaring the stage types, as they would be #included. TYPES maps
+# config type names to C++ types where they differ. Stage sources listed in
+# SOURCES are compiled into the executable, so calls across stages can be
+# inlined. Plugin libraries go in LINK_LIBRARIES. The source is regenerated
+# when a config changes.
+function(analysis_pipeline_add_static_pipeline target)
+  cmake_parse_arguments(ARG "" "" "CONFIGS;HEADERS;TYPES;SOURCES;LINK_LIBRARIES" ${ARGN})
+  if(NOT ARG_CONFIGS)
+    message(FATAL_ERROR "analysis_pipeline_add_static_pipeline(${target}): CONFIGS is required")
+  endif()
+
+  # In-tree build or installed package
+  if(TARGET analysis_pipeline_static_gen)
+    set(_generator analysis_pipeline_static_gen)
+    set(_generator_dep analysis_pipeline_static_gen)
+    set(_library analysis_pipeline)
+  else()
+    set(_generator analysis_pipeline::analysis_pipeline_static_gen)
+    set(_generator_dep "")
+    set(_library analysis_pipeline::analysis_pipeline)
+  endif()
+
+  set(_configs "")
+  foreach(_config IN LISTS ARG_CONFIGS)
+    get_filename_component(_config_path "${_config}" ABSOLUTE)
+    list(APPEND _configs "${_config_path}")
+  endforeach()
+
+  set(_args "")
+  foreach(_header IN LISTS ARG_HEADERS)
+    list(APPEND _args --header "${_header}")
+  endforeach()
+  foreach(_type IN LISTS ARG_TYPES)
+    list(APPEND _args --type "${_type}")
+  endforeach()
+
+  set(_output "${CMAKE_CURRENT_BINARY_DIR}/${target}_pipeline.cpp")
+  add_custom_command(
+    OUTPUT "${_output}"
+    COMMAND ${_generator} --output "${_output}" --name ${target} ${_args} ${_configs}
+    DEPENDS ${_generator_dep} ${_configs}
+    COMMENT "Generating static pipeline ${target}"
+    VERBATIM
+  )
+
+  add_executable(${target} "${_output}" ${ARG_SOURCES})
+  target_link_libraries(${target} PRIVATE ${_library} ${ARG_LINK_LIBRARIES})
+endfunction()
@@ -1,17 +1,98 @@
 #ifndef ANALYSISPIPELINE_CONFIGMANAGER_H
 #define ANALYSISPIPELINE_CONFIGMANAGER_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <set>
 #include <nlohmann/json.hpp>
 #include "analysis_pipeline/config/config_parser.h"
 
+// When a scheduled stage runs ("schedule" in its config). Conditions
+// combine; a stage with none set runs for every event.
+struct StageSchedule {
+    uint64_t everyEvents = 0;   // "every_events"
+    double everySeconds = 0.0;  // "every_seconds"
+    bool endOfRun = false;      // "end_of_run"
+    // "blocking": run on the live products while the stream is held, instead
+    // of on copies taken at the drain boundary
+    bool blocking = false;
+
+    bool scheduled() const { return everyEvents > 0 || everySeconds > 0.0 || endOfRun; }
+};
+
 struct StageConfig {
     std::string id;
     std::string type;
     nlohmann::json parameters;
     std::vector<std::string> next;
+    StageSchedule schedule;
+    // "criticality": "optional" stages may be shed under overload (default "essential")
+    bool optional = false;
+};
+
+// Where stage edges come from (top-level "edges" key)
+enum class EdgeMode {
+    Explicit, // "next" lists only (default)
+    Derived,  // declared product reads/writes; "next" is ignored
+    Merged    // both
+};
+
+// One TBB task arena from the "execution" block
+struct ArenaConfig {
+    std::string name;
+    // Maximum threads working in the arena; 0 keeps the TBB default
+    int maxConcurrency = 0;
+    // Pin the arena's threads to these CPUs, or to the CPUs of numaNode (-1: none)
+    std::vector<int> cpus;
+    int numaNode = -1;
+    // Stage ids whose Process() runs in this arena (stage arenas only)
+    std::vector<std::string> stages;
+};
+
+// Defaults of the "background" arena: one low-priority thread
+inline ArenaConfig makeBackgroundArenaConfig() {
+    ArenaConfig arena;
+    arena.name = "background";
+    arena.maxConcurrency = 1;
+    return arena;
+}
+
+struct ExecutionConfig {
+    // Arena the graph and the pipelined executor run in
+    ArenaConfig pipeline;
+    // Dedicated arenas for individual stages
+    std::vector<ArenaConfig> stageArenas;
+    // Low-priority arena for scheduled stages ("background"); one thread by default
+    ArenaConfig background = makeBackgroundArenaConfig();
+    // Independent copies of the stage graph used by ShardedPipeline
+    int replicas = 1;
+    // False when the config has no "execution" block
+    bool configured = false;
+};
+
+// Top-level "overload" block: when optional stages are shed
+struct OverloadConfig {
+    // Optional stages that would start later than this after their event
+    // was admitted are skipped; an event retiring later enters overload (0: off)
+    double latencyBudgetMs = 0.0;
+    // Input queue depth that enters overload, and the depth it must fall
+    // back to before overload ends (0: queue depth is not watched)
+    size_t queueHigh = 0;
+    size_t queueLow = 0;
+    // Overload lasts at least this long after the last late event
+    double holdMs = 1000.0;
+
+    bool configured() const { return latencyBudgetMs > 0.0 || queueHigh > 0; }
+};
+
+// Top-level "outputs" block: what a run needs. Stages that contribute to
+// none of these are left out of the built graph; both empty keeps all.
+struct OutputsConfig {
+    std::vector<std::string> products;
+    std::vector<std::string> stages;
+
+    bool empty() const { return products.empty() && stages.empty(); }
 };
 
 class ConfigManager {
@@ -27,10 +108,30 @@ public:
     const std::vector<StageConfig>& getPipelineStages() const;
     const nlohmann::json& getLoggerConfig() const;
     const std::vector<std::string>& getPluginLibraries() const;
+    // Optional "input" block describing the event source (empty if absent)
+    const nlohmann::json& getInputConfig() const;
+    // Optional "monitoring" block, e.g. {"shm_segment": "/name", "interval_ms": 500}
+    const nlohmann::json& getMonitoringConfig() const;
+    // Optional "checkpoint" block, e.g. {"path": "run.ckpt", "interval_s": 60}
+    const nlohmann::json& getCheckpointConfig() const;
+    const ExecutionConfig& getExecutionConfig() const;
+    const OutputsConfig& getOutputsConfig() const;
+    const OverloadConfig& getOverloadConfig() const;
+    EdgeMode getEdgeMode() const;
 
     void setPipelineStages(const std::vector<StageConfig>& stages);
     void setLoggerConfig(const nlohmann::json& loggerJson);
     void setPluginLibraries(const std::vector<std::string>& libs);
+    void setInputConfig(const nlohmann::json& inputJson);
+    void setMonitoringConfig(const nlohmann::json& monitoringJson);
+    void setCheckpointConfig(const nlohmann::json& checkpointJson);
+    void setExecutionConfig(const ExecutionConfig& execution);
+    void setOutputsConfig(const OutputsConfig& outputs);
+    void setOverloadConfig(const OverloadConfig& overload);
+    void setEdgeMode(EdgeMode mode);
+
+    // Parses a Linux CPU list such as "0-3,8,10-11"
+    static bool parseCpuList(const std::string& text, std::vector<int>& cpus);
 
 private:
     ConfigParser parser_;
@@ -38,10 +139,22 @@ private:
     std::vector<StageConfig> pipelineStages_;
     nlohmann::json loggerConfig_;
     std::vector<std::string> pluginLibraries_;
+    nlohmann::json inputConfig_;
+    nlohmann::json monitoringConfig_;
+    nlohmann::json checkpointConfig_;
+    ExecutionConfig executionConfig_;
+    OutputsConfig outputsConfig_;
+    OverloadConfig overloadConfig_;
+    EdgeMode edgeMode_ = EdgeMode::Explicit;
 
     bool mergeJson(const nlohmann::json& newJson);
     bool buildFromMergedConfig();
     bool parsePipelineStages(const nlohmann::json& j);
+    bool parseExecution(const nlohmann::json& j);
+    bool parseArena(const nlohmann::json& j, ArenaConfig& arena);
+    bool parseOutputs(const nlohmann::json& j);
+    bool parseSchedule(const nlohmann::json& j, StageSchedule& schedule);
+    bool parseOverload(const nlohmann::json& j);
 };
 
 #endif // ANALYSISPIPELINE_CONFIGMANAGER_H
@@ -0,0 +1,106 @@
+#ifndef ANALYSISPIPELINE_CHECKPOINTER_H
+#define ANALYSISPIPELINE_CHECKPOINTER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// In-memory copy of the data products at an event boundary: the number of
+// events it covers and every product streamed with TBufferFile
+struct CheckpointSnapshot {
+    struct Product {
+        std::string name;
+        std::string className;
+        std::string payload;
+        // Set instead of payload by the pipeline, which hands over a copy of
+        // the object; the writer thread streams it into payload
+        std::function<bool(std::string& payload)> serialize;
+    };
+
+    uint64_t events = 0;
+    std::vector<Product> products;
+
+    size_t payloadBytes() const;
+};
+
+// Writes periodic checkpoints of the data products from a background thread.
+//
+// Every intervalSeconds the thread raises due(). The pipeline polls it at
+// event boundaries; when it is set, the pipeline lets the events in flight
+// finish, copies the product objects into a CheckpointSnapshot and hands it
+// to submit(), then carries on with the next event. Only that copy pauses the
+// graph: the thread streams the copies, writes the snapshot to "<path>.tmp",
+// syncs it and renames it over 'path', so a crash during a write leaves the
+// previous checkpoint in place. The next interval starts once the write has
+// finished.
+//
+// The file holds a single ProductWriter record whose event_index is the
+// number of events the checkpoint covers.
+class Checkpointer {
+public:
+    Checkpointer() = default;
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    // Stops a previous run first. intervalSeconds <= 0 only checkpoints on request().
+    bool start(const std::string& path, double intervalSeconds);
+    // Writes a submitted snapshot that is still pending and stops the thread
+    void stop();
+    bool enabled() const;
+
+    // Cheap; polled at every event boundary while enabled
+    bool due() const { return due_.load(std::memory_order_relaxed); }
+    // Raises due() without waiting for the interval
+    void request();
+    // Queues a snapshot for writing and clears due(); copyNs is how long the
+    // pipeline was paused to take it
+    void submit(CheckpointSnapshot snapshot, uint64_t copyNs);
+    // Waits until submitted snapshots are written; false if the last write failed
+    bool flush();
+
+    // {"path", "interval_s", "written", "failed", "last_events", "last_bytes",
+    //  "last_copy_ms", "last_write_ms"}
+    nlohmann::json toJson() const;
+
+    // Runs the serialize function of every product that has one; a product
+    // that fails to serialize is left out. Returns the number left out.
+    static size_t serializeProducts(CheckpointSnapshot& snapshot);
+    static bool writeFile(const std::string& path, const CheckpointSnapshot& snapshot);
+    static bool readFile(const std::string& path, CheckpointSnapshot& snapshot);
+
+private:
+    void writerLoop();
+
+    std::string path_;
+    std::chrono::nanoseconds interval_{0};
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread writer_;
+    std::optional<CheckpointSnapshot> pending_;
+    bool writing_ = false;
+    bool stop_ = false;
+    std::atomic<bool> due_{false};
+
+    // Guarded by mutex_
+    uint64_t written_ = 0;
+    uint64_t failed_ = 0;
+    bool lastFailed_ = false;
+    uint64_t lastEvents_ = 0;
+    uint64_t lastBytes_ = 0;
+    double lastCopyMs_ = 0.0;
+    double lastWriteMs_ = 0.0;
+};
+
+#endif // ANALYSISPIPELINE_CHECKPOINTER_H
@@ -0,0 +1,46 @@
+#ifndef ANALYSISPIPELINE_INPUTSOURCE_H
+#define ANALYSISPIPELINE_INPUTSOURCE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/core/context/input_bundle.h"
+
+// A stream of events for Pipeline::run(). next() is only ever called by one
+// thread at a time, but not necessarily always the same thread.
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    // Provides the next event; returns false at end of stream or on error
+    virtual bool next(std::shared_ptr<const InputBundle>& input) = 0;
+
+    virtual std::string describe() const = 0;
+
+    // Source-specific counters (events, bytes, queue depth, drops, ...)
+    virtual nlohmann::json statsToJson() const { return nlohmann::json::object(); }
+
+    // Events read ahead and waiting for the pipeline; cheap enough to call per event
+    virtual size_t queuedEvents() const { return 0; }
+
+    // True once the stream stopped on an error (truncated frame, read failure)
+    // rather than at a clean end; wrapping sources report their reader's state
+    virtual bool failed() const { return false; }
+
+    // Event bytes read so far
+    virtual uint64_t bytesRead() const { return 0; }
+};
+
+// Creates a source from an "input" config block:
+//   {"location": "file:/data/run01234.mid", "framing": "midas",
+//    "prefetch": {"depth": 64, "backpressure": "block"}}
+// "framing" defaults to "length_prefixed"; a prefetch depth of 0 reads on the
+// pipeline's admission path instead of a producer thread. "mmap:/path"
+// locations are memory-mapped and never prefetched. Returns nullptr
+// (after logging) on an invalid block.
+std::unique_ptr<InputSource> makeInputSource(const nlohmann::json& config);
+
+#endif // ANALYSISPIPELINE_INPUTSOURCE_H
@@ -0,0 +1,53 @@
+#ifndef ANALYSISPIPELINE_MAPPEDFILESOURCE_H
+#define ANALYSISPIPELINE_MAPPEDFILESOURCE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "analysis_pipeline/io/input_source.h"
+#include "analysis_pipeline/io/raw_event.h"
+
+// Replays framed events from a memory-mapped file. Every RawEvent points
+// straight into the mapping and shares ownership of it, so no event is read()
+// or copied; the mapping is released once the source and the last event
+// referencing it are gone. Location: "mmap:/path/run.mid".
+class MappedFileSource : public InputSource {
+public:
+    MappedFileSource(std::string path, EventFraming framing);
+    ~MappedFileSource() override = default;
+
+    MappedFileSource(const MappedFileSource&) = delete;
+    MappedFileSource& operator=(const MappedFileSource&) = delete;
+
+    // Maps the file; next() maps lazily if this was not called
+    bool open();
+
+    bool next(std::shared_ptr<const InputBundle>& input) override;
+    std::string describe() const override;
+    nlohmann::json statsToJson() const override;
+    bool failed() const override { return failed_.load(std::memory_order_relaxed); }
+    uint64_t bytesRead() const override { return bytes_.load(std::memory_order_relaxed); }
+
+    // Size of the mapped file in bytes (0 before open())
+    size_t fileBytes() const { return size_; }
+
+    // Frames larger than this are treated as corruption
+    void setMaxEventBytes(size_t bytes) { max_event_bytes_ = bytes; }
+
+private:
+    std::string path_;
+    EventFraming framing_;
+    std::shared_ptr<const void> mapping_;
+    const std::byte* base_ = nullptr;
+    size_t size_ = 0;
+    size_t offset_ = 0;
+    std::atomic<bool> failed_{false};
+    size_t max_event_bytes_ = size_t(1) << 30;
+
+    std::atomic<uint64_t> events_{0};
+    std::atomic<uint64_t> bytes_{0};
+};
+
+#endif // ANALYSISPIPELINE_MAPPEDFILESOURCE_H
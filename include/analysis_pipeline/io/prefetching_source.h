@@ -0,0 +1,67 @@
+#ifndef ANALYSISPIPELINE_PREFETCHINGSOURCE_H
+#define ANALYSISPIPELINE_PREFETCHINGSOURCE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "analysis_pipeline/io/input_source.h"
+#include "analysis_pipeline/io/spsc_ring.h"
+
+// What the producer does when the queue is full
+enum class BackpressurePolicy {
+    Block,  // wait for the pipeline to catch up; no event is lost
+    Drop    // discard the event just read and count it; the reader never stalls
+};
+
+std::optional<BackpressurePolicy> parseBackpressurePolicy(const std::string& name);
+
+// Runs an upstream source on a dedicated producer thread and hands its events
+// to the pipeline through a bounded lock-free SPSC queue, so that reading and
+// unpacking overlap with processing. The producer starts on the first next()
+// (or start()) and is stopped and joined on destruction.
+class PrefetchingSource : public InputSource {
+public:
+    PrefetchingSource(std::unique_ptr<InputSource> upstream, size_t depth = 64,
+                      BackpressurePolicy policy = BackpressurePolicy::Block);
+    ~PrefetchingSource() override;
+
+    PrefetchingSource(const PrefetchingSource&) = delete;
+    PrefetchingSource& operator=(const PrefetchingSource&) = delete;
+
+    void start();
+    void stop();
+
+    bool next(std::shared_ptr<const InputBundle>& input) override;
+    std::string describe() const override;
+    nlohmann::json statsToJson() const override;
+    size_t queuedEvents() const override { return queue_.size(); }
+    bool failed() const override { return upstream_->failed(); }
+    uint64_t bytesRead() const override { return upstream_->bytesRead(); }
+
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void produce();
+
+    std::unique_ptr<InputSource> upstream_;
+    BackpressurePolicy policy_;
+    SpscRing<std::shared_ptr<const InputBundle>> queue_;
+
+    std::thread producer_;
+    std::atomic<bool> started_{false};
+    std::atomic<bool> stopRequested_{false};
+    std::atomic<bool> producerDone_{false};
+
+    std::atomic<uint64_t> produced_{0};
+    std::atomic<uint64_t> consumed_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> producerStalls_{0};   // pushes that found the queue full
+    std::atomic<uint64_t> consumerStarved_{0};  // pops that found the queue empty
+    std::atomic<size_t> highWater_{0};
+};
+
+#endif // ANALYSISPIPELINE_PREFETCHINGSOURCE_H
@@ -0,0 +1,66 @@
+#ifndef ANALYSISPIPELINE_PRODUCTOUTPUTSTAGE_H
+#define ANALYSISPIPELINE_PRODUCTOUTPUTSTAGE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <TBufferFile.h>
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/core/stages/base_stage.h"
+#include "analysis_pipeline/io/product_writer.h"
+#include "analysis_pipeline/pipeline/product_dependencies.h"
+
+// Built-in sink that streams data products to a binary file (see
+// ProductWriter for the layout). Place it downstream of the stages whose
+// products it writes:
+//   {"id": "writer", "type": "ProductOutputStage",
+//    "parameters": {"path": "out/run.bin", "products": ["random_hist"],
+//                   "buffer_bytes": 4194304},
+//    "next": []}
+// Without "products" every product present at that point is written.
+// Products missing for an event (e.g. from an inactive branch) are skipped.
+// With derived edges the listed products make it depend on their writers;
+// list them explicitly in that mode.
+// With "defer_open": true the file is left closed after Init() until
+// openOutput() is called. Pipelines built in the background for a reload use
+// it, so they do not truncate a file the running pipeline is writing.
+class ProductOutputStage : public BaseStage, public ProductAccessStage {
+public:
+    explicit ProductOutputStage(const nlohmann::json& params);
+    ~ProductOutputStage() override;
+
+    void Process() override;
+    std::string Name() const override;
+
+    std::vector<std::string> InputProducts() const override;
+    std::vector<std::string> OutputProducts() const override;
+
+    nlohmann::json statsToJson() const;
+
+    const std::string& path() const { return path_; }
+    bool isOutputOpen() const { return writer_->isOpen(); }
+    // Opens the file if it is not open yet. With 'append' the records follow
+    // the existing ones and event indices start at firstEventIndex.
+    bool openOutput(bool append = false, uint64_t firstEventIndex = 0);
+    // Writes out buffered records and closes the file; returns the index the
+    // next event would have had
+    uint64_t closeOutput();
+
+protected:
+    void OnInit() override;
+
+private:
+    std::string path_;
+    std::vector<std::string> products_;
+    bool allProducts_;
+    bool deferOpen_;
+    std::unique_ptr<ProductWriter> writer_;
+    TBufferFile buffer_{TBuffer::kWrite};
+    uint64_t eventIndex_ = 0;
+    uint64_t missing_ = 0;
+};
+
+#endif // ANALYSISPIPELINE_PRODUCTOUTPUTSTAGE_H
@@ -0,0 +1,84 @@
+#ifndef ANALYSISPIPELINE_PRODUCTWRITER_H
+#define ANALYSISPIPELINE_PRODUCTWRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// Appends binary event records to a file from a background thread.
+//
+// Record layout (little-endian), one per event:
+//   uint32 record_bytes        bytes that follow this field
+//   uint64 event_index
+//   uint32 product_count
+//   product_count times:
+//     uint16 name_length,  name
+//     uint16 class_length, class name
+//     uint32 payload_length, payload (ROOT streamer bytes from TBufferFile)
+//
+// Because every record carries its own length the output can be read back
+// with StreamEventSource and EventFraming::LengthPrefixed.
+//
+// Records are assembled in a front buffer by the (single) producing thread.
+// Once it holds bufferBytes the buffers are swapped and the writer thread
+// drains the back buffer to disk, so the producer only waits when the disk
+// falls a whole buffer behind.
+class ProductWriter {
+public:
+    explicit ProductWriter(size_t bufferBytes = 4 << 20);
+    ~ProductWriter();
+
+    ProductWriter(const ProductWriter&) = delete;
+    ProductWriter& operator=(const ProductWriter&) = delete;
+
+    // Truncates the file unless 'append' is set
+    bool open(const std::string& path, bool append = false);
+    // Writes out everything buffered and stops the writer thread
+    bool close();
+    bool isOpen() const { return fd_ >= 0; }
+
+    void beginEvent(uint64_t eventIndex);
+    void addProduct(const std::string& name, const std::string& className,
+                    const char* payload, size_t size);
+    void endEvent();
+
+    // Hands the front buffer to the writer thread without waiting for the write
+    void flush();
+
+    nlohmann::json statsToJson() const;
+
+private:
+    void writerLoop();
+    void swapBuffers();
+    void append(const void* data, size_t size);
+    template <typename T> void appendValue(T value) { append(&value, sizeof(value)); }
+
+    std::string path_;
+    int fd_ = -1;
+    size_t bufferBytes_;
+
+    std::vector<char> front_;
+    std::vector<char> back_;
+    size_t recordStart_ = 0;
+    uint32_t recordProducts_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool backFull_ = false;
+    bool stop_ = false;
+    std::thread writer_;
+
+    std::atomic<bool> writeFailed_{false};
+    std::atomic<uint64_t> events_{0};
+    std::atomic<uint64_t> bytesWritten_{0};
+    std::atomic<uint64_t> producerWaits_{0};
+};
+
+#endif // ANALYSISPIPELINE_PRODUCTWRITER_H
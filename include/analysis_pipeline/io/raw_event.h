@@ -0,0 +1,46 @@
+#ifndef ANALYSISPIPELINE_RAWEVENT_H
+#define ANALYSISPIPELINE_RAWEVENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "analysis_pipeline/core/context/input_bundle.h"
+
+// Undecoded event bytes as read by an input source. 'data' points into
+// 'storage' (a heap buffer, a memory mapping, ...), which keeps the bytes
+// alive for as long as any copy of the RawEvent exists. Copies are cheap and
+// never duplicate the bytes.
+struct RawEvent {
+    uint64_t index = 0;
+    const std::byte* data = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const void> storage;
+};
+
+// How events are delimited in a byte stream
+enum class EventFraming {
+    // uint32 little-endian payload size followed by the payload
+    LengthPrefixed,
+    // MIDAS event: 16-byte header (event_id, trigger_mask, serial_number,
+    // time_stamp, data_size) followed by data_size bytes. The RawEvent covers
+    // header and data so it can be handed to a MIDAS decoder unchanged.
+    Midas
+};
+
+std::optional<EventFraming> parseEventFraming(const std::string& name);
+
+// Header size and total frame size for a frame starting at 'header', which
+// must hold at least frameHeaderSize() bytes
+size_t frameHeaderSize(EventFraming framing);
+size_t frameTotalSize(EventFraming framing, const std::byte* header);
+// Offset of the bytes exposed as RawEvent::data relative to the frame start
+size_t framePayloadOffset(EventFraming framing);
+
+// Wraps a raw event in an input bundle; input stages read it back with
+// input.get<RawEvent>()
+std::shared_ptr<const InputBundle> makeRawEventBundle(RawEvent event);
+
+#endif // ANALYSISPIPELINE_RAWEVENT_H
@@ -0,0 +1,80 @@
+#ifndef ANALYSISPIPELINE_SPSCRING_H
+#define ANALYSISPIPELINE_SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+
+// Bounded lock-free single-producer/single-consumer ring. Capacity is rounded
+// up to a power of two. Head and tail live on separate cache lines and each
+// side keeps a cached copy of the other's index so the common case touches
+// only its own line.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : capacity_(roundUp(capacity)), mask_(capacity_ - 1),
+          slots_(std::make_unique<std::optional<T>[]>(capacity_)) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return capacity_; }
+
+    // Producer side
+    bool tryPush(T&& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ == capacity_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ == capacity_) {
+                return false;
+            }
+        }
+        slots_[tail & mask_].emplace(std::move(value));
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool tryPop(T& out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) {
+                return false;
+            }
+        }
+        std::optional<T>& slot = slots_[head & mask_];
+        out = std::move(*slot);
+        slot.reset();
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently with push/pop
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    static size_t roundUp(size_t n) {
+        size_t c = 1;
+        while (c < n) {
+            c <<= 1;
+        }
+        return c;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<std::optional<T>[]> slots_;
+
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cachedTail_ = 0;  // consumer-owned
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cachedHead_ = 0;  // producer-owned
+};
+
+#endif // ANALYSISPIPELINE_SPSCRING_H
@@ -0,0 +1,60 @@
+#ifndef ANALYSISPIPELINE_STREAMEVENTSOURCE_H
+#define ANALYSISPIPELINE_STREAMEVENTSOURCE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "analysis_pipeline/io/input_source.h"
+#include "analysis_pipeline/io/raw_event.h"
+
+// Reads framed events from a file descriptor. The location selects the
+// transport:
+//   "file:/path/run.mid" or "/path/run.mid"   regular file
+//   "pipe:-" or "-"                           standard input
+//   "pipe:/path/fifo"                         named pipe
+//   "unix:/path/socket"                       connected unix stream socket
+// Each event is read into its own buffer, which the produced RawEvent owns.
+class StreamEventSource : public InputSource {
+public:
+    StreamEventSource(std::string location, EventFraming framing);
+    ~StreamEventSource() override;
+
+    StreamEventSource(const StreamEventSource&) = delete;
+    StreamEventSource& operator=(const StreamEventSource&) = delete;
+
+    // Opens the location; next() opens lazily if this was not called
+    bool open();
+    void close();
+
+    // Reads the next frame; false at a clean end of stream or on error
+    bool readEvent(RawEvent& event);
+
+    bool next(std::shared_ptr<const InputBundle>& input) override;
+    std::string describe() const override;
+    nlohmann::json statsToJson() const override;
+    bool failed() const override { return failed_.load(std::memory_order_relaxed); }
+    uint64_t bytesRead() const override { return bytes_.load(std::memory_order_relaxed); }
+
+    // Frames larger than this are treated as corruption
+    void setMaxEventBytes(size_t bytes) { max_event_bytes_ = bytes; }
+
+private:
+    // Returns bytes read; less than 'size' only at end of stream or on error
+    size_t readFully(std::byte* out, size_t size);
+
+    std::string location_;
+    EventFraming framing_;
+    int fd_ = -1;
+    bool owns_fd_ = false;
+    std::atomic<bool> failed_{false};
+    size_t max_event_bytes_ = size_t(1) << 30;
+
+    std::vector<std::byte> header_;
+
+    std::atomic<uint64_t> events_{0};
+    std::atomic<uint64_t> bytes_{0};
+};
+
+#endif // ANALYSISPIPELINE_STREAMEVENTSOURCE_H
@@ -0,0 +1,86 @@
+#ifndef ANALYSISPIPELINE_EVENTARENA_H
+#define ANALYSISPIPELINE_EVENTARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// Bump allocator for memory that lives exactly as long as one event.
+//
+// Allocation is a lock-free pointer bump; deallocation is a no-op and reset()
+// releases everything at once. Chunks are kept across resets, and when an
+// event overflowed into extra chunks they are coalesced into one chunk of the
+// high-water size, so steady-state events never touch the heap.
+//
+// Stages running for the same event may allocate concurrently. reset() must
+// only be called at an event boundary, when no stage uses the arena.
+class EventArena : public std::pmr::memory_resource {
+public:
+    explicit EventArena(size_t initialBytes = 1 << 20);
+    ~EventArena() override = default;
+
+    EventArena(const EventArena&) = delete;
+    EventArena& operator=(const EventArena&) = delete;
+
+    void reset();
+
+    size_t bytesInUse() const;
+    size_t capacityBytes() const;
+    size_t highWaterBytes() const;
+    uint64_t resetCount() const;
+    uint64_t overflowCount() const;
+    nlohmann::json statsToJson() const;
+
+    // Arena of the event whose stage is running on this thread, or nullptr.
+    // Set by the pipeline around every stage call:
+    //   std::pmr::vector<double> hits(EventArena::current());
+    static EventArena* current();
+
+    // Installs an arena as current() for the lifetime of the scope
+    class Scope {
+    public:
+        explicit Scope(EventArena* arena);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        EventArena* previous_;
+    };
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+    struct Chunk {
+        explicit Chunk(size_t bytes);
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+        std::atomic<size_t> used{0};
+    };
+
+    void advance(Chunk* exhausted, size_t minimumBytes);
+    // Callers hold growMutex_
+    size_t bytesInUseLocked() const;
+    size_t capacityBytesLocked() const;
+
+    // chunks_ may grow while stages allocate; it is only touched under growMutex_
+    std::vector<std::unique_ptr<Chunk>> chunks_;
+    std::atomic<Chunk*> current_{nullptr};
+    size_t currentIndex_ = 0; // guarded by growMutex_
+    mutable std::mutex growMutex_;
+
+    size_t highWaterBytes_ = 0; // guarded by growMutex_
+    uint64_t resets_ = 0;       // guarded by growMutex_
+    std::atomic<uint64_t> overflows_{0};
+};
+
+#endif // ANALYSISPIPELINE_EVENTARENA_H
@@ -0,0 +1,108 @@
+#ifndef ANALYSISPIPELINE_OBJECTPOOL_H
+#define ANALYSISPIPELINE_OBJECTPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include <nlohmann/json.hpp>
+#include <tbb/concurrent_queue.h>
+
+// Recycles objects of one type instead of freeing and reallocating them every
+// event. acquire() hands out a pooled object (or constructs a new one) whose
+// deleter returns it to the pool; an optional recycler restores a clean state
+// before reuse (e.g. TH1::Reset, vector::clear keeps capacity).
+//
+// The pool must outlive every object it handed out. acquire() and returns are
+// thread-safe.
+template <typename T>
+class ObjectPool {
+public:
+    using Factory = std::function<T*()>;
+    using Recycler = std::function<void(T&)>;
+
+    class Releaser {
+    public:
+        Releaser() = default;
+        explicit Releaser(ObjectPool* pool) : pool_(pool) {}
+        void operator()(T* object) const {
+            if (pool_) {
+                pool_->release(object);
+            } else {
+                delete object;
+            }
+        }
+
+    private:
+        ObjectPool* pool_ = nullptr;
+    };
+
+    using Handle = std::unique_ptr<T, Releaser>;
+
+    explicit ObjectPool(Factory factory = [] { return new T(); }, Recycler recycler = nullptr)
+        : factory_(std::move(factory)), recycler_(std::move(recycler)) {}
+
+    ~ObjectPool() {
+        T* object = nullptr;
+        while (free_.try_pop(object)) {
+            delete object;
+        }
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    Handle acquire() {
+        T* object = nullptr;
+        if (free_.try_pop(object)) {
+            reused_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            object = factory_();
+            created_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        const uint64_t out = outstanding_.fetch_add(1, std::memory_order_relaxed) + 1;
+        uint64_t high = highWater_.load(std::memory_order_relaxed);
+        while (out > high && !highWater_.compare_exchange_weak(high, out, std::memory_order_relaxed)) {
+        }
+        return Handle(object, Releaser(this));
+    }
+
+    // Pre-populates the pool so the first events do not allocate
+    void reserve(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            free_.push(factory_());
+            created_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    nlohmann::json statsToJson() const {
+        nlohmann::json j;
+        j["created"] = created_.load(std::memory_order_relaxed);
+        j["reused"] = reused_.load(std::memory_order_relaxed);
+        j["outstanding"] = outstanding_.load(std::memory_order_relaxed);
+        j["high_water"] = highWater_.load(std::memory_order_relaxed);
+        return j;
+    }
+
+private:
+    void release(T* object) {
+        if (recycler_) {
+            recycler_(*object);
+        }
+        outstanding_.fetch_sub(1, std::memory_order_relaxed);
+        free_.push(object);
+    }
+
+    Factory factory_;
+    Recycler recycler_;
+    tbb::concurrent_queue<T*> free_;
+
+    std::atomic<uint64_t> created_{0};
+    std::atomic<uint64_t> reused_{0};
+    std::atomic<uint64_t> outstanding_{0};
+    std::atomic<uint64_t> highWater_{0};
+};
+
+#endif // ANALYSISPIPELINE_OBJECTPOOL_H
@@ -0,0 +1,134 @@
+#ifndef ANALYSISPIPELINE_METRICSSEGMENT_H
+#define ANALYSISPIPELINE_METRICSSEGMENT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Pipeline counters as published to, and read back from, a metrics segment
+struct MetricsSample {
+    struct Stage {
+        std::string id;
+        uint64_t calls = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs = 0;
+        uint64_t queueWaitNs = 0;
+        uint64_t rejected = 0;
+    };
+
+    uint64_t pid = 0;
+    // Wall clock (system_clock ns since epoch), so readers can tell a stale segment
+    uint64_t startNs = 0;
+    uint64_t updateNs = 0;
+    uint64_t updates = 0;
+
+    uint64_t events = 0;
+    uint64_t inFlight = 0;
+    uint64_t maxInFlight = 0;
+
+    uint64_t inputEvents = 0;
+    uint64_t inputBytes = 0;
+    uint64_t inputQueued = 0;
+    uint64_t inputHighWater = 0;
+    uint64_t inputDropped = 0;
+
+    std::vector<Stage> stages;
+};
+
+// POSIX shared-memory segment ("/name") holding the latest MetricsSample.
+//
+// The segment is an array of lock-free 64-bit atomics: a header (magic,
+// version, capacity) followed by a seqlock sequence and the payload. The
+// single writer makes the sequence odd, stores the payload and makes it even
+// again; readers copy the payload and retry if the sequence was odd or
+// changed meanwhile. Neither side ever blocks the other, and a reader that
+// crashes or stalls cannot affect the pipeline.
+class MetricsSegmentWriter {
+public:
+    MetricsSegmentWriter() = default;
+    ~MetricsSegmentWriter();
+
+    MetricsSegmentWriter(const MetricsSegmentWriter&) = delete;
+    MetricsSegmentWriter& operator=(const MetricsSegmentWriter&) = delete;
+
+    // Creates the segment, replacing a stale one of the same name. Stage ids
+    // longer than MetricsSegmentLayout::kStageIdBytes - 1 are truncated.
+    bool create(const std::string& name, size_t stageCapacity);
+    // Unmaps and unlinks the segment
+    void close();
+    bool isOpen() const { return words_ != nullptr; }
+    const std::string& name() const { return name_; }
+
+    // Stages beyond the capacity are left out
+    void publish(const MetricsSample& sample);
+
+private:
+    std::string name_;
+    std::atomic<uint64_t>* words_ = nullptr;
+    size_t wordCount_ = 0;
+    size_t stageCapacity_ = 0;
+};
+
+class MetricsSegmentReader {
+public:
+    MetricsSegmentReader() = default;
+    ~MetricsSegmentReader();
+
+    MetricsSegmentReader(const MetricsSegmentReader&) = delete;
+    MetricsSegmentReader& operator=(const MetricsSegmentReader&) = delete;
+
+    // Maps an existing segment read-only; fails if it is missing, not yet
+    // initialized or of another layout version
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return words_ != nullptr; }
+
+    // Consistent copy of the latest sample; false if the writer kept
+    // updating through every retry
+    bool read(MetricsSample& sample, int maxRetries = 1000) const;
+
+private:
+    const std::atomic<uint64_t>* words_ = nullptr;
+    size_t wordCount_ = 0;
+    size_t stageCapacity_ = 0;
+};
+
+// Word offsets of the segment, shared by writer and reader
+namespace MetricsSegmentLayout {
+
+constexpr uint64_t kMagic = 0x4150'4d45'5452'4943ULL;  // "APMETRIC"
+constexpr uint64_t kVersion = 1;
+constexpr size_t kStageIdBytes = 64;
+
+// Header
+constexpr size_t kMagicWord = 0;
+constexpr size_t kVersionWord = 1;
+constexpr size_t kCapacityWord = 2;
+constexpr size_t kSequenceWord = 3;
+constexpr size_t kHeaderWords = 4;
+
+// Fixed payload, relative to kHeaderWords
+enum Field : size_t {
+    kPid, kStartNs, kUpdateNs, kUpdates,
+    kEvents, kInFlight, kMaxInFlight,
+    kInputEvents, kInputBytes, kInputQueued, kInputHighWater, kInputDropped,
+    kStageCount,
+    kFieldCount
+};
+
+// Per stage: the id packed into words, then the counters
+constexpr size_t kStageIdWords = kStageIdBytes / sizeof(uint64_t);
+enum StageField : size_t {
+    kCalls = kStageIdWords, kTotalNs, kMaxNs, kQueueWaitNs, kRejected,
+    kStageWords
+};
+
+constexpr size_t wordCount(size_t stageCapacity) {
+    return kHeaderWords + kFieldCount + stageCapacity * kStageWords;
+}
+
+} // namespace MetricsSegmentLayout
+
+#endif // ANALYSISPIPELINE_METRICSSEGMENT_H
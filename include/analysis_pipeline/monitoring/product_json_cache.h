@@ -0,0 +1,82 @@
+#ifndef ANALYSISPIPELINE_PRODUCTJSONCACHE_H
+#define ANALYSISPIPELINE_PRODUCTJSONCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/core/data/pipeline_data_product_manager.h"
+
+// Serialized-JSON cache with per-product change tracking.
+//
+// Products written by stages are registered with track(); after a stage runs
+// the pipeline bumps the write generation of each product it declared with
+// markWritten(), which is a single relaxed increment. A cached serialization
+// is reused while its generation matches. Products nobody declared are
+// re-serialized on every call.
+//
+// Generations only follow declarations: the product manager does not report
+// writes, so a stage that writes a tracked product without declaring it does
+// not bump the generation and the cached JSON goes stale. Every stage that
+// writes a product must declare it (an explicit "writes" list covers
+// products not named by the usual parameters).
+class ProductJsonCache {
+public:
+    ProductJsonCache() = default;
+    ProductJsonCache(const ProductJsonCache&) = delete;
+    ProductJsonCache& operator=(const ProductJsonCache&) = delete;
+
+    // Drops tracking and cached documents
+    void clear();
+
+    // Registers a tracked product and returns its slot (stable per name).
+    // All track() calls must precede finalizeTracking().
+    size_t track(const std::string& name);
+    void finalizeTracking();
+
+    void markWritten(size_t slot) {
+        generations_[slot].fetch_add(1, std::memory_order_release);
+    }
+
+    // {"changed": {name: json}, "removed": [names]} relative to the previous
+    // serializeDelta() call; the first call reports every product
+    nlohmann::json serializeDelta(PipelineDataProductManager& manager);
+
+    // Same document as PipelineDataProductManager::serializeAll(), built from
+    // the cache for unchanged tracked products
+    nlohmann::json serializeAll(PipelineDataProductManager& manager);
+
+    nlohmann::json statsToJson() const;
+
+private:
+    struct Entry {
+        nlohmann::json value;
+        uint64_t cachedGeneration = 0;
+        bool cached = false;
+        // State as of the last delta
+        bool reported = false;
+        uint64_t reportedGeneration = 0;
+        nlohmann::json reportedValue;  // untracked products only
+    };
+
+    // Current write generation of a tracked product; false if untracked
+    bool generationOf(const std::string& name, uint64_t& generation) const;
+    const nlohmann::json& refresh(PipelineDataProductManager& manager, const std::string& name,
+                                  Entry& entry, bool tracked, uint64_t generation);
+
+    std::map<std::string, size_t> slots_;
+    std::unique_ptr<std::atomic<uint64_t>[]> generations_;
+
+    mutable std::mutex mutex_;  // guards entries_ and the counters below
+    std::unordered_map<std::string, Entry> entries_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+};
+
+#endif // ANALYSISPIPELINE_PRODUCTJSONCACHE_H
@@ -0,0 +1,68 @@
+#ifndef ANALYSISPIPELINE_STAGEMETRICS_H
+#define ANALYSISPIPELINE_STAGEMETRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <nlohmann/json.hpp>
+#include <tbb/enumerable_thread_specific.h>
+
+// Per-stage call counters and latency histogram.
+//
+// Every thread accumulates into its own cache-line aligned record, written
+// only by that thread, so record() takes no locks and does not share lines.
+// snapshot() merges the per-thread records and may run concurrently with
+// record(); the result is then approximate by at most the in-progress calls.
+class StageMetrics {
+public:
+    // Bucket b holds durations in [2^b, 2^(b+1)) nanoseconds
+    static constexpr size_t kHistogramBuckets = 48;
+
+    struct Snapshot {
+        uint64_t calls = 0;
+        uint64_t totalNs = 0;
+        uint64_t minNs = 0;
+        uint64_t maxNs = 0;
+        uint64_t totalQueueNs = 0;
+        uint64_t maxQueueNs = 0;
+        // Events a FilterStage routed to none of its successors
+        uint64_t rejected = 0;
+        std::array<uint64_t, kHistogramBuckets> histogram{};
+
+        // Estimated latency at quantile q in [0, 1], interpolated within a bucket
+        double percentileNs(double q) const;
+        nlohmann::json toJson() const;
+    };
+
+    StageMetrics() = default;
+    StageMetrics(const StageMetrics&) = delete;
+    StageMetrics& operator=(const StageMetrics&) = delete;
+
+    void record(uint64_t durationNs, uint64_t queueWaitNs);
+    void recordRejected();
+
+    Snapshot snapshot() const;
+
+    // Not safe while the stage is executing
+    void reset();
+
+    // Monotonic clock used by all pipeline instrumentation
+    static uint64_t nowNs();
+
+private:
+    struct alignas(64) Local {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> totalNs{0};
+        std::atomic<uint64_t> minNs{UINT64_MAX};
+        std::atomic<uint64_t> maxNs{0};
+        std::atomic<uint64_t> totalQueueNs{0};
+        std::atomic<uint64_t> maxQueueNs{0};
+        std::atomic<uint64_t> rejected{0};
+        std::array<std::atomic<uint64_t>, kHistogramBuckets> histogram{};
+    };
+
+    tbb::enumerable_thread_specific<Local> locals_;
+};
+
+#endif // ANALYSISPIPELINE_STAGEMETRICS_H
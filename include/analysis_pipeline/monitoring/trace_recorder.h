@@ -0,0 +1,53 @@
+#ifndef ANALYSISPIPELINE_TRACERECORDER_H
+#define ANALYSISPIPELINE_TRACERECORDER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <tbb/enumerable_thread_specific.h>
+
+// Records stage executions for a window of events and writes them in the
+// Chrome trace-event format (chrome://tracing, Perfetto). Each thread appends
+// to its own buffer; write() must only be called while no events run.
+class TraceRecorder {
+public:
+    TraceRecorder() = default;
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // Records events with index in [firstEvent, firstEvent + eventCount)
+    void start(uint64_t firstEvent, uint64_t eventCount);
+    void clear();
+
+    bool isRecording(uint64_t eventIndex) const {
+        return eventIndex >= windowBegin_.load(std::memory_order_relaxed) &&
+               eventIndex < windowEnd_.load(std::memory_order_relaxed);
+    }
+
+    void record(size_t stageIndex, uint64_t eventIndex, uint64_t startNs, uint64_t durationNs);
+
+    // stageNames maps stage indices to the names shown in the trace
+    bool write(const std::string& path, const std::vector<std::string>& stageNames) const;
+
+private:
+    struct Entry {
+        size_t stage;
+        uint64_t event;
+        uint64_t startNs;
+        uint64_t durationNs;
+    };
+
+    struct ThreadBuffer {
+        ThreadBuffer();
+        int threadId;
+        std::vector<Entry> entries;
+    };
+
+    tbb::enumerable_thread_specific<ThreadBuffer> buffers_;
+    std::atomic<uint64_t> windowBegin_{0};
+    std::atomic<uint64_t> windowEnd_{0};
+};
+
+#endif // ANALYSISPIPELINE_TRACERECORDER_H
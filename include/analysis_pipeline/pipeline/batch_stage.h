@@ -0,0 +1,24 @@
+#ifndef ANALYSISPIPELINE_BATCHSTAGE_H
+#define ANALYSISPIPELINE_BATCHSTAGE_H
+
+#include <vector>
+
+#include "analysis_pipeline/core/context/input_bundle.h"
+
+// Optional mix-in for stages that can handle a whole batch of events in one
+// call. Inherit it alongside BaseStage (BaseStage first):
+//
+//   class MyStage : public BaseStage, public BatchStage { ... };
+//
+// When every stage of a pipeline implements it, Pipeline::executeBatch()
+// makes a single pass over the graph calling ProcessBatch() instead of one
+// Process() per event. Input stages receive the events through 'inputs';
+// other stages get the same batch for bookkeeping and may ignore it.
+class BatchStage {
+public:
+    virtual ~BatchStage() = default;
+
+    virtual void ProcessBatch(const std::vector<InputBundle>& inputs) = 0;
+};
+
+#endif // ANALYSISPIPELINE_BATCHSTAGE_H
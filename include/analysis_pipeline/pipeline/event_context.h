@@ -0,0 +1,24 @@
+#ifndef ANALYSISPIPELINE_EVENTCONTEXT_H
+#define ANALYSISPIPELINE_EVENTCONTEXT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "analysis_pipeline/core/context/input_bundle.h"
+
+// Per-event state carried through the pipelined executor
+struct EventContext {
+    uint64_t sequence = 0;
+    // Executor slot holding this event; stable while the event is in flight
+    size_t slot = 0;
+    // Shared, immutable event input; never copied per input stage
+    std::shared_ptr<const InputBundle> input;
+    // Per-stage activation, indexed like the topology and owned by the
+    // executor slot. Start stages begin active; a stage activates the
+    // successors it routes the event to, and inactive stages are skipped.
+    std::atomic<bool>* activeStages = nullptr;
+};
+
+#endif // ANALYSISPIPELINE_EVENTCONTEXT_H
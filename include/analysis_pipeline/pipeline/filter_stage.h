@@ -0,0 +1,64 @@
+#ifndef ANALYSISPIPELINE_FILTERSTAGE_H
+#define ANALYSISPIPELINE_FILTERSTAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Routing decision of a FilterStage for the event it just processed
+struct StageVerdict {
+    // Bit k routes the event to the k-th successor, in the order of the
+    // stage's "next" list. With derived or merged edges that is the list
+    // after rewriting (see ProductDependencies::derive): the config's own
+    // entries first (merged), then derived successors in config order.
+    // select() by id does not depend on the order.
+    uint64_t branchMask = ~uint64_t{0};
+    // Successor ids to route to in addition to branchMask; ids that are not
+    // successors of the stage are ignored
+    std::vector<std::string> selected;
+
+    static StageVerdict accept() { return StageVerdict(); }
+
+    static StageVerdict reject() {
+        StageVerdict verdict;
+        verdict.branchMask = 0;
+        return verdict;
+    }
+
+    static StageVerdict branch(size_t position) {
+        StageVerdict verdict;
+        verdict.branchMask = position < 64 ? uint64_t{1} << position : 0;
+        return verdict;
+    }
+
+    static StageVerdict select(std::vector<std::string> nextIds) {
+        StageVerdict verdict;
+        verdict.branchMask = 0;
+        verdict.selected = std::move(nextIds);
+        return verdict;
+    }
+};
+
+// Optional mix-in for stages that decide which part of the graph an event
+// continues through. Inherit it alongside BaseStage (BaseStage first):
+//
+//   class TriggerCut : public BaseStage, public FilterStage { ... };
+//
+// Verdict() is called right after each Process(), for the same event. A
+// stage runs only if at least one of its predecessors routed the event to
+// it; start stages always run. With derived or merged edges, an edge into a
+// stage does not count where a filter lies on another path to it: a stage
+// reading both the filter's product and an upstream product runs only when
+// the filter routes to it (see StageTopology::activationEdges). Skipped stages do not route the event any
+// further, but still complete their graph edges, so joins fed by a branch
+// that is still active run as usual. Products of skipped stages keep their
+// values from the last event that ran them.
+class FilterStage {
+public:
+    virtual ~FilterStage() = default;
+
+    virtual StageVerdict Verdict() = 0;
+};
+
+#endif // ANALYSISPIPELINE_FILTERSTAGE_H
@@ -0,0 +1,78 @@
+#ifndef ANALYSISPIPELINE_LOADSHEDDER_H
+#define ANALYSISPIPELINE_LOADSHEDDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/config/config_manager.h"
+
+// Decides when optional stages are skipped to keep up with the input.
+//
+// Two mechanisms, both from the "overload" config block:
+//   - Latency budget: an optional stage that becomes runnable more than
+//     latency_budget_ms after its event was admitted is skipped for it.
+//   - Overload mode: entered when the input queue reaches queue_high or an
+//     event retires over budget. Every event admitted during overload skips
+//     all optional stages. It ends once the queue is back to queue_low and
+//     no event has retired late for hold_ms.
+// Essential stages always run. Admission and retirement are serialized by
+// the caller among themselves but may run concurrently with each other.
+class LoadShedder {
+public:
+    LoadShedder() = default;
+
+    LoadShedder(const LoadShedder&) = delete;
+    LoadShedder& operator=(const LoadShedder&) = delete;
+
+    // stageIds names the per-stage shed counters
+    void configure(const OverloadConfig& config, std::vector<std::string> stageIds);
+    void clear();
+    bool enabled() const { return enabled_; }
+
+    // Whether the event being admitted runs degraded (optional stages off)
+    bool admit(size_t queuedEvents, uint64_t nowNs);
+    void retired(uint64_t admitNs, uint64_t nowNs);
+
+    // Whether an optional stage becoming runnable at nowNs is skipped
+    bool shouldShed(bool degraded, uint64_t admitNs, uint64_t nowNs) const {
+        return degraded || (budgetNs_ != 0 && nowNs - admitNs > budgetNs_);
+    }
+    void recordShed(size_t stageIndex);
+
+    bool overloaded() const { return overloaded_.load(std::memory_order_relaxed); }
+
+    // {"overloaded", "overload_entries", "overload_ms", "degraded_events",
+    //  "late_events", "shed": {stage id: skipped runs}}
+    nlohmann::json toJson() const;
+    void resetCounters();
+
+private:
+    void enter(uint64_t nowNs);
+    void leave(uint64_t nowNs);
+
+    bool enabled_ = false;
+    uint64_t budgetNs_ = 0;
+    size_t queueHigh_ = 0;
+    size_t queueLow_ = 0;
+    uint64_t holdNs_ = 0;
+
+    std::atomic<bool> overloaded_{false};
+    std::atomic<uint64_t> overloadSinceNs_{0};
+    std::atomic<uint64_t> lastLateNs_{0};
+
+    std::atomic<uint64_t> overloadEntries_{0};
+    std::atomic<uint64_t> overloadNs_{0};
+    std::atomic<uint64_t> degradedEvents_{0};
+    std::atomic<uint64_t> lateEvents_{0};
+
+    std::vector<std::string> stageIds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> shed_;
+};
+
+#endif // ANALYSISPIPELINE_LOADSHEDDER_H
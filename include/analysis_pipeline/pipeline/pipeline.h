@@ -7,6 +7,11 @@
 #include <vector>
 #include <optional>
 #include <any>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
 #include <tbb/flow_graph.h>
 
 #include "analysis_pipeline/config/config_manager.h"
@@ -14,15 +19,184 @@
 #include "analysis_pipeline/core/stages/input/base_input_stage.h"
 #include "analysis_pipeline/core/data/pipeline_data_product_manager.h"
 #include "analysis_pipeline/core/context/input_bundle.h"
+#include "analysis_pipeline/pipeline/stage_topology.h"
+#include "analysis_pipeline/pipeline/pipelined_executor.h"
+#include "analysis_pipeline/pipeline/batch_stage.h"
+#include "analysis_pipeline/pipeline/shared_input_stage.h"
+#include "analysis_pipeline/pipeline/filter_stage.h"
+#include "analysis_pipeline/pipeline/task_arenas.h"
+#include "analysis_pipeline/pipeline/product_dependencies.h"
+#include "analysis_pipeline/pipeline/product_table.h"
+#include "analysis_pipeline/pipeline/stage_demand.h"
+#include "analysis_pipeline/pipeline/stage_scheduler.h"
+#include "analysis_pipeline/pipeline/load_shedder.h"
+#include "analysis_pipeline/monitoring/stage_metrics.h"
+#include "analysis_pipeline/monitoring/trace_recorder.h"
+#include "analysis_pipeline/monitoring/product_json_cache.h"
+#include "analysis_pipeline/monitoring/metrics_segment.h"
+#include "analysis_pipeline/memory/event_arena.h"
+#include "analysis_pipeline/io/input_source.h"
+#include "analysis_pipeline/io/checkpointer.h"
+
+class TClass;
 
 class Pipeline {
 public:
+    // Creates an uninitialized stage from its config parameters; the pipeline
+    // calls Init() on the result as for dictionary-created stages
+    using StageFactory = std::function<BaseStage*(const nlohmann::json& params)>;
+
     explicit Pipeline(std::shared_ptr<ConfigManager> configManager);
+    ~Pipeline();
+
+    // Registers a factory for stage types that are not available through the
+    // ROOT dictionary (benchmarks, tests, statically linked stages). Registered
+    // factories take precedence over TClass lookup for the same type name.
+    static void registerStageFactory(const std::string& type, StageFactory factory);
+    static void unregisterStageFactory(const std::string& type);
 
     bool buildFromConfig();
 
+    // Construct and Init() the stages of each topological level concurrently
+    // in buildFromConfig() (default off). Only used when the graph branches,
+    // so ROOT thread safety is needed for execution anyway, and never with
+    // setEnableThreadSafetyIfNeeded(false).
+    void setParallelStageInit(bool enable);
+    // Build ProductOutputStage stages with their files closed (default off);
+    // openOutputFiles() opens them. Used for pipelines built while another
+    // one is still writing the same files.
+    void setDeferOutputFiles(bool defer);
+    // Closes the files of the ProductOutputStage stages and returns, per
+    // path, the index the next event would have been written with
+    std::map<std::string, uint64_t> closeOutputFiles();
+    // Opens the files left closed by setDeferOutputFiles(true); files listed
+    // in 'continued' are appended to, continuing their event indices
+    bool openOutputFiles(const std::map<std::string, uint64_t>& continued = {});
+    // Timing of the last buildFromConfig(): {"total_ms", "stages_ms",
+    // "parallel_init", "plugins": [{path, ms, loaded}], "stages": {id: {type, construct_ms, init_ms}}}
+    const nlohmann::json& getStartupReport() const;
+
     void execute();
 
+    // Pipelined (streaming) execution: events are pulled from nextInput until
+    // it returns false, with up to getMaxEventsInFlight() of them traversing
+    // the graph concurrently. Input is handed to input stages right before they
+    // process each event, so setInputData() is not used in this mode.
+    // source, if given, is what nextInput reads from: load shedding watches
+    // its read-ahead queue and the metrics segment samples its counters
+    // while the stream runs.
+    // Returns the number of events processed.
+    uint64_t executeStream(const PipelinedExecutor::InputSupplier& nextInput, InputSource* source = nullptr);
+
+    // Runs a batch of events with a single synchronization at the end. If
+    // every stage implements BatchStage, none is a FilterStage and there is
+    // no demand selector, the graph is traversed once with ProcessBatch();
+    // otherwise events are streamed through executeStream().
+    // Streamed events share one owning copy of the batch, which the rvalue
+    // overload moves instead of copying.
+    // Returns the number of events processed.
+    uint64_t executeBatch(const std::vector<InputBundle>& inputs);
+    uint64_t executeBatch(std::vector<InputBundle>&& inputs);
+
+    // Streams every event of 'source' (at most maxEvents unless 0) through
+    // executeStream(), then calls finishRun()
+    uint64_t run(InputSource& source, uint64_t maxEvents = 0);
+    // Runs the source set with setInputSource(), creating it from the
+    // config's "input" block on first use if none was set
+    uint64_t run();
+    void setInputSource(std::unique_ptr<InputSource> source);
+    InputSource* getInputSource() const;
+
+    // Stages with a "schedule" ({"every_events": N}, {"every_seconds": T},
+    // {"end_of_run": true}) are not run per event. When they come due, the
+    // stream drains, the products they read are copied, and they run on the
+    // copies in the low-priority background arena while events flow again.
+    // With "blocking": true they run on the live products before the next
+    // event is admitted (see StageScheduler). Only sink stages can be
+    // scheduled. finishRun() waits for them and runs the end-of-run stages;
+    // call it after executeStream() or execute() loops. getScheduleStats()
+    // reports runs, failures, skipped turns and how long each stage held the
+    // stream.
+    void finishRun();
+    nlohmann::json getScheduleStats() const;
+
+    void setMaxEventsInFlight(size_t maxEventsInFlight);
+    size_t getMaxEventsInFlight() const;
+
+    // Per-stage instrumentation (enabled by default). getStageMetrics() returns
+    // {"events": N, "stages": {id: {calls, total/min/max/percentiles, queue wait, rejected}}};
+    // calls below "events" count the events a stage was skipped for
+    void setProfilingEnabled(bool enabled);
+    bool isProfilingEnabled() const;
+    nlohmann::json getStageMetrics() const;
+    void resetStageMetrics();
+
+    // Load shedding from the config's "overload" block (see LoadShedder):
+    // stages with "criticality": "optional" are skipped for late events and
+    // while overloaded, like stages a filter rejected. Essential stages may
+    // not depend on optional ones. Counters are cleared by resetStageMetrics().
+    nlohmann::json getLoadSheddingStats() const;
+
+    // Records every stage execution of the next eventCount events; write the
+    // result with writeTrace() once they have been processed.
+    void startTrace(uint64_t eventCount);
+    bool writeTrace(const std::string& path) const;
+
+    // Publishes live counters (events, in flight, per-stage calls and time,
+    // input queue depth and drops) to the POSIX shared-memory segment 'name'
+    // every intervalMs. A background thread samples the per-thread stage
+    // counters, so processing threads do no extra work and never wait on a
+    // reader. Watch it with analysis_pipeline_monitor. The config's
+    // "monitoring": {"shm_segment": "/name", "interval_ms": 500} does the same.
+    // The segment is recreated by buildFromConfig() and removed when stopped.
+    bool startMetricsSegment(const std::string& name, unsigned intervalMs = 500);
+    void stopMetricsSegment();
+    // The sample the publisher writes; safe to call while events are processed
+    MetricsSample sampleMetrics() const;
+
+    // Periodic checkpoints of the data products (see Checkpointer). When one
+    // is due, the stream stops admitting events, the events in flight finish,
+    // the products are copied into memory and admission resumes; a background
+    // thread writes the copy to 'path'. execute() checkpoints after the event.
+    // The config's "checkpoint": {"path": "...", "interval_s": 60} does the
+    // same from buildFromConfig(). checkpointNow() takes one at the next event
+    // boundary; stopCheckpointing() takes a final one when asked to and waits
+    // for it to be written. Call it between events.
+    bool startCheckpointing(const std::string& path, double intervalSeconds);
+    void stopCheckpointing(bool finalCheckpoint = true);
+    void checkpointNow();
+    nlohmann::json getCheckpointStats() const;
+    // Replaces products with the ones stored in a checkpoint (tags of existing
+    // products are kept) and continues event numbering after it. Call after
+    // buildFromConfig() and before processing events.
+    bool restoreCheckpoint(const std::string& path);
+
+    // Per-event memory arena. While enabled, EventArena::current() returns the
+    // arena of the event a stage is processing; it is reset in O(1) when the
+    // next event reuses it, so stages can allocate scratch data and per-event
+    // containers without heap churn. Stats report high-water marks per arena.
+    void setEventArenaEnabled(bool enabled, size_t initialBytes = 1 << 20);
+    bool isEventArenaEnabled() const;
+    nlohmann::json getEventArenaStats() const;
+
+    // Collapse single-in/single-out runs of stages into one graph node that
+    // calls each Process() back to back (default on). Takes effect on the
+    // next buildFromConfig(); stage ids, logging and metrics stay per stage.
+    void setFuseLinearChains(bool enable);
+    // Stage ids grouped by graph node, in execution order within each node
+    std::vector<std::vector<std::string>> getFusedChains() const;
+
+    // Incremental JSON for monitoring. A product is tracked when a stage
+    // declares it as an output in its parameters ("product_name",
+    // "output_product", "histogram_name", "output_products" or "writes");
+    // tracked products are only re-serialized after that stage has run.
+    // serializeDelta() returns {"events": N, "changed": {...}, "removed": [...]}
+    // relative to its previous call; serializeAllCached() returns the same
+    // document as serializeAll().
+    nlohmann::json serializeDelta();
+    nlohmann::json serializeAllCached();
+    nlohmann::json getSerializationCacheStats() const;
+
     std::shared_ptr<ConfigManager> getConfigManager() const;
     void setConfigManager(std::shared_ptr<ConfigManager> configManager);
 
@@ -31,19 +205,166 @@ public:
 
     // Generic input injection method
     void setInputData(const InputBundle& input);
+    // Zero-copy injection: stages implementing SharedInputStage all receive
+    // the same immutable bundle; others fall back to SetInput(*input)
+    void setInputData(std::shared_ptr<const InputBundle> input);
+    void setInputData(InputBundle&& input);
 
     // Setter for conditional ROOT thread safety enabling
     void setEnableThreadSafetyIfNeeded(bool enable);
 
+    // Stage edges of the last build with the products behind them, and the
+    // critical path: by stage count, plus "estimated_ns" from measured mean
+    // latencies once events have been processed
+    nlohmann::json getDependencyReport() const;
+
+    // Handles of all declared products, valid until the next buildFromConfig()
+    ProductTable& getProductTable();
+    // Products a stage declares it reads and writes (parameters and
+    // ProductAccessStage); nullptr for an unknown stage id
+    const StageProducts* getStageProducts(const std::string& stageId) const;
+
+    // Arenas from the config's "execution" block, recreated by buildFromConfig()
+    nlohmann::json getExecutionInfo() const;
+
+    // Builds only what these products and sink stages need: the stages named,
+    // the writers of the products and everything upstream of them. Replaces
+    // the config's "outputs" block for the next buildFromConfig(); both lists
+    // empty builds every stage. Unknown names fail the build.
+    void setRequestedOutputs(std::vector<std::string> products, std::vector<std::string> stages = {});
+    // Stage ids the last buildFromConfig() left out
+    const std::vector<std::string>& getPrunedStages() const;
+
+    // Per-event demand. demandFor() resolves outputs against the built graph
+    // (nullptr if a name is unknown); the selector picks the demand for each
+    // event from its input, and stages outside it are skipped like stages a
+    // filter rejected. A null demand runs every stage. The selector is called
+    // while admitting events (input is nullptr for execute()), so keep it cheap.
+    // Demands are invalidated by buildFromConfig().
+    using DemandSelector = std::function<const StageDemand*(const InputBundle* input)>;
+    std::shared_ptr<const StageDemand> demandFor(const std::vector<std::string>& products,
+                                                 const std::vector<std::string>& stages = {}) const;
+    void setDemandSelector(DemandSelector selector);
+
 private:
-    tbb::flow::graph graph_;
+    // Declared before graph_ so the arenas outlive the graph attached to them
+    TaskArenas taskArenas_;
+    // Created inside the pipeline arena so graph tasks are spawned there
+    std::unique_ptr<tbb::flow::graph> graph_;
+    // Keyed by the id of the first stage of each (possibly fused) chain
     std::map<std::string, std::unique_ptr<tbb::flow::continue_node<tbb::flow::continue_msg>>> nodes_;
     std::map<std::string, int> incomingCount_;
     std::vector<std::string> startNodes_;
     std::map<std::string, std::unique_ptr<BaseStage>> stages_;
 
+    // Index-based view of the graph (config order), used by the pipelined executor
+    StageTopology topology_;
+    ProductDependencies dependencies_;
+    // Indexed like stageByIndex_
+    std::vector<StageProducts> stageProducts_;
+    std::vector<BaseStage*> stageByIndex_;
+    std::vector<BaseInputStage*> inputStageByIndex_;
+    std::vector<BatchStage*> batchStageByIndex_;
+    std::vector<SharedInputStage*> sharedInputStageByIndex_;
+    std::vector<FilterStage*> filterStageByIndex_;
+    // Per stage and successor: whether routing the event there activates it
+    // (StageTopology::activationEdges; all set with explicit edges)
+    std::vector<std::vector<uint8_t>> activatesByIndex_;
+    // Dedicated arena per stage, nullptr for stages that run in the pipeline arena
+    std::vector<tbb::task_arena*> stageArenaByIndex_;
+    bool allStagesBatchCapable_ = false;
+
+    // Stage activation for the event traversing graph_ (see FilterStage)
+    std::unique_ptr<std::atomic<bool>[]> graphActiveStages_;
+
+    // Build-time output pruning; unset uses the config's "outputs" block
+    std::optional<OutputsConfig> requestedOutputs_;
+    std::vector<std::string> prunedStages_;
+    // Per-event demand: graphDemand_ for execute(), slotDemand_ per executor slot
+    DemandSelector demandSelector_;
+    const StageDemand* graphDemand_ = nullptr;
+    std::vector<const StageDemand*> slotDemand_;
+
+    // Stages run by scheduler_ rather than per event, indexed like stageByIndex_
+    std::vector<uint8_t> scheduledByIndex_;
+    // Products of non-blocking scheduled stages, which run on copies while
+    // events flow; nullptr for the other stages
+    std::vector<std::unique_ptr<PipelineDataProductManager>> scheduledProducts_;
+    StageScheduler scheduler_;
+
+    // Load shedding; admission time and overload verdict per executor slot,
+    // graph* for execute()
+    std::vector<uint8_t> optionalByIndex_;
+    LoadShedder loadShedder_;
+    std::vector<uint64_t> slotAdmitNs_;
+    std::vector<uint8_t> slotDegraded_;
+    uint64_t graphAdmitNs_ = 0;
+    bool graphDegraded_ = false;
+
+    // Instrumentation, indexed like stageByIndex_
+    bool profilingEnabled_ = true;
+    std::vector<std::unique_ptr<StageMetrics>> stageMetrics_;
+    std::unique_ptr<std::atomic<uint64_t>[]> stageFinishNs_;
+    uint64_t graphStartNs_ = 0;
+    std::atomic<uint64_t> eventCounter_{0};
+    uint64_t currentGraphEvent_ = 0;
+    uint64_t streamBaseEvent_ = 0;
+    TraceRecorder trace_;
+
+    // Change tracking for serializeDelta(); slots per stage, indexed like stageByIndex_
+    ProductJsonCache productJsonCache_;
+    std::vector<std::vector<size_t>> stageOutputSlots_;
+
+    // Handle-indexed products of the events in flight; per stage, the
+    // subscribed products it publishes after running, and those of them it
+    // publishes as a copy owned by the event's slot while streaming
+    ProductTable productTable_;
+    std::vector<std::vector<ProductHandle>> stageOutputHandles_;
+    std::vector<std::vector<ProductHandle>> stageCopiedHandles_;
+    // Indexed by slot * productTable_.size() + handle
+    std::vector<std::unique_ptr<TObject>> slotProductCopies_;
+    // Per stage, the stages past its direct successors that read its products by name
+    std::vector<std::vector<size_t>> indirectReaders_;
+
+    // One arena per executor slot; index 0 also serves execute()/executeBatch()
+    bool eventArenaEnabled_ = false;
+    size_t eventArenaInitialBytes_ = 1 << 20;
+    std::vector<std::unique_ptr<EventArena>> eventArenas_;
+
+    // Set while executeBatch() drives the graph in batch mode
+    const std::vector<InputBundle>* currentBatch_ = nullptr;
+
+    bool fuseLinearChains_ = true;
+    std::vector<std::vector<size_t>> fusedChains_;
+
+    size_t maxEventsInFlight_ = 4;
+    std::unique_ptr<PipelinedExecutor> executor_;
+
+    std::unique_ptr<InputSource> inputSource_;
+
+    // Shared-memory metrics publisher (see startMetricsSegment())
+    std::string metricsSegmentName_;
+    unsigned metricsIntervalMs_ = 500;
+    MetricsSegmentWriter metricsSegment_;
+    std::thread metricsThread_;
+    std::mutex metricsThreadMutex_;
+    std::condition_variable metricsWake_;
+    bool metricsStop_ = false;
+    // Guards activeSource_ and stage metric resets against a concurrent sample
+    mutable std::mutex monitorMutex_;
+    InputSource* activeSource_ = nullptr;
+    // Source of the running stream for the admit hook; set by executeStream()
+    // before the executor starts and cleared after it returns
+    InputSource* streamSource_ = nullptr;
+    // Set while executor_ is running, so its progress can be sampled
+    std::atomic<bool> streaming_{false};
+
+    Checkpointer checkpointer_;
+
     // Collection of input stages (BaseInputStage*)
     std::vector<BaseInputStage*> input_stages_;
+    // Same order as input_stages_; nullptr when the stage only supports SetInput()
+    std::vector<SharedInputStage*> shared_input_stages_;
 
     std::shared_ptr<ConfigManager> configManager_;
 
@@ -51,12 +372,52 @@ private:
 
     // Controls whether to enable ROOT::EnableThreadSafety() based on parallelism detection
     bool enable_thread_safety_if_needed_ = true;
+    bool parallelismDetected_ = false;
+
+    static std::mutex stageFactoriesMutex_;
+    static std::map<std::string, StageFactory> stageFactories_;
+    // TClass lookups by type name, kept across rebuilds
+    static std::mutex stageClassCacheMutex_;
+    static std::unordered_map<std::string, TClass*> stageClassCache_;
 
-    BaseStage* createStageInstance(const std::string& type, const nlohmann::json& params);
+    struct StageStartupTiming {
+        uint64_t constructNs = 0;
+        uint64_t initNs = 0;
+    };
+    bool parallelStageInit_ = false;
+    bool deferOutputFiles_ = false;
+    nlohmann::json startupReport_ = nlohmann::json::object();
+
+    static TClass* findStageClass(const std::string& type);
+    // Initializes the stage with 'products', or with dataProductManager_ if null
+    BaseStage* createStageInstance(const std::string& type, const nlohmann::json& params,
+                                   StageStartupTiming* timing = nullptr,
+                                   PipelineDataProductManager* products = nullptr);
     void configureLogger(const nlohmann::json& loggerConfig);
 
     void registerInputStage(BaseInputStage* stage);
 
+    void buildGraphNodes();
+    // Streams a batch whose events share ownership of it
+    uint64_t streamBatch(std::shared_ptr<const std::vector<InputBundle>> batch);
+    void ensureEventArenas(size_t count);
+    void runGraphStage(size_t stageIndex);
+    template <typename F>
+    void runInStageArena(size_t stageIndex, F&& process);
+    void runStreamingStage(size_t stageIndex, const EventContext& event, uint64_t readyNs);
+    void runScheduledStage(size_t stageIndex, uint64_t eventIndex, uint64_t readyNs);
+    // Copies the products a non-blocking scheduled stage reads into its manager
+    void prepareScheduledStage(size_t stageIndex);
+    bool shedStage(size_t stageIndex, bool degraded, uint64_t admitNs);
+    void markStageOutputs(size_t stageIndex);
+    void publishStageOutputs(size_t stageIndex, uint64_t sequence, size_t slot, bool copy);
+    void routeEvent(size_t stageIndex, std::atomic<bool>* activeStages, const StageDemand* demand);
+    void recordStageTiming(size_t stageIndex, uint64_t eventIndex, uint64_t readyNs, uint64_t startNs);
+    bool startMetricsPublisher();
+    void stopMetricsPublisher();
+    // Copies the products for checkpointer_; only called between events
+    void takeCheckpoint();
+
     // Internal helper to enable ROOT thread safety if conditions are met
     void enableRootThreadSafetyIfNeeded();
 };
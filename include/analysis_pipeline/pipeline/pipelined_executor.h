@@ -0,0 +1,121 @@
+#ifndef ANALYSISPIPELINE_PIPELINEDEXECUTOR_H
+#define ANALYSISPIPELINE_PIPELINEDEXECUTOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <tbb/task_group.h>
+
+#include "analysis_pipeline/pipeline/event_context.h"
+#include "analysis_pipeline/pipeline/stage_topology.h"
+
+// Runs several events through the stage DAG at once.
+//
+// Stage S may run event N once:
+//   - every predecessor of S has finished event N (data dependency),
+//   - S itself has finished event N-1 (stages are never re-entered),
+//   - every reader of S has finished event N-1. Products live in the single
+//     shared product manager, so S may only overwrite its products for N-1
+//     once the stages reading them are done. Readers are the direct
+//     successors of S plus the stages given with setIndirectReaders().
+// Stages further downstream do not hold S back: on a chain A -> B -> C, A
+// runs event N+1 while C runs event N.
+// A stage that is not active for event N (see EventContext::activeStages) is
+// settled inline without spawning a task once it would otherwise be runnable.
+// Events are pulled from the supplier in order and at most maxInFlight are
+// active at a time; a new event is admitted whenever the oldest one retires.
+class PipelinedExecutor {
+public:
+    // readyNs is the StageMetrics::nowNs() time at which the stage became runnable
+    using StageFunction = std::function<void(size_t stageIndex, const EventContext& event, uint64_t readyNs)>;
+    // Provides the next event's input; returns false once the stream is exhausted
+    using InputSupplier = std::function<bool(std::shared_ptr<const InputBundle>& input)>;
+    // Called for every admitted event before any of its stages runs
+    using AdmitHook = std::function<void(const EventContext& event)>;
+    // Called for every event once it and all earlier events have finished,
+    // in sequence order, while retirement is serialized; keep it short
+    using RetireHook = std::function<void(const EventContext& event)>;
+
+    PipelinedExecutor(const StageTopology& topology, size_t maxInFlight, StageFunction stageFunction);
+    ~PipelinedExecutor() = default;
+
+    PipelinedExecutor(const PipelinedExecutor&) = delete;
+    PipelinedExecutor& operator=(const PipelinedExecutor&) = delete;
+
+    // Processes events until the supplier is exhausted. The calling thread
+    // takes part in executing stages. Rethrows the first stage exception after
+    // in-flight events have drained; no new events are admitted after an error.
+    // Returns the number of events admitted.
+    uint64_t run(const InputSupplier& nextInput);
+
+    size_t maxInFlight() const;
+    // Number of distinct EventContext::slot values
+    size_t slotCount() const;
+
+    // Per stage, the stages beyond its direct successors that read its
+    // products for an event, e.g. by name from further downstream. The stage
+    // does not start an event before they have finished the previous one.
+    // Call before run().
+    void setIndirectReaders(const std::vector<std::vector<size_t>>& readers);
+
+    void setAdmitHook(AdmitHook hook);
+    void setRetireHook(RetireHook hook);
+
+    // Progress of the current run(), 0 between runs; safe to call from any thread
+    uint64_t admittedCount() const;
+    uint64_t retiredCount() const;
+
+private:
+    struct Slot {
+        EventContext event;
+        std::unique_ptr<std::atomic<int>[]> pending;
+        std::unique_ptr<std::atomic<bool>[]> active;
+        std::atomic<size_t> remaining{0};
+        bool finished = false; // guarded by completionMutex_, reset on retirement
+    };
+
+    Slot& slotFor(uint64_t sequence);
+    void prepareSlot(uint64_t sequence);
+    void admitAvailable();
+    void release(uint64_t sequence, size_t stageIndex);
+    void runStage(uint64_t sequence, size_t stageIndex, uint64_t readyNs);
+    void completeStage(uint64_t sequence, size_t stageIndex);
+    void finishEvent(uint64_t sequence);
+
+    const StageTopology& topology_;
+    const size_t maxInFlight_;
+    StageFunction stageFunction_;
+    // Per stage, the readers it waits for and, inversely, the writers whose
+    // next event it releases
+    std::vector<std::vector<size_t>> readers_;
+    std::vector<std::vector<size_t>> writers_;
+    AdmitHook admitHook_;
+    RetireHook retireHook_;
+
+    // One extra slot so the next event's counters exist before it is admitted
+    std::vector<Slot> slots_;
+
+    tbb::task_group tasks_;
+
+    // Admission: supplier access and sequence numbering
+    std::mutex admissionMutex_;
+    const InputSupplier* supplier_ = nullptr;
+    uint64_t nextSequence_ = 0;
+    bool exhausted_ = false;
+    // Mirror of nextSequence_ for lock-free progress reads
+    std::atomic<uint64_t> admitted_{0};
+
+    // Retirement: oldest event that has not finished yet
+    std::mutex completionMutex_;
+    std::atomic<uint64_t> oldestActive_{0};
+
+    std::mutex errorMutex_;
+    std::exception_ptr firstError_;
+};
+
+#endif // ANALYSISPIPELINE_PIPELINEDEXECUTOR_H
@@ -0,0 +1,74 @@
+#ifndef ANALYSISPIPELINE_PRODUCTDEPENDENCIES_H
+#define ANALYSISPIPELINE_PRODUCTDEPENDENCIES_H
+
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/config/config_manager.h"
+
+// Data products a stage reads and writes
+struct StageProducts {
+    std::vector<std::string> reads;
+    std::vector<std::string> writes;
+};
+
+// Products declared in a stage's parameters. Writes: "product_name",
+// "output_product", "histogram_name", "output_products", "writes".
+// Reads: "input_product", "input_products", "reads".
+StageProducts declaredProducts(const nlohmann::json& params);
+
+// Same, plus the reads built-in stages take from other parameters
+// (ProductOutputStage: "products"). Known before the stage is constructed,
+// so demand can be resolved without building every stage.
+StageProducts declaredProducts(const StageConfig& stage);
+
+// Optional mix-in for stages that know their products better than their
+// parameters do. Inherit it alongside BaseStage (BaseStage first). The
+// lists are queried once after Init() and merged with the declared ones.
+class ProductAccessStage {
+public:
+    virtual ~ProductAccessStage() = default;
+
+    virtual std::vector<std::string> InputProducts() const = 0;
+    virtual std::vector<std::string> OutputProducts() const = 0;
+};
+
+// Derives stage edges from product reads and writes and checks the result.
+//
+// Every reader of a product depends on its writer. Edges that are implied
+// transitively are kept too, so a stage's 'next' lists every reader of its
+// products.
+class ProductDependencies {
+public:
+    ProductDependencies() = default;
+
+    // Rewrites every stage's 'next' for the given mode. Fails on products
+    // with several writers (derived/merged modes) and on cycles (any mode).
+    bool derive(std::vector<StageConfig>& stages, const std::vector<StageProducts>& products, EdgeMode mode);
+    void clear();
+
+    // Longest chain of stages, weighted by stageCostNs (1 per stage when empty)
+    std::vector<size_t> criticalPath(const std::function<double(size_t)>& stageCostNs = {}) const;
+
+    // {"mode", "edges": [{from, to, products}], "unproduced_inputs",
+    //  "critical_path": {"stages", "length", "estimated_ns"?}}
+    nlohmann::json toJson(const std::function<double(size_t)>& stageCostNs = {}) const;
+
+private:
+    EdgeMode mode_ = EdgeMode::Explicit;
+    std::vector<std::string> ids_;
+    std::vector<std::vector<size_t>> successors_;
+    // Topological order of the final graph
+    std::vector<size_t> order_;
+    // Products carried by each derived edge; explicit-only edges have none
+    std::map<std::pair<size_t, size_t>, std::vector<std::string>> edgeProducts_;
+    std::vector<std::string> unproducedInputs_;
+};
+
+#endif // ANALYSISPIPELINE_PRODUCTDEPENDENCIES_H
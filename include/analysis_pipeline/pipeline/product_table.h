@@ -0,0 +1,120 @@
+#ifndef ANALYSISPIPELINE_PRODUCTTABLE_H
+#define ANALYSISPIPELINE_PRODUCTTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class TObject;
+
+// Dense integer id of a data product, resolved once at build time
+using ProductHandle = uint32_t;
+constexpr ProductHandle kInvalidProductHandle = UINT32_MAX;
+
+// Handle-indexed view of the products published for the events in flight.
+//
+// buildFromConfig() assigns a handle to every declared product. Stages that
+// implement ProductHandleStage subscribe to the products they read. After the
+// writer of a subscribed product has run, the pipeline looks the product up in
+// the product manager once and publishes its object under the event's
+// sequence number, in the entry of the executor slot (EventContext::slot) the
+// event occupies. Readers then fetch it with get(handle). That is an indexed
+// load with no string hashing and no lock. It returns nullptr unless the
+// product was published for the event being processed (writer skipped, not
+// yet run, or not declared), in which case the reader falls back to the
+// product manager.
+//
+// A writer only waits for its direct successors before it starts the next
+// event. When a subscriber sits further downstream, the pipeline publishes a
+// copy of the product owned by the event's slot instead of the manager's
+// object, so the reader keeps its event's product while the writer moves on.
+// A slot is reused only after its event has retired.
+class ProductTable {
+public:
+    ProductTable() = default;
+    ProductTable(const ProductTable&) = delete;
+    ProductTable& operator=(const ProductTable&) = delete;
+
+    // Build time only
+    void clear();
+    ProductHandle resolve(const std::string& name);
+    void finalize();
+    // Number of events that can be published at once, one per executor slot;
+    // drops everything published so far
+    void setSlotCount(size_t slotCount);
+    size_t slotCount() const;
+
+    // Handle of a product and marks it as read by handle; invalid if unknown
+    ProductHandle subscribe(const std::string& name);
+    // Handles subscribed since the last call, so the caller can tell which stage subscribed them
+    std::vector<ProductHandle> takeSubscriptions();
+    ProductHandle find(const std::string& name) const;
+    bool isSubscribed(ProductHandle handle) const;
+    const std::string& name(ProductHandle handle) const;
+    size_t size() const;
+
+    void publish(ProductHandle handle, const TObject* object, uint64_t sequence, size_t slot = 0);
+
+    // Object published for the event whose stage runs on this thread
+    const TObject* get(ProductHandle handle) const;
+    const TObject* get(ProductHandle handle, uint64_t sequence, size_t slot = 0) const;
+
+    template <typename T>
+    const T* getAs(ProductHandle handle) const {
+        return dynamic_cast<const T*>(get(handle));
+    }
+
+    // Event sequence and slot of the stage running on this thread; set by the pipeline
+    class Scope {
+    public:
+        explicit Scope(uint64_t sequence, size_t slot = 0);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        uint64_t previousSequence_;
+        size_t previousSlot_;
+    };
+
+private:
+    static constexpr uint64_t kNoEvent = UINT64_MAX;
+
+    // Sequence-tagged pointer; readers check the tag before and after the load,
+    // which guards callers of get(handle, sequence, slot) outside a stage
+    struct alignas(64) Entry {
+        std::atomic<uint64_t> sequence{kNoEvent};
+        std::atomic<const TObject*> object{nullptr};
+    };
+
+    std::unordered_map<std::string, ProductHandle> handles_;
+    std::vector<std::string> names_;
+    std::vector<bool> subscribed_;
+    std::vector<ProductHandle> recentSubscriptions_;
+    // Indexed by slot * size() + handle
+    size_t slotCount_ = 0;
+    std::unique_ptr<Entry[]> entries_;
+};
+
+// Optional mix-in for stages that read products by handle. Inherit it
+// alongside BaseStage (BaseStage first). BindProducts() is called once per
+// build, after Init(), to subscribe:
+//
+//   void BindProducts(ProductTable& table) override {
+//       table_ = &table;
+//       hitsHandle_ = table.subscribe("hits");
+//   }
+//   ...
+//   if (const auto* hits = table_->getAs<TClonesArray>(hitsHandle_)) { ... }
+class ProductHandleStage {
+public:
+    virtual ~ProductHandleStage() = default;
+
+    virtual void BindProducts(ProductTable& table) = 0;
+};
+
+#endif // ANALYSISPIPELINE_PRODUCTTABLE_H
@@ -0,0 +1,108 @@
+#ifndef ANALYSISPIPELINE_RELOADABLEPIPELINE_H
+#define ANALYSISPIPELINE_RELOADABLEPIPELINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/config/config_manager.h"
+#include "analysis_pipeline/io/input_source.h"
+#include "analysis_pipeline/pipeline/pipeline.h"
+
+// A Pipeline whose configuration can be replaced without stopping processing.
+//
+// requestRebuild() loads the new config and runs buildFromConfig() for it on
+// a background thread (plugin loading, stage construction and Init()) while
+// the current pipeline keeps processing events. Once the new pipeline is
+// ready, executeStream() stops admitting events to the old one, lets its
+// in-flight events finish, and continues with the new one from the next
+// event. No event is lost or processed twice, and the gap is only the drain
+// of the events that were in flight.
+//
+// With carry-over enabled, the products written by stages whose id and type
+// are unchanged are moved into the new pipeline's product manager, so
+// accumulated results (histograms, counters) continue across the swap.
+// Internal stage state is not carried over. The old pipeline's run ends at
+// the swap, so its end-of-run stages run then. The logger config is only
+// applied by the initial build.
+class ReloadablePipeline {
+public:
+    // Called right after a swap, before the new pipeline processes an event.
+    // 'retired' is destroyed on a background thread afterwards.
+    using SwapCallback = std::function<void(Pipeline& retired, Pipeline& active)>;
+
+    explicit ReloadablePipeline(std::shared_ptr<ConfigManager> configManager);
+    ~ReloadablePipeline();
+
+    ReloadablePipeline(const ReloadablePipeline&) = delete;
+    ReloadablePipeline& operator=(const ReloadablePipeline&) = delete;
+
+    // Initial, blocking build
+    bool buildFromConfig();
+
+    // Starts building a pipeline from 'configManager' (or from the config
+    // files) in the background. Returns false if a rebuild is already under
+    // way or there is no active pipeline yet.
+    bool requestRebuild(std::shared_ptr<ConfigManager> configManager, bool carryOverProducts = true);
+    bool requestRebuild(std::vector<std::string> configPaths, bool carryOverProducts = true);
+
+    // True once a rebuilt pipeline is waiting to be swapped in
+    bool isSwapReady() const;
+    bool isRebuildInProgress() const;
+    // Swaps in a ready pipeline; only call between events (not during
+    // executeStream(), which swaps by itself). Returns true if it swapped.
+    bool swapIfReady();
+
+    // Like Pipeline::executeStream(), swapping in rebuilt pipelines at event
+    // boundaries while the stream runs. Each generation sees source.
+    uint64_t executeStream(const PipelinedExecutor::InputSupplier& nextInput, InputSource* source = nullptr);
+    uint64_t run(InputSource& source);
+    // One event through the active pipeline, after swapping if ready
+    void execute();
+
+    // The active pipeline; replaced by swaps
+    Pipeline& active();
+    void setSwapCallback(SwapCallback callback);
+
+    // {"generation", "swaps", "failed_builds", "rebuilding", "swap_ready",
+    //  "last_build_ms", "last_drain_ms", "last_carried_products": [...]}
+    nlohmann::json getStats() const;
+
+private:
+    void startBuild(std::function<std::shared_ptr<ConfigManager>()> loadConfig, bool carryOverProducts);
+    // Returns the retired pipeline
+    std::unique_ptr<Pipeline> swapLocked();
+    void carryOverProducts(Pipeline& from, Pipeline& to, std::vector<std::string>& carried);
+    void retire(std::unique_ptr<Pipeline> pipeline);
+
+    std::shared_ptr<ConfigManager> configManager_;
+    std::unique_ptr<Pipeline> active_;
+
+    // Background build; pending_ is handed over by swapIfReady()
+    mutable std::mutex mutex_;
+    std::thread builder_;
+    std::thread retirer_;
+    std::unique_ptr<Pipeline> pending_;
+    std::shared_ptr<ConfigManager> pendingConfig_;
+    bool pendingCarryOver_ = true;
+    std::atomic<bool> building_{false};
+    std::atomic<bool> swapReady_{false};
+
+    SwapCallback swapCallback_;
+
+    uint64_t generation_ = 0;
+    uint64_t swaps_ = 0;
+    uint64_t failedBuilds_ = 0;
+    double lastBuildMs_ = 0.0;
+    double lastDrainMs_ = 0.0;
+    std::vector<std::string> lastCarried_;
+};
+
+#endif // ANALYSISPIPELINE_RELOADABLEPIPELINE_H
@@ -0,0 +1,91 @@
+#ifndef ANALYSISPIPELINE_SHARDEDPIPELINE_H
+#define ANALYSISPIPELINE_SHARDEDPIPELINE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/config/config_manager.h"
+#include "analysis_pipeline/io/input_source.h"
+#include "analysis_pipeline/pipeline/pipeline.h"
+
+class TObject;
+
+// Event-sharded execution over N independent replicas of the stage graph.
+//
+// Every replica is a full Pipeline with its own stage instances and product
+// manager. Replicas admit one event at a time (raise it per replica() if the
+// stages allow), so stages need no thread-safe state. Each replica runs on
+// its own thread and pulls the next event from the shared supplier, which
+// balances load between replicas. reduce() merges
+// the products of all replicas into one result. It uses a merger registered
+// for the product name if there is one, and otherwise the class's ROOT
+// Merge() (TH1::Merge adds histograms, for example).
+//
+// The string "{replica}" in string stage parameters is replaced by the
+// replica index, so sinks can write one file each. A ProductOutputStage path
+// without it gets a "_<index>" suffix in replicas after the first.
+class ShardedPipeline {
+public:
+    // Merges 'others' into 'target'; returns false if they cannot be merged
+    using Merger = std::function<bool(TObject* target, const std::vector<const TObject*>& others)>;
+    using ReducedProducts = std::map<std::string, std::unique_ptr<TObject>>;
+
+    // replicas == 0 takes the count from the config's "execution.replicas"
+    explicit ShardedPipeline(std::shared_ptr<ConfigManager> configManager, size_t replicas = 0);
+    ~ShardedPipeline();
+
+    ShardedPipeline(const ShardedPipeline&) = delete;
+    ShardedPipeline& operator=(const ShardedPipeline&) = delete;
+
+    bool buildFromConfig();
+
+    size_t replicaCount() const;
+    Pipeline& replica(size_t index);
+
+    // Distributes events from nextInput across the replicas until it returns
+    // false. Rethrows the first stage exception once all replicas stopped.
+    // source, if given, is passed to every replica (see
+    // Pipeline::executeStream()). Returns the number of events processed.
+    uint64_t executeStream(const PipelinedExecutor::InputSupplier& nextInput, InputSource* source = nullptr);
+    uint64_t run(InputSource& source);
+
+    // Overrides the ROOT Merge() of one product
+    void registerMerger(const std::string& productName, Merger merger);
+    // Products to reduce; by default every product of the first replica
+    void setReducedProducts(std::vector<std::string> names);
+
+    // Clones every reduced product from each replica and merges the clones.
+    // Safe to call while events are being processed; replicas are not modified.
+    // Products that are not mergeable are left out and listed in getStats().
+    ReducedProducts reduce();
+    // reduce() and write the result to a ROOT file
+    bool writeReduced(const std::string& path);
+
+    // {"replicas": N, "events": [per replica], "last_reduce": {merged, unmerged, ms}}
+    nlohmann::json getStats() const;
+
+private:
+    bool mergeProduct(const std::string& name, TObject* target, const std::vector<const TObject*>& others);
+
+    std::shared_ptr<ConfigManager> configManager_;
+    size_t requestedReplicas_;
+    std::vector<std::unique_ptr<Pipeline>> replicas_;
+    std::unique_ptr<std::atomic<uint64_t>[]> replicaEvents_;
+
+    std::mutex mergersMutex_;
+    std::map<std::string, Merger> mergers_;
+    std::vector<std::string> reducedProducts_;
+
+    mutable std::mutex statsMutex_;
+    nlohmann::json lastReduce_ = nlohmann::json::object();
+};
+
+#endif // ANALYSISPIPELINE_SHARDEDPIPELINE_H
@@ -0,0 +1,24 @@
+#ifndef ANALYSISPIPELINE_SHAREDINPUTSTAGE_H
+#define ANALYSISPIPELINE_SHAREDINPUTSTAGE_H
+
+#include <memory>
+
+#include "analysis_pipeline/core/context/input_bundle.h"
+
+// Optional mix-in for input stages that can read the event in place.
+// Inherit it alongside BaseInputStage (BaseInputStage first):
+//
+//   class MyInput : public BaseInputStage, public SharedInputStage { ... };
+//
+// The pipeline then hands every such stage the same immutable, reference
+// counted bundle through SetSharedInput() instead of calling SetInput(), so
+// the event is materialized once no matter how many input stages consume it.
+// Keeping the pointer beyond Process() keeps the event data alive.
+class SharedInputStage {
+public:
+    virtual ~SharedInputStage() = default;
+
+    virtual void SetSharedInput(std::shared_ptr<const InputBundle> input) = 0;
+};
+
+#endif // ANALYSISPIPELINE_SHAREDINPUTSTAGE_H
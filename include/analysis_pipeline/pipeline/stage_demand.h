@@ -0,0 +1,38 @@
+#ifndef ANALYSISPIPELINE_STAGEDEMAND_H
+#define ANALYSISPIPELINE_STAGEDEMAND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "analysis_pipeline/config/config_manager.h"
+#include "analysis_pipeline/pipeline/product_dependencies.h"
+#include "analysis_pipeline/pipeline/stage_topology.h"
+
+// The stages a set of outputs depends on: the requested sink stages, the
+// writers of the requested products, and every stage upstream of those.
+// Indexed like the StageTopology it was resolved against.
+class StageDemand {
+public:
+    StageDemand() = default;
+
+    // Names that match no stage id or written product are added to 'unknown'
+    static StageDemand resolve(const StageTopology& topology,
+                               const std::vector<StageProducts>& products,
+                               const OutputsConfig& outputs,
+                               std::vector<std::string>& unknown);
+
+    bool needs(size_t stageIndex) const {
+        return stageIndex < needed_.size() && needed_[stageIndex];
+    }
+    // Number of needed stages
+    size_t count() const { return count_; }
+    size_t size() const { return needed_.size(); }
+
+private:
+    std::vector<uint8_t> needed_;
+    size_t count_ = 0;
+};
+
+#endif // ANALYSISPIPELINE_STAGEDEMAND_H
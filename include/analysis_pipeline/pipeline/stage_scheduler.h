@@ -0,0 +1,128 @@
+#ifndef ANALYSISPIPELINE_STAGESCHEDULER_H
+#define ANALYSISPIPELINE_STAGESCHEDULER_H
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+
+#include "analysis_pipeline/config/config_manager.h"
+
+// Runs stages on a schedule (every N events, every T seconds, end of run)
+// instead of for every event.
+//
+// Scheduled stages are left out of the per-event traversal. When an event
+// retires, the stages that came due are only marked. The caller handles them
+// at its next drain boundary: it stops admitting events, lets the ones in
+// flight retire and calls runDue(). Each due stage sees exactly the products
+// of the events retired so far.
+//
+// By default runDue() only calls prepare() for a due stage, which copies the
+// products the stage reads, and starts the stage in the low-priority
+// background arena; it returns right away and events flow while the stage
+// works on the copies. A stage that comes due while its previous run is
+// still going is skipped for that turn. Stages with "blocking": true instead
+// run on the products themselves: runDue() waits for them, and no event runs
+// meanwhile. The arena reserves a slot for the calling thread, so a blocking
+// run never waits for TBB workers that are busy elsewhere. End-of-run stages
+// run in finishRun(), after the last event.
+class StageScheduler {
+public:
+    // Runs a stage for the retired event eventIndex; readyNs is when it came due
+    using RunFunction = std::function<void(size_t stageIndex, uint64_t eventIndex, uint64_t readyNs)>;
+    // Copies what a non-blocking stage reads; called at the drain boundary
+    using PrepareFunction = std::function<void(size_t stageIndex)>;
+
+    struct Entry {
+        size_t stageIndex = 0;
+        std::string id;
+        StageSchedule schedule;
+    };
+
+    StageScheduler() = default;
+    ~StageScheduler();
+
+    StageScheduler(const StageScheduler&) = delete;
+    StageScheduler& operator=(const StageScheduler&) = delete;
+
+    // arena runs the stages; nullptr runs every stage on the calling thread
+    void configure(std::vector<Entry> entries, tbb::task_arena* arena, RunFunction run,
+                   PrepareFunction prepare = nullptr);
+    // Waits for background runs, then forgets the stages
+    void clear();
+    bool empty() const;
+
+    // Counts retired events up to eventIndex (count of them) and marks the
+    // stages that came due. Called in retirement order; cheap, runs nothing.
+    void eventsRetired(uint64_t eventIndex, uint64_t count = 1);
+
+    // True once a stage has come due and until runDue(); safe from any thread
+    bool due() const;
+    // Starts the non-blocking stages that came due and runs the blocking ones.
+    // Call it only while no event is in flight; it returns once the blocking
+    // runs have finished. Exceptions are kept for finishRun().
+    void runDue();
+
+    // Waits for the runs started in the background
+    void wait();
+
+    // Waits for background runs, runs the due stages, then the end-of-run
+    // stages if any event retired since the last call, and waits for all of
+    // them. Rethrows the first exception a scheduled stage has thrown since
+    // the last call.
+    void finishRun();
+
+    // {id: {"blocking", "runs", "failed", "skipped", "last_event",
+    // "last_run_ms", "total_run_ms", "held_ms"}}; held_ms is how long the
+    // event stream was held for the stage: its runs when blocking, its input
+    // copies otherwise
+    nlohmann::json toJson() const;
+
+private:
+    struct State {
+        Entry entry;
+        uint64_t eventsSinceRun = 0;  // guarded by mutex_
+        uint64_t lastDueNs = 0;       // guarded by mutex_
+        uint64_t dueNs = 0;           // guarded by mutex_; 0 when not due
+        std::atomic<bool> running{false};
+        std::atomic<uint64_t> runs{0};
+        std::atomic<uint64_t> failed{0};
+        std::atomic<uint64_t> skipped{0};
+        std::atomic<uint64_t> heldNs{0};
+        std::atomic<uint64_t> lastEvent{0};
+        std::atomic<uint64_t> lastRunNs{0};
+        std::atomic<uint64_t> totalRunNs{0};
+    };
+
+    // Prepares the given stages, runs them for eventIndex in the arena and,
+    // unless 'background', waits for them
+    void runStages(const std::vector<State*>& states, uint64_t eventIndex, uint64_t readyNs, bool background);
+    void runOne(State& state, uint64_t eventIndex, uint64_t readyNs);
+    void recordFailure(State& state, uint64_t eventIndex);
+    // Whether the stage runs on copies made by prepare_
+    bool copiesInputs(const State& state) const;
+
+    std::vector<std::unique_ptr<State>> states_;
+    tbb::task_arena* arena_ = nullptr;
+    RunFunction run_;
+    PrepareFunction prepare_;
+    tbb::task_group background_;
+
+    std::mutex mutex_;
+    uint64_t lastEventIndex_ = 0;
+    bool eventsSinceFinish_ = false;
+    std::atomic<bool> anyDue_{false};
+
+    std::mutex errorMutex_;
+    std::exception_ptr firstError_;
+};
+
+#endif // ANALYSISPIPELINE_STAGESCHEDULER_H
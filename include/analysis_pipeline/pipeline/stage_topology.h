@@ -0,0 +1,59 @@
+#ifndef ANALYSISPIPELINE_STAGETOPOLOGY_H
+#define ANALYSISPIPELINE_STAGETOPOLOGY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "analysis_pipeline/config/config_manager.h"
+
+// Index-based view of the stage DAG. Stages keep their config order, so an
+// index is stable for the lifetime of a built pipeline.
+class StageTopology {
+public:
+    StageTopology() = default;
+
+    // Builds the topology from stage configs; returns false on unknown 'next' ids
+    bool build(const std::vector<StageConfig>& stages);
+    void clear();
+
+    size_t size() const;
+    const std::string& id(size_t index) const;
+    std::optional<size_t> indexOf(const std::string& id) const;
+
+    const std::vector<size_t>& successors(size_t index) const;
+    const std::vector<size_t>& predecessors(size_t index) const;
+    // Transitive closures, excluding the stage itself, in index order
+    const std::vector<size_t>& ancestors(size_t index) const;
+    const std::vector<size_t>& descendants(size_t index) const;
+
+    // Stages on another path from 'from' to its successor 'to', in index order
+    std::vector<size_t> between(size_t from, size_t to) const;
+
+    // Per stage, one flag per entry of successors(): whether finishing the
+    // stage activates that successor for the event (see FilterStage). An edge
+    // is cleared where a filter lies on another path to the successor, so
+    // that filter alone decides. Derived edges keep transitive edges (I -> F
+    // -> A plus I -> A when A reads I's product too); without this, I would
+    // run A whatever F decided.
+    std::vector<std::vector<uint8_t>> activationEdges(const std::vector<uint8_t>& isFilter) const;
+
+    // Stages without predecessors, in config order
+    const std::vector<size_t>& startStages() const;
+
+    // Stages grouped by longest distance from a start stage, so every
+    // predecessor of a stage is in an earlier level; empty on a cycle
+    std::vector<std::vector<size_t>> levels() const;
+
+private:
+    std::vector<std::string> ids_;
+    std::vector<std::vector<size_t>> successors_;
+    std::vector<std::vector<size_t>> predecessors_;
+    std::vector<std::vector<size_t>> ancestors_;
+    std::vector<std::vector<size_t>> descendants_;
+    std::vector<size_t> startStages_;
+};
+
+#endif // ANALYSISPIPELINE_STAGETOPOLOGY_H
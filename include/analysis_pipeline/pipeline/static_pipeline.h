@@ -0,0 +1,205 @@
+#ifndef ANALYSISPIPELINE_STATICPIPELINE_H
+#define ANALYSISPIPELINE_STATICPIPELINE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include <nlohmann/json.hpp>
+#include <tbb/parallel_invoke.h>
+
+#include "analysis_pipeline/core/stages/base_stage.h"
+#include "analysis_pipeline/core/stages/input/base_input_stage.h"
+#include "analysis_pipeline/core/data/pipeline_data_product_manager.h"
+#include "analysis_pipeline/core/context/input_bundle.h"
+#include "analysis_pipeline/pipeline/filter_stage.h"
+#include "analysis_pipeline/pipeline/shared_input_stage.h"
+#include "analysis_pipeline/pipeline/product_dependencies.h"
+#include "analysis_pipeline/pipeline/product_table.h"
+#include "analysis_pipeline/io/input_source.h"
+
+// Support code for pipelines compiled ahead of time.
+//
+// analysis_pipeline_static_gen turns a frozen pipeline config into a
+// translation unit with one class member per stage, of the stage's concrete
+// type. Stages are constructed directly instead of through the ROOT
+// dictionary. Process() is called without virtual dispatch, in topological
+// order. Stages on the same topological level run together with
+// tbb::parallel_invoke. The compiler sees every stage call, so it can inline
+// across stage boundaries. Filters route events as they do in Pipeline.
+// Scheduling, load shedding, demand selection and product handles are not
+// supported in generated pipelines.
+//
+// The helpers below are what the generated code calls;
+// runStaticPipeline() is its main().
+
+// A stage's successor, in the order of its "next" list
+struct StaticSuccessor {
+    size_t index;
+    const char* id;
+    // False where a filter on another path decides whether the successor
+    // runs (see StageTopology::activationEdges)
+    bool activates;
+};
+
+// True if any of the stage types is a FilterStage
+template <typename... T>
+constexpr bool anyStaticFilter() {
+    return (std::is_base_of_v<FilterStage, T> || ...);
+}
+
+// Rejects stage types a generated pipeline cannot run. The generator emits
+// one check per stage; EdgesKnown is false where the stage's edges were
+// derived from products and ProductAccessStage could have added more.
+template <typename T, bool EdgesKnown>
+struct StaticStageCheck {
+    static_assert(std::is_base_of_v<BaseStage, T>, "pipeline stage types must derive from BaseStage");
+    static_assert(!std::is_base_of_v<ProductHandleStage, T>,
+                  "stages using product handles need Pipeline; they cannot be compiled statically");
+    static_assert(EdgesKnown || !std::is_base_of_v<ProductAccessStage, T>,
+                  "a ProductAccessStage declares its products only once built; "
+                  "give it explicit 'next' edges to compile it statically");
+    static constexpr bool ok = true;
+};
+
+// Stages taking their parameters in the constructor (like factory-registered
+// stages) get them; others are default-constructed as TClass::New() does.
+// Returned as a prvalue, so stages need not be movable.
+template <typename T>
+T makeStaticStage(const nlohmann::json& params) {
+    static_assert(std::is_base_of_v<BaseStage, T>, "pipeline stage types must derive from BaseStage");
+    static_assert(!std::is_base_of_v<ProductHandleStage, T>,
+                  "stages using product handles need Pipeline; they cannot be compiled statically");
+    if constexpr (std::is_constructible_v<T, const nlohmann::json&>) {
+        return T(params);
+    } else {
+        return T();
+    }
+}
+
+template <typename T>
+inline void feedStaticStage(T& stage, const std::shared_ptr<const InputBundle>& input) {
+    if (!input) {
+        return;
+    }
+    if constexpr (std::is_base_of_v<SharedInputStage, T>) {
+        stage.T::SetSharedInput(input);
+    } else if constexpr (std::is_base_of_v<BaseInputStage, T>) {
+        stage.T::SetInput(*input);
+    }
+}
+
+// Qualified call: T is the concrete type, so no vtable lookup
+template <typename T>
+inline void processStaticStage(T& stage) {
+    stage.T::Process();
+}
+
+// Activates the successors the stage routes the event to (see FilterStage)
+template <typename T, size_t N>
+inline void routeStaticStage(T& stage, std::atomic<bool>* active, const std::array<StaticSuccessor, N>& next) {
+    if constexpr (std::is_base_of_v<FilterStage, T>) {
+        const StageVerdict verdict = stage.T::Verdict();
+        for (size_t k = 0; k < N; ++k) {
+            bool selected = k < 64 && ((verdict.branchMask >> k) & 1) != 0;
+            if (!selected && !verdict.selected.empty()) {
+                selected = std::find(verdict.selected.begin(), verdict.selected.end(), next[k].id) !=
+                           verdict.selected.end();
+            }
+            if (selected && next[k].activates) {
+                active[next[k].index].store(true, std::memory_order_relaxed);
+            }
+        }
+    } else {
+        for (const auto& successor : next) {
+            if (successor.activates) {
+                active[successor.index].store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+// Called before the stages are constructed; enables ROOT thread safety when
+// levels run in parallel
+void prepareStaticPipeline(bool parallel);
+
+// First member of a generated pipeline, so prepareStaticPipeline() runs
+// before any stage constructor
+struct StaticPipelineSetup {
+    explicit StaticPipelineSetup(bool parallel) { prepareStaticPipeline(parallel); }
+};
+
+struct StaticRunOptions {
+    std::string inputPath;
+    std::string framing = "length_prefixed";
+    uint64_t maxEvents = 0;  // 0 runs to the end of the input
+    int iterations = 3;      // graph executions without an input
+};
+
+// Returns false if the program should exit with 'exitCode' (--help, bad options)
+bool parseStaticRunOptions(int argc, char** argv, const char* programName,
+                           StaticRunOptions& opts, int& exitCode);
+// --input (memory-mapped) or the config's "input" block; nullptr without
+// either, or after logging an invalid one ('failed' is then set)
+std::unique_ptr<InputSource> openStaticInput(const StaticRunOptions& opts, const nlohmann::json& inputConfig,
+                                             bool& failed);
+void printStaticRunSummary(uint64_t events, double seconds, const InputSource* source);
+// 1 if the input stopped on an error (truncated or corrupt file) rather than at its end
+int staticRunExitCode(const InputSource* source);
+
+// Calls process(input) for each event of 'source', up to maxEvents (0: all);
+// returns the number of events
+template <typename Process>
+uint64_t drainStaticInput(InputSource& source, uint64_t maxEvents, Process&& process) {
+    uint64_t events = 0;
+    std::shared_ptr<const InputBundle> input;
+    while ((maxEvents == 0 || events < maxEvents) && source.next(input)) {
+        process(input);
+        ++events;
+    }
+    return events;
+}
+
+// main() of a generated pipeline: Generated provides inputConfig() and
+// processEvent(input)
+template <typename Generated>
+int runStaticPipeline(int argc, char** argv, const char* programName) {
+    StaticRunOptions opts;
+    int exitCode = 0;
+    if (!parseStaticRunOptions(argc, argv, programName, opts, exitCode)) {
+        return exitCode;
+    }
+
+    bool failed = false;
+    std::unique_ptr<InputSource> source = openStaticInput(opts, Generated::inputConfig(), failed);
+    if (failed) {
+        return 1;
+    }
+
+    Generated pipeline;
+    uint64_t events = 0;
+    const auto start = std::chrono::steady_clock::now();
+    if (source) {
+        events = drainStaticInput(*source, opts.maxEvents,
+                                  [&pipeline](const std::shared_ptr<const InputBundle>& input) {
+                                      pipeline.processEvent(input);
+                                  });
+    } else {
+        for (int i = 0; i < opts.iterations; ++i) {
+            pipeline.processEvent(nullptr);
+            ++events;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printStaticRunSummary(events, seconds, source.get());
+    return staticRunExitCode(source.get());
+}
+
+#endif // ANALYSISPIPELINE_STATICPIPELINE_H
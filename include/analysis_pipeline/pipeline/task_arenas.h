@@ -0,0 +1,79 @@
+#ifndef ANALYSISPIPELINE_TASKARENAS_H
+#define ANALYSISPIPELINE_TASKARENAS_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <tbb/task_arena.h>
+
+#include "analysis_pipeline/config/config_manager.h"
+
+// TBB arenas described by the "execution" config block.
+//
+// The pipeline arena caps the threads that run the graph and the pipelined
+// executor. Stage arenas isolate individual stages: their Process() runs
+// inside the stage's arena, so nested parallelism in the stage uses that
+// arena's workers and cannot take over the rest of the pipeline. Arenas with
+// a CPU set (or NUMA node) pin every thread while it works in the arena and
+// restore the thread's previous affinity when it leaves.
+class TaskArenas {
+public:
+    TaskArenas();
+    ~TaskArenas();
+
+    TaskArenas(const TaskArenas&) = delete;
+    TaskArenas& operator=(const TaskArenas&) = delete;
+
+    // Recreates all arenas. Without an "execution" block no arena is created
+    // and work runs in the caller's arena as before. Not safe while running.
+    bool configure(const ExecutionConfig& config);
+    void clear();
+
+    // Runs f in the pipeline arena, or directly when none is configured
+    template <typename F>
+    auto execute(F&& f) -> decltype(f()) {
+        if (pipeline_.arena) {
+            return pipeline_.arena->execute(std::forward<F>(f));
+        }
+        return f();
+    }
+
+    // Arena for a stage's Process(), nullptr when it runs in the pipeline arena
+    tbb::task_arena* stageArena(const std::string& stageId) const;
+
+    // Low-priority arena for work off the event path (scheduled stages). Like
+    // the others it reserves a slot for the thread that calls execute(), so
+    // that thread can always run blocking work even when no worker is free.
+    // The reserved slot comes on top of the configured max_concurrency, which
+    // is the number of workers taking background runs. Created on first use;
+    // nullptr if its CPUs cannot be resolved.
+    tbb::task_arena* backgroundArena();
+
+    // {"pipeline": {...}, "arenas": [{name, max_concurrency, cpus, stages}], "background": {...}}
+    nlohmann::json toJson() const;
+
+private:
+    class PinningObserver;
+
+    struct Arena {
+        ArenaConfig config;
+        std::unique_ptr<tbb::task_arena> arena;
+        // Declared after the arena so it stops observing before the arena goes away
+        std::unique_ptr<PinningObserver> observer;
+    };
+
+    bool createArena(const ArenaConfig& config, Arena& arena,
+                     tbb::task_arena::priority priority = tbb::task_arena::priority::normal,
+                     unsigned reservedSlots = 1);
+
+    Arena pipeline_;
+    Arena background_;
+    ArenaConfig backgroundConfig_ = makeBackgroundArenaConfig();
+    std::vector<std::unique_ptr<Arena>> stageArenas_;
+    std::unordered_map<std::string, tbb::task_arena*> arenaByStage_;
+};
+
+#endif // ANALYSISPIPELINE_TASKARENAS_H
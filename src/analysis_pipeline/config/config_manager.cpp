@@ -8,6 +8,13 @@ void ConfigManager::reset() {
     pipelineStages_.clear();
     loggerConfig_.clear();
     pluginLibraries_.clear();
+    inputConfig_.clear();
+    monitoringConfig_.clear();
+    checkpointConfig_.clear();
+    executionConfig_ = ExecutionConfig();
+    outputsConfig_ = OutputsConfig();
+    overloadConfig_ = OverloadConfig();
+    edgeMode_ = EdgeMode::Explicit;
 }
 
 bool ConfigManager::loadFiles(const std::vector<std::string>& filepaths) {
@@ -48,12 +55,33 @@ bool ConfigManager::buildFromMergedConfig() {
     pipelineStages_.clear();
     loggerConfig_.clear();
     pluginLibraries_.clear();
+    inputConfig_.clear();
+    monitoringConfig_.clear();
+    checkpointConfig_.clear();
+    executionConfig_ = ExecutionConfig();
+    outputsConfig_ = OutputsConfig();
+    overloadConfig_ = OverloadConfig();
+    edgeMode_ = EdgeMode::Explicit;
 
     if (!mergedJson_.contains("pipeline")) {
         std::cerr << "[ConfigManager] Missing 'pipeline' key in config." << std::endl;
         return false;
     }
 
+    if (mergedJson_.contains("edges")) {
+        const auto& edges = mergedJson_["edges"];
+        if (edges == "explicit") {
+            edgeMode_ = EdgeMode::Explicit;
+        } else if (edges == "derived") {
+            edgeMode_ = EdgeMode::Derived;
+        } else if (edges == "merged") {
+            edgeMode_ = EdgeMode::Merged;
+        } else {
+            std::cerr << "[ConfigManager] 'edges' must be \"explicit\", \"derived\" or \"merged\"." << std::endl;
+            return false;
+        }
+    }
+
     if (!parsePipelineStages(mergedJson_["pipeline"])) {
         std::cerr << "[ConfigManager] Failed to parse pipeline stages." << std::endl;
         return false;
@@ -63,6 +91,59 @@ bool ConfigManager::buildFromMergedConfig() {
         loggerConfig_ = mergedJson_["logger"];
     }
 
+    if (mergedJson_.contains("input")) {
+        if (!mergedJson_["input"].is_object()) {
+            std::cerr << "[ConfigManager] 'input' must be an object." << std::endl;
+            return false;
+        }
+        inputConfig_ = mergedJson_["input"];
+    }
+
+    if (mergedJson_.contains("monitoring")) {
+        const auto& monitoring = mergedJson_["monitoring"];
+        if (!monitoring.is_object() ||
+            (monitoring.contains("shm_segment") && !monitoring["shm_segment"].is_string()) ||
+            (monitoring.contains("interval_ms") && !monitoring["interval_ms"].is_number_unsigned())) {
+            std::cerr << "[ConfigManager] 'monitoring' must be an object with a string 'shm_segment' "
+                      << "and an unsigned 'interval_ms'." << std::endl;
+            return false;
+        }
+        monitoringConfig_ = monitoring;
+    }
+
+    if (mergedJson_.contains("checkpoint")) {
+        const auto& checkpoint = mergedJson_["checkpoint"];
+        if (!checkpoint.is_object() || !checkpoint.contains("path") || !checkpoint["path"].is_string() ||
+            (checkpoint.contains("interval_s") &&
+             (!checkpoint["interval_s"].is_number() || checkpoint["interval_s"].get<double>() < 0.0))) {
+            std::cerr << "[ConfigManager] 'checkpoint' must be an object with a string 'path' "
+                      << "and a non-negative 'interval_s'." << std::endl;
+            return false;
+        }
+        checkpointConfig_ = checkpoint;
+    }
+
+    if (mergedJson_.contains("execution")) {
+        if (!parseExecution(mergedJson_["execution"])) {
+            std::cerr << "[ConfigManager] Failed to parse 'execution' block." << std::endl;
+            return false;
+        }
+    }
+
+    if (mergedJson_.contains("outputs")) {
+        if (!parseOutputs(mergedJson_["outputs"])) {
+            std::cerr << "[ConfigManager] Failed to parse 'outputs' block." << std::endl;
+            return false;
+        }
+    }
+
+    if (mergedJson_.contains("overload")) {
+        if (!parseOverload(mergedJson_["overload"])) {
+            std::cerr << "[ConfigManager] Failed to parse 'overload' block." << std::endl;
+            return false;
+        }
+    }
+
     if (mergedJson_.contains("plugin_libraries")) {
         if (!mergedJson_["plugin_libraries"].is_array()) {
             std::cerr << "[ConfigManager] 'plugin_libraries' must be an array." << std::endl;
@@ -89,8 +170,9 @@ bool ConfigManager::parsePipelineStages(const nlohmann::json& pipelineJson) {
     }
 
     for (const auto& stage : pipelineJson) {
-        if (!stage.contains("id") || !stage.contains("type") ||
-            !stage.contains("parameters") || !stage.contains("next")) {
+        // 'next' may be left out when edges are derived from products
+        if (!stage.contains("id") || !stage.contains("type") || !stage.contains("parameters") ||
+            (!stage.contains("next") && edgeMode_ == EdgeMode::Explicit)) {
             std::cerr << "[ConfigManager] A stage is missing required fields." << std::endl;
             return false;
         }
@@ -100,7 +182,20 @@ bool ConfigManager::parsePipelineStages(const nlohmann::json& pipelineJson) {
             sc.id = stage.at("id").get<std::string>();
             sc.type = stage.at("type").get<std::string>();
             sc.parameters = stage.at("parameters");
-            sc.next = stage.at("next").get<std::vector<std::string>>();
+            if (stage.contains("next")) {
+                sc.next = stage.at("next").get<std::vector<std::string>>();
+            }
+            if (stage.contains("schedule") && !parseSchedule(stage.at("schedule"), sc.schedule)) {
+                std::cerr << "[ConfigManager] Invalid 'schedule' for stage '" << sc.id << "'." << std::endl;
+                return false;
+            }
+            const std::string criticality = stage.value("criticality", std::string("essential"));
+            if (criticality != "essential" && criticality != "optional") {
+                std::cerr << "[ConfigManager] 'criticality' of stage '" << sc.id
+                          << "' must be \"essential\" or \"optional\"." << std::endl;
+                return false;
+            }
+            sc.optional = criticality == "optional";
             pipelineStages_.push_back(std::move(sc));
         } catch (const std::exception& e) {
             std::cerr << "[ConfigManager] Exception parsing stage: " << e.what() << std::endl;
@@ -111,6 +206,234 @@ bool ConfigManager::parsePipelineStages(const nlohmann::json& pipelineJson) {
     return true;
 }
 
+bool ConfigManager::parseExecution(const nlohmann::json& executionJson) {
+    if (!executionJson.is_object()) {
+        std::cerr << "[ConfigManager] 'execution' must be an object." << std::endl;
+        return false;
+    }
+
+    ExecutionConfig execution;
+    execution.configured = true;
+    if (!parseArena(executionJson, execution.pipeline)) {
+        return false;
+    }
+    execution.pipeline.name = "pipeline";
+
+    try {
+        execution.replicas = executionJson.value("replicas", 1);
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigManager] Exception parsing 'execution.replicas': " << e.what() << std::endl;
+        return false;
+    }
+    if (execution.replicas < 1) {
+        std::cerr << "[ConfigManager] 'execution.replicas' must be at least 1." << std::endl;
+        return false;
+    }
+
+    if (executionJson.contains("background")) {
+        const auto& background = executionJson.at("background");
+        if (!parseArena(background, execution.background)) {
+            return false;
+        }
+        execution.background.name = "background";
+        if (!background.contains("max_concurrency")) {
+            execution.background.maxConcurrency = 1;
+        }
+        if (!execution.background.stages.empty()) {
+            std::cerr << "[ConfigManager] 'execution.background' runs the scheduled stages; it takes no 'stages'." << std::endl;
+            return false;
+        }
+    }
+
+    if (executionJson.contains("arenas")) {
+        const auto& arenas = executionJson.at("arenas");
+        if (!arenas.is_array()) {
+            std::cerr << "[ConfigManager] 'execution.arenas' must be an array." << std::endl;
+            return false;
+        }
+        for (const auto& arenaJson : arenas) {
+            ArenaConfig arena;
+            if (!parseArena(arenaJson, arena)) {
+                return false;
+            }
+            if (arena.name.empty()) {
+                arena.name = "arena" + std::to_string(execution.stageArenas.size());
+            }
+            execution.stageArenas.push_back(std::move(arena));
+        }
+    }
+
+    executionConfig_ = std::move(execution);
+    return true;
+}
+
+bool ConfigManager::parseArena(const nlohmann::json& arenaJson, ArenaConfig& arena) {
+    if (!arenaJson.is_object()) {
+        std::cerr << "[ConfigManager] Arena settings must be an object." << std::endl;
+        return false;
+    }
+
+    try {
+        arena.name = arenaJson.value("name", std::string());
+        arena.maxConcurrency = arenaJson.value("max_concurrency", 0);
+        if (arena.maxConcurrency < 0) {
+            std::cerr << "[ConfigManager] 'max_concurrency' must not be negative." << std::endl;
+            return false;
+        }
+
+        if (arenaJson.contains("cpus")) {
+            const auto& cpus = arenaJson.at("cpus");
+            if (cpus.is_string()) {
+                if (!parseCpuList(cpus.get<std::string>(), arena.cpus)) {
+                    std::cerr << "[ConfigManager] Invalid CPU list '" << cpus.get<std::string>() << "'." << std::endl;
+                    return false;
+                }
+            } else {
+                arena.cpus = cpus.get<std::vector<int>>();
+            }
+        }
+        arena.numaNode = arenaJson.value("numa_node", -1);
+        if (!arena.cpus.empty() && arena.numaNode >= 0) {
+            std::cerr << "[ConfigManager] Set either 'cpus' or 'numa_node', not both." << std::endl;
+            return false;
+        }
+
+        if (arenaJson.contains("stages")) {
+            arena.stages = arenaJson.at("stages").get<std::vector<std::string>>();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigManager] Exception parsing arena: " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool ConfigManager::parseSchedule(const nlohmann::json& scheduleJson, StageSchedule& schedule) {
+    if (!scheduleJson.is_object()) {
+        std::cerr << "[ConfigManager] 'schedule' must be an object." << std::endl;
+        return false;
+    }
+
+    try {
+        schedule.everyEvents = scheduleJson.value("every_events", uint64_t(0));
+        schedule.everySeconds = scheduleJson.value("every_seconds", 0.0);
+        schedule.endOfRun = scheduleJson.value("end_of_run", false);
+        schedule.blocking = scheduleJson.value("blocking", false);
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigManager] Exception parsing 'schedule': " << e.what() << std::endl;
+        return false;
+    }
+    if (schedule.everySeconds < 0.0 || !schedule.scheduled()) {
+        std::cerr << "[ConfigManager] 'schedule' needs a positive 'every_events' or 'every_seconds', "
+                  << "or 'end_of_run': true." << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool ConfigManager::parseOverload(const nlohmann::json& overloadJson) {
+    if (!overloadJson.is_object()) {
+        std::cerr << "[ConfigManager] 'overload' must be an object." << std::endl;
+        return false;
+    }
+
+    OverloadConfig overload;
+    try {
+        overload.latencyBudgetMs = overloadJson.value("latency_budget_ms", 0.0);
+        overload.queueHigh = overloadJson.value("queue_high", size_t(0));
+        overload.queueLow = overloadJson.value("queue_low", overload.queueHigh / 2);
+        overload.holdMs = overloadJson.value("hold_ms", 1000.0);
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigManager] Exception parsing 'overload': " << e.what() << std::endl;
+        return false;
+    }
+    if (overload.latencyBudgetMs < 0.0 || overload.holdMs < 0.0 || overload.queueLow > overload.queueHigh) {
+        std::cerr << "[ConfigManager] 'overload' needs non-negative times and 'queue_low' <= 'queue_high'." << std::endl;
+        return false;
+    }
+
+    overloadConfig_ = overload;
+    return true;
+}
+
+bool ConfigManager::parseOutputs(const nlohmann::json& outputsJson) {
+    if (!outputsJson.is_object()) {
+        std::cerr << "[ConfigManager] 'outputs' must be an object." << std::endl;
+        return false;
+    }
+
+    try {
+        if (outputsJson.contains("products")) {
+            outputsConfig_.products = outputsJson.at("products").get<std::vector<std::string>>();
+        }
+        if (outputsJson.contains("stages")) {
+            outputsConfig_.stages = outputsJson.at("stages").get<std::vector<std::string>>();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[ConfigManager] 'outputs' lists must hold strings: " << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool ConfigManager::parseCpuList(const std::string& text, std::vector<int>& cpus) {
+    // A whole item must be the number: "3abc" or "-1" is an error, not CPU 3
+    auto parseCpu = [](const std::string& item, int& cpu) {
+        const size_t begin = item.find_first_not_of(" \t\n");
+        if (begin == std::string::npos) {
+            return false;
+        }
+        const std::string digits = item.substr(begin, item.find_last_not_of(" \t\n") + 1 - begin);
+        if (digits.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+        cpu = std::stoi(digits);
+        return true;
+    };
+
+    std::vector<int> parsed;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        const std::string item = text.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.find_first_not_of(" \t\n") == std::string::npos) {
+            continue;
+        }
+
+        try {
+            int first = 0;
+            int last = 0;
+            const size_t dash = item.find('-');
+            if (dash == std::string::npos) {
+                if (!parseCpu(item, first)) {
+                    return false;
+                }
+                last = first;
+            } else if (!parseCpu(item.substr(0, dash), first) || !parseCpu(item.substr(dash + 1), last)) {
+                return false;
+            }
+            if (last < first) {
+                return false;
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                parsed.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            return false; // out of range
+        }
+    }
+
+    cpus = std::move(parsed);
+    return true;
+}
+
 bool ConfigManager::validate() const {
     if (pipelineStages_.empty()) {
         std::cerr << "[ConfigManager] Validation failed: no pipeline stages." << std::endl;
@@ -129,6 +452,30 @@ bool ConfigManager::validate() const {
         }
     }
 
+    std::set<std::string> arenaNames = {"pipeline", "background"};
+    for (const auto& arena : executionConfig_.stageArenas) {
+        if (!arenaNames.insert(arena.name).second) {
+            std::cerr << "[ConfigManager] Validation failed: duplicate arena name '" << arena.name << "'." << std::endl;
+            return false;
+        }
+    }
+
+    std::set<std::string> assigned;
+    for (const auto& arena : executionConfig_.stageArenas) {
+        for (const auto& stageId : arena.stages) {
+            if (!ids.count(stageId)) {
+                std::cerr << "[ConfigManager] Validation failed: arena '" << arena.name
+                          << "' lists unknown stage '" << stageId << "'." << std::endl;
+                return false;
+            }
+            if (!assigned.insert(stageId).second) {
+                std::cerr << "[ConfigManager] Validation failed: stage '" << stageId
+                          << "' is assigned to more than one arena." << std::endl;
+                return false;
+            }
+        }
+    }
+
     return true;
 }
 
@@ -144,6 +491,34 @@ const std::vector<std::string>& ConfigManager::getPluginLibraries() const {
     return pluginLibraries_;
 }
 
+const nlohmann::json& ConfigManager::getInputConfig() const {
+    return inputConfig_;
+}
+
+const nlohmann::json& ConfigManager::getMonitoringConfig() const {
+    return monitoringConfig_;
+}
+
+const nlohmann::json& ConfigManager::getCheckpointConfig() const {
+    return checkpointConfig_;
+}
+
+const ExecutionConfig& ConfigManager::getExecutionConfig() const {
+    return executionConfig_;
+}
+
+const OutputsConfig& ConfigManager::getOutputsConfig() const {
+    return outputsConfig_;
+}
+
+const OverloadConfig& ConfigManager::getOverloadConfig() const {
+    return overloadConfig_;
+}
+
+EdgeMode ConfigManager::getEdgeMode() const {
+    return edgeMode_;
+}
+
 void ConfigManager::setPipelineStages(const std::vector<StageConfig>& stages) {
     pipelineStages_ = stages;
 }
@@ -155,3 +530,31 @@ void ConfigManager::setLoggerConfig(const nlohmann::json& loggerJson) {
 void ConfigManager::setPluginLibraries(const std::vector<std::string>& libs) {
     pluginLibraries_ = libs;
 }
+
+void ConfigManager::setInputConfig(const nlohmann::json& inputJson) {
+    inputConfig_ = inputJson;
+}
+
+void ConfigManager::setMonitoringConfig(const nlohmann::json& monitoringJson) {
+    monitoringConfig_ = monitoringJson;
+}
+
+void ConfigManager::setCheckpointConfig(const nlohmann::json& checkpointJson) {
+    checkpointConfig_ = checkpointJson;
+}
+
+void ConfigManager::setExecutionConfig(const ExecutionConfig& execution) {
+    executionConfig_ = execution;
+}
+
+void ConfigManager::setOutputsConfig(const OutputsConfig& outputs) {
+    outputsConfig_ = outputs;
+}
+
+void ConfigManager::setOverloadConfig(const OverloadConfig& overload) {
+    overloadConfig_ = overload;
+}
+
+void ConfigManager::setEdgeMode(EdgeMode mode) {
+    edgeMode_ = mode;
+}
@@ -0,0 +1,325 @@
+#include "analysis_pipeline/io/checkpointer.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include "analysis_pipeline/monitoring/stage_metrics.h"
+
+namespace {
+
+template <typename T>
+void appendValue(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readValue(const std::string& in, size_t& pos, T& value) {
+    if (in.size() - pos < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, in.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+bool readString(const std::string& in, size_t& pos, size_t length, std::string& value) {
+    if (in.size() - pos < length) {
+        return false;
+    }
+    value.assign(in.data() + pos, length);
+    pos += length;
+    return true;
+}
+
+bool writeAll(int fd, const std::string& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+        if (n > 0) {
+            done += static_cast<size_t>(n);
+        } else if (n < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+size_t CheckpointSnapshot::payloadBytes() const {
+    size_t bytes = 0;
+    for (const auto& product : products) {
+        bytes += product.payload.size();
+    }
+    return bytes;
+}
+
+Checkpointer::~Checkpointer() {
+    stop();
+}
+
+bool Checkpointer::start(const std::string& path, double intervalSeconds) {
+    stop();
+    if (path.empty()) {
+        spdlog::error("[Checkpointer] No checkpoint path given.");
+        return false;
+    }
+
+    path_ = path;
+    interval_ = std::chrono::nanoseconds(
+        intervalSeconds > 0.0 ? static_cast<int64_t>(intervalSeconds * 1e9) : 0);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = false;
+        pending_.reset();
+        writing_ = false;
+    }
+    due_.store(false);
+    writer_ = std::thread([this]() { writerLoop(); });
+
+    if (intervalSeconds > 0.0) {
+        spdlog::info("[Checkpointer] Checkpointing products to '{}' every {} s", path_, intervalSeconds);
+    } else {
+        spdlog::info("[Checkpointer] Checkpointing products to '{}' on request", path_);
+    }
+    return true;
+}
+
+void Checkpointer::stop() {
+    if (!writer_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    writer_.join();
+    due_.store(false);
+}
+
+bool Checkpointer::enabled() const {
+    return writer_.joinable();
+}
+
+void Checkpointer::request() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        due_.store(true, std::memory_order_relaxed);
+    }
+    cv_.notify_all();
+}
+
+void Checkpointer::submit(CheckpointSnapshot snapshot, uint64_t copyNs) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // At most one snapshot waits; a slow disk delays the next one instead
+        // of queuing copies
+        cv_.wait(lock, [this]() { return !pending_ || stop_; });
+        pending_ = std::move(snapshot);
+        lastCopyMs_ = copyNs / 1e6;
+        due_.store(false, std::memory_order_relaxed);
+    }
+    cv_.notify_all();
+}
+
+bool Checkpointer::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return (!pending_ && !writing_) || !writer_.joinable(); });
+    return !lastFailed_;
+}
+
+void Checkpointer::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto nextDue = std::chrono::steady_clock::now() + interval_;
+    for (;;) {
+        if (pending_) {
+            CheckpointSnapshot snapshot = std::move(*pending_);
+            pending_.reset();
+            writing_ = true;
+            lock.unlock();
+            cv_.notify_all();
+
+            const uint64_t startNs = StageMetrics::nowNs();
+            serializeProducts(snapshot);
+            const bool ok = writeFile(path_, snapshot);
+            const double writeMs = (StageMetrics::nowNs() - startNs) / 1e6;
+
+            lock.lock();
+            writing_ = false;
+            lastFailed_ = !ok;
+            if (ok) {
+                ++written_;
+                lastEvents_ = snapshot.events;
+                lastBytes_ = snapshot.payloadBytes();
+                lastWriteMs_ = writeMs;
+                spdlog::debug("[Checkpointer] Wrote checkpoint of {} event(s), {} product(s) in {:.1f} ms",
+                              snapshot.events, snapshot.products.size(), writeMs);
+            } else {
+                ++failed_;
+            }
+            nextDue = std::chrono::steady_clock::now() + interval_;
+            cv_.notify_all();
+            continue;
+        }
+        if (stop_) {
+            return;
+        }
+
+        auto wake = [this]() { return stop_ || pending_.has_value() || due_.load(std::memory_order_relaxed); };
+        if (due_.load(std::memory_order_relaxed) || interval_.count() == 0) {
+            cv_.wait(lock, [this]() { return stop_ || pending_.has_value(); });
+            continue;
+        }
+        if (!cv_.wait_until(lock, nextDue, wake)) {
+            due_.store(true, std::memory_order_relaxed);
+        }
+    }
+}
+
+nlohmann::json Checkpointer::toJson() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {
+        {"path", path_},
+        {"interval_s", std::chrono::duration<double>(interval_).count()},
+        {"written", written_},
+        {"failed", failed_},
+        {"last_events", lastEvents_},
+        {"last_bytes", lastBytes_},
+        {"last_copy_ms", lastCopyMs_},
+        {"last_write_ms", lastWriteMs_}
+    };
+}
+
+size_t Checkpointer::serializeProducts(CheckpointSnapshot& snapshot) {
+    size_t failed = 0;
+    auto keep = snapshot.products.begin();
+    for (auto& product : snapshot.products) {
+        if (product.serialize) {
+            bool ok = false;
+            try {
+                ok = product.serialize(product.payload);
+            } catch (const std::exception& e) {
+                spdlog::warn("[Checkpointer] Exception serializing product '{}': {}", product.name, e.what());
+            }
+            // Releases the object copy on this thread
+            product.serialize = nullptr;
+            if (!ok) {
+                spdlog::warn("[Checkpointer] Failed to serialize product '{}'; left out of the checkpoint.",
+                             product.name);
+                ++failed;
+                continue;
+            }
+        }
+        if (&*keep != &product) {
+            *keep = std::move(product);
+        }
+        ++keep;
+    }
+    snapshot.products.erase(keep, snapshot.products.end());
+    return failed;
+}
+
+bool Checkpointer::writeFile(const std::string& path, const CheckpointSnapshot& snapshot) {
+    constexpr size_t maxString = std::numeric_limits<uint16_t>::max();
+
+    // Same layout as a ProductWriter record
+    std::string record;
+    record.reserve(snapshot.payloadBytes() + 64 * snapshot.products.size() + 16);
+    appendValue<uint32_t>(record, 0);  // record_bytes, patched below
+    appendValue<uint64_t>(record, snapshot.events);
+    appendValue<uint32_t>(record, 0);  // product_count, patched below
+    uint32_t count = 0;
+    for (const auto& product : snapshot.products) {
+        if (product.serialize) {
+            spdlog::warn("[Checkpointer] Skipping product '{}' that was not serialized", product.name);
+            continue;
+        }
+        if (product.name.size() > maxString || product.className.size() > maxString ||
+            product.payload.size() > std::numeric_limits<uint32_t>::max()) {
+            spdlog::warn("[Checkpointer] Skipping oversized product '{}'", product.name.substr(0, 64));
+            continue;
+        }
+        appendValue<uint16_t>(record, static_cast<uint16_t>(product.name.size()));
+        record.append(product.name);
+        appendValue<uint16_t>(record, static_cast<uint16_t>(product.className.size()));
+        record.append(product.className);
+        appendValue<uint32_t>(record, static_cast<uint32_t>(product.payload.size()));
+        record.append(product.payload);
+        ++count;
+    }
+    if (record.size() - sizeof(uint32_t) > std::numeric_limits<uint32_t>::max()) {
+        spdlog::error("[Checkpointer] Checkpoint of {} bytes exceeds the record size limit", record.size());
+        return false;
+    }
+    const uint32_t recordBytes = static_cast<uint32_t>(record.size() - sizeof(uint32_t));
+    std::memcpy(&record[0], &recordBytes, sizeof(recordBytes));
+    std::memcpy(&record[sizeof(uint32_t) + sizeof(uint64_t)], &count, sizeof(count));
+
+    const std::string tmpPath = path + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        spdlog::error("[Checkpointer] Failed to open '{}': {}", tmpPath, std::strerror(errno));
+        return false;
+    }
+    bool ok = writeAll(fd, record) && ::fsync(fd) == 0;
+    if (!ok) {
+        spdlog::error("[Checkpointer] Write to '{}' failed: {}", tmpPath, std::strerror(errno));
+    }
+    if (::close(fd) != 0 && ok) {
+        spdlog::error("[Checkpointer] Failed to close '{}': {}", tmpPath, std::strerror(errno));
+        ok = false;
+    }
+    if (ok && std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        spdlog::error("[Checkpointer] Failed to rename '{}' to '{}': {}", tmpPath, path, std::strerror(errno));
+        ok = false;
+    }
+    if (!ok) {
+        ::unlink(tmpPath.c_str());
+    }
+    return ok;
+}
+
+bool Checkpointer::readFile(const std::string& path, CheckpointSnapshot& snapshot) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        spdlog::error("[Checkpointer] Failed to open checkpoint '{}'", path);
+        return false;
+    }
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    uint32_t recordBytes = 0;
+    uint32_t count = 0;
+    snapshot = CheckpointSnapshot();
+    bool ok = readValue(data, pos, recordBytes) && data.size() - pos == recordBytes &&
+              readValue(data, pos, snapshot.events) && readValue(data, pos, count);
+    for (uint32_t i = 0; ok && i < count; ++i) {
+        CheckpointSnapshot::Product product;
+        uint16_t nameLength = 0;
+        uint16_t classLength = 0;
+        uint32_t payloadLength = 0;
+        ok = readValue(data, pos, nameLength) && readString(data, pos, nameLength, product.name) &&
+             readValue(data, pos, classLength) && readString(data, pos, classLength, product.className) &&
+             readValue(data, pos, payloadLength) && readString(data, pos, payloadLength, product.payload);
+        if (ok) {
+            snapshot.products.push_back(std::move(product));
+        }
+    }
+    if (!ok || pos != data.size()) {
+        spdlog::error("[Checkpointer] '{}' is not a valid checkpoint ({} bytes)", path, data.size());
+        snapshot = CheckpointSnapshot();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,55 @@
+#include "analysis_pipeline/io/input_source.h"
+
+#include <spdlog/spdlog.h>
+
+#include "analysis_pipeline/io/mapped_file_source.h"
+#include "analysis_pipeline/io/prefetching_source.h"
+#include "analysis_pipeline/io/stream_event_source.h"
+
+std::unique_ptr<InputSource> makeInputSource(const nlohmann::json& config) {
+    if (!config.is_object() || !config.contains("location")) {
+        spdlog::error("[InputSource] 'input' block must be an object with a 'location'.");
+        return nullptr;
+    }
+
+    try {
+        const std::string location = config.at("location").get<std::string>();
+        const std::string framingName = config.value("framing", std::string("length_prefixed"));
+        auto framing = parseEventFraming(framingName);
+        if (!framing) {
+            spdlog::error("[InputSource] Unknown framing '{}' (expected 'length_prefixed' or 'midas').", framingName);
+            return nullptr;
+        }
+
+        // A mapped file is sliced in place; a producer thread would only add a hop
+        if (location.rfind("mmap:", 0) == 0) {
+            auto mapped = std::make_unique<MappedFileSource>(location.substr(5), *framing);
+            if (config.contains("max_event_bytes")) {
+                mapped->setMaxEventBytes(config.at("max_event_bytes").get<size_t>());
+            }
+            return mapped;
+        }
+
+        auto stream = std::make_unique<StreamEventSource>(location, *framing);
+        if (config.contains("max_event_bytes")) {
+            stream->setMaxEventBytes(config.at("max_event_bytes").get<size_t>());
+        }
+
+        const nlohmann::json prefetch = config.value("prefetch", nlohmann::json::object());
+        const size_t depth = prefetch.value("depth", size_t(64));
+        if (depth == 0) {
+            return stream;
+        }
+
+        const std::string policyName = prefetch.value("backpressure", std::string("block"));
+        auto policy = parseBackpressurePolicy(policyName);
+        if (!policy) {
+            spdlog::error("[InputSource] Unknown backpressure policy '{}' (expected 'block' or 'drop').", policyName);
+            return nullptr;
+        }
+        return std::make_unique<PrefetchingSource>(std::move(stream), depth, *policy);
+    } catch (const std::exception& e) {
+        spdlog::error("[InputSource] Invalid 'input' block: {}", e.what());
+        return nullptr;
+    }
+}
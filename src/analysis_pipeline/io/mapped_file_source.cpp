@@ -0,0 +1,122 @@
+#include "analysis_pipeline/io/mapped_file_source.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+MappedFileSource::MappedFileSource(std::string path, EventFraming framing)
+    : path_(std::move(path)), framing_(framing) {}
+
+bool MappedFileSource::open() {
+    if (base_ || failed_.load(std::memory_order_relaxed)) {
+        return !failed_.load(std::memory_order_relaxed);
+    }
+
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        spdlog::error("[MappedFileSource] Failed to open '{}': {}", path_, std::strerror(errno));
+        failed_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        spdlog::error("[MappedFileSource] Failed to stat '{}': {}", path_, std::strerror(errno));
+        ::close(fd);
+        failed_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) {
+        ::close(fd);
+        spdlog::warn("[MappedFileSource] '{}' is empty.", path_);
+        return true;
+    }
+
+    void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file referenced
+    if (addr == MAP_FAILED) {
+        spdlog::error("[MappedFileSource] Failed to map '{}': {}", path_, std::strerror(errno));
+        size_ = 0;
+        failed_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Events are consumed front to back: read ahead aggressively, drop behind
+    ::madvise(addr, size_, MADV_SEQUENTIAL);
+    ::madvise(addr, size_, MADV_WILLNEED);
+
+    const size_t length = size_;
+    mapping_ = std::shared_ptr<const void>(addr, [length](const void* p) {
+        ::munmap(const_cast<void*>(p), length);
+    });
+    base_ = static_cast<const std::byte*>(addr);
+
+    spdlog::debug("[MappedFileSource] Mapped '{}' ({} bytes)", path_, size_);
+    return true;
+}
+
+bool MappedFileSource::next(std::shared_ptr<const InputBundle>& input) {
+    if (!base_ && !open()) {
+        return false;
+    }
+
+    const size_t headerSize = frameHeaderSize(framing_);
+    const size_t remaining = size_ - offset_;
+    if (remaining == 0) {
+        return false;  // clean end of file
+    }
+    if (remaining < headerSize) {
+        spdlog::error("[MappedFileSource] Truncated frame header at event {} in '{}'",
+                      events_.load(std::memory_order_relaxed), path_);
+        failed_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+
+    const std::byte* frame = base_ + offset_;
+    const size_t total = frameTotalSize(framing_, frame);
+    if (total > max_event_bytes_) {
+        spdlog::error("[MappedFileSource] Frame of {} bytes at event {} exceeds limit of {} bytes",
+                      total, events_.load(std::memory_order_relaxed), max_event_bytes_);
+        failed_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    if (total > remaining) {
+        spdlog::error("[MappedFileSource] Truncated frame body at event {} in '{}'",
+                      events_.load(std::memory_order_relaxed), path_);
+        failed_.store(true, std::memory_order_relaxed);
+        return false;
+    }
+
+    const size_t payloadOffset = framePayloadOffset(framing_);
+    RawEvent event;
+    event.index = events_.fetch_add(1, std::memory_order_relaxed);
+    event.data = frame + payloadOffset;
+    event.size = total - payloadOffset;
+    event.storage = mapping_;
+    offset_ += total;
+    bytes_.fetch_add(total, std::memory_order_relaxed);
+
+    input = makeRawEventBundle(std::move(event));
+    return true;
+}
+
+std::string MappedFileSource::describe() const {
+    return "mmap:" + path_;
+}
+
+nlohmann::json MappedFileSource::statsToJson() const {
+    return {
+        {"location", describe()},
+        {"file_bytes", size_},
+        {"events", events_.load(std::memory_order_relaxed)},
+        {"bytes", bytes_.load(std::memory_order_relaxed)},
+        {"failed", failed_.load(std::memory_order_relaxed)}
+    };
+}
@@ -0,0 +1,146 @@
+#include "analysis_pipeline/io/prefetching_source.h"
+
+#include <chrono>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+// Spin briefly, then yield, then sleep with a capped exponential step. Keeps
+// hand-off latency low when the other side is about to act without burning a
+// core when it is not.
+class Backoff {
+public:
+    void pause() {
+        if (step_ < 16) {
+            // busy spin
+        } else if (step_ < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(sleep_);
+            if (sleep_ < std::chrono::microseconds(500)) {
+                sleep_ *= 2;
+            }
+        }
+        ++step_;
+    }
+
+private:
+    unsigned step_ = 0;
+    std::chrono::microseconds sleep_{10};
+};
+
+} // anonymous namespace
+
+std::optional<BackpressurePolicy> parseBackpressurePolicy(const std::string& name) {
+    if (name == "block") {
+        return BackpressurePolicy::Block;
+    }
+    if (name == "drop") {
+        return BackpressurePolicy::Drop;
+    }
+    return std::nullopt;
+}
+
+PrefetchingSource::PrefetchingSource(std::unique_ptr<InputSource> upstream, size_t depth,
+                                     BackpressurePolicy policy)
+    : upstream_(std::move(upstream)), policy_(policy),
+      queue_(depth == 0 ? 1 : depth) {}
+
+PrefetchingSource::~PrefetchingSource() {
+    stop();
+}
+
+void PrefetchingSource::start() {
+    if (started_.exchange(true)) {
+        return;
+    }
+    spdlog::debug("[PrefetchingSource] Starting producer for '{}' (depth {}, policy {})",
+                  upstream_->describe(), queue_.capacity(),
+                  policy_ == BackpressurePolicy::Block ? "block" : "drop");
+    producer_ = std::thread([this]() { produce(); });
+}
+
+void PrefetchingSource::stop() {
+    stopRequested_.store(true, std::memory_order_release);
+    if (producer_.joinable()) {
+        producer_.join();
+    }
+}
+
+void PrefetchingSource::produce() {
+    std::shared_ptr<const InputBundle> input;
+    while (!stopRequested_.load(std::memory_order_acquire) && upstream_->next(input)) {
+        produced_.fetch_add(1, std::memory_order_relaxed);
+
+        if (!queue_.tryPush(std::move(input))) {
+            producerStalls_.fetch_add(1, std::memory_order_relaxed);
+            if (policy_ == BackpressurePolicy::Drop) {
+                input.reset();
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            // tryPush only moves from 'input' on success
+            Backoff backoff;
+            while (!queue_.tryPush(std::move(input))) {
+                if (stopRequested_.load(std::memory_order_acquire)) {
+                    producerDone_.store(true, std::memory_order_release);
+                    return;
+                }
+                backoff.pause();
+            }
+        }
+
+        size_t depth = queue_.size();
+        size_t seen = highWater_.load(std::memory_order_relaxed);
+        while (depth > seen && !highWater_.compare_exchange_weak(seen, depth, std::memory_order_relaxed)) {
+        }
+    }
+    producerDone_.store(true, std::memory_order_release);
+}
+
+bool PrefetchingSource::next(std::shared_ptr<const InputBundle>& input) {
+    if (!started_.load(std::memory_order_acquire)) {
+        start();
+    }
+
+    if (queue_.tryPop(input)) {
+        consumed_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    consumerStarved_.fetch_add(1, std::memory_order_relaxed);
+    Backoff backoff;
+    for (;;) {
+        // Check for completion before the pop so that an event pushed just
+        // before the producer finished is not missed
+        bool done = producerDone_.load(std::memory_order_acquire);
+        if (queue_.tryPop(input)) {
+            consumed_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        if (done) {
+            return false;
+        }
+        backoff.pause();
+    }
+}
+
+std::string PrefetchingSource::describe() const {
+    return "prefetch(" + upstream_->describe() + ")";
+}
+
+nlohmann::json PrefetchingSource::statsToJson() const {
+    return {
+        {"depth", queue_.capacity()},
+        {"policy", policy_ == BackpressurePolicy::Block ? "block" : "drop"},
+        {"queued", queue_.size()},
+        {"high_water", highWater_.load(std::memory_order_relaxed)},
+        {"produced", produced_.load(std::memory_order_relaxed)},
+        {"consumed", consumed_.load(std::memory_order_relaxed)},
+        {"dropped", dropped_.load(std::memory_order_relaxed)},
+        {"producer_stalls", producerStalls_.load(std::memory_order_relaxed)},
+        {"consumer_starved", consumerStarved_.load(std::memory_order_relaxed)},
+        {"upstream", upstream_->statsToJson()}
+    };
+}
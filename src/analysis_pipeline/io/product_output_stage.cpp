@@ -0,0 +1,86 @@
+#include "analysis_pipeline/io/product_output_stage.h"
+
+#include <spdlog/spdlog.h>
+
+ProductOutputStage::ProductOutputStage(const nlohmann::json& params)
+    : path_(params.value("path", std::string())),
+      products_(params.value("products", std::vector<std::string>())),
+      allProducts_(!params.contains("products")),
+      deferOpen_(params.value("defer_open", false)),
+      writer_(std::make_unique<ProductWriter>(params.value("buffer_bytes", size_t(4) << 20))) {}
+
+ProductOutputStage::~ProductOutputStage() {
+    writer_->close();
+}
+
+void ProductOutputStage::OnInit() {
+    if (path_.empty()) {
+        spdlog::error("[ProductOutputStage] Missing 'path' parameter; nothing will be written.");
+        return;
+    }
+    if (deferOpen_) {
+        spdlog::debug("[ProductOutputStage] Opening '{}' deferred until openOutput().", path_);
+        return;
+    }
+    writer_->open(path_);
+}
+
+bool ProductOutputStage::openOutput(bool append, uint64_t firstEventIndex) {
+    if (path_.empty() || writer_->isOpen()) {
+        return writer_->isOpen();
+    }
+    eventIndex_ = append ? firstEventIndex : 0;
+    return writer_->open(path_, append);
+}
+
+uint64_t ProductOutputStage::closeOutput() {
+    writer_->close();
+    return eventIndex_;
+}
+
+void ProductOutputStage::Process() {
+    if (!writer_->isOpen()) {
+        return;
+    }
+
+    auto* manager = getDataProductManager();
+    if (allProducts_) {
+        products_ = manager->getAllNames();
+    }
+
+    writer_->beginEvent(eventIndex_++);
+    for (const auto& name : products_) {
+        if (!manager->hasProduct(name)) {
+            ++missing_;
+            continue;
+        }
+        auto product = manager->checkoutRead(name);
+        const TObject* obj = product->getObject();
+        if (!obj) {
+            ++missing_;
+            continue;
+        }
+        buffer_.Reset();
+        buffer_.WriteObject(obj);
+        writer_->addProduct(name, obj->ClassName(), buffer_.Buffer(), static_cast<size_t>(buffer_.Length()));
+    }
+    writer_->endEvent();
+}
+
+std::string ProductOutputStage::Name() const {
+    return "ProductOutputStage";
+}
+
+std::vector<std::string> ProductOutputStage::InputProducts() const {
+    return allProducts_ ? std::vector<std::string>() : products_;
+}
+
+std::vector<std::string> ProductOutputStage::OutputProducts() const {
+    return {};
+}
+
+nlohmann::json ProductOutputStage::statsToJson() const {
+    nlohmann::json stats = writer_->statsToJson();
+    stats["missing_products"] = missing_;
+    return stats;
+}
@@ -0,0 +1,173 @@
+#include "analysis_pipeline/io/product_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+ProductWriter::ProductWriter(size_t bufferBytes)
+    : bufferBytes_(std::max<size_t>(bufferBytes, 4096)) {}
+
+ProductWriter::~ProductWriter() {
+    close();
+}
+
+bool ProductWriter::open(const std::string& path, bool append) {
+    if (isOpen()) {
+        close();
+    }
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+    if (fd_ < 0) {
+        spdlog::error("[ProductWriter] Failed to open '{}': {}", path, std::strerror(errno));
+        return false;
+    }
+
+    path_ = path;
+    front_.clear();
+    front_.reserve(bufferBytes_ + bufferBytes_ / 4);
+    back_.clear();
+    back_.reserve(bufferBytes_ + bufferBytes_ / 4);
+    backFull_ = false;
+    stop_ = false;
+    writeFailed_ = false;
+    writer_ = std::thread([this]() { writerLoop(); });
+
+    spdlog::info("[ProductWriter] {} products to '{}'", append ? "Appending" : "Writing", path_);
+    return true;
+}
+
+bool ProductWriter::close() {
+    if (!isOpen()) {
+        return true;
+    }
+
+    if (!front_.empty()) {
+        swapBuffers();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    writer_.join();
+
+    bool ok = !writeFailed_.load();
+    if (::close(fd_) != 0) {
+        spdlog::error("[ProductWriter] Failed to close '{}': {}", path_, std::strerror(errno));
+        ok = false;
+    }
+    fd_ = -1;
+
+    spdlog::info("[ProductWriter] Wrote {} events ({} bytes) to '{}'",
+                 events_.load(), bytesWritten_.load(), path_);
+    return ok;
+}
+
+void ProductWriter::append(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    front_.insert(front_.end(), bytes, bytes + size);
+}
+
+void ProductWriter::beginEvent(uint64_t eventIndex) {
+    recordStart_ = front_.size();
+    recordProducts_ = 0;
+    appendValue<uint32_t>(0);  // record_bytes, patched in endEvent()
+    appendValue<uint64_t>(eventIndex);
+    appendValue<uint32_t>(0);  // product_count, patched in endEvent()
+}
+
+void ProductWriter::addProduct(const std::string& name, const std::string& className,
+                               const char* payload, size_t size) {
+    constexpr size_t maxString = std::numeric_limits<uint16_t>::max();
+    if (name.size() > maxString || className.size() > maxString ||
+        size > std::numeric_limits<uint32_t>::max()) {
+        spdlog::warn("[ProductWriter] Skipping oversized product '{}'", name.substr(0, 64));
+        return;
+    }
+    appendValue<uint16_t>(static_cast<uint16_t>(name.size()));
+    append(name.data(), name.size());
+    appendValue<uint16_t>(static_cast<uint16_t>(className.size()));
+    append(className.data(), className.size());
+    appendValue<uint32_t>(static_cast<uint32_t>(size));
+    append(payload, size);
+    ++recordProducts_;
+}
+
+void ProductWriter::endEvent() {
+    const uint32_t recordBytes = static_cast<uint32_t>(front_.size() - recordStart_ - sizeof(uint32_t));
+    std::memcpy(front_.data() + recordStart_, &recordBytes, sizeof(recordBytes));
+    std::memcpy(front_.data() + recordStart_ + sizeof(uint32_t) + sizeof(uint64_t),
+                &recordProducts_, sizeof(recordProducts_));
+    events_.fetch_add(1, std::memory_order_relaxed);
+
+    if (front_.size() >= bufferBytes_) {
+        swapBuffers();
+    }
+}
+
+void ProductWriter::flush() {
+    if (isOpen() && !front_.empty()) {
+        swapBuffers();
+    }
+}
+
+void ProductWriter::swapBuffers() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (backFull_) {
+        producerWaits_.fetch_add(1, std::memory_order_relaxed);
+        cv_.wait(lock, [this]() { return !backFull_; });
+    }
+    std::swap(front_, back_);
+    backFull_ = true;
+    lock.unlock();
+    cv_.notify_all();
+}
+
+void ProductWriter::writerLoop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return backFull_ || stop_; });
+            if (!backFull_) {
+                return;  // stopped with nothing pending
+            }
+        }
+
+        // The producer does not touch back_ while backFull_ is set
+        size_t done = 0;
+        while (done < back_.size() && !writeFailed_.load(std::memory_order_relaxed)) {
+            ssize_t n = ::write(fd_, back_.data() + done, back_.size() - done);
+            if (n > 0) {
+                done += static_cast<size_t>(n);
+            } else if (n < 0 && errno != EINTR) {
+                spdlog::error("[ProductWriter] Write to '{}' failed: {}", path_, std::strerror(errno));
+                writeFailed_.store(true);
+            }
+        }
+        bytesWritten_.fetch_add(done, std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            back_.clear();
+            backFull_ = false;
+        }
+        cv_.notify_all();
+    }
+}
+
+nlohmann::json ProductWriter::statsToJson() const {
+    return {
+        {"path", path_},
+        {"events", events_.load(std::memory_order_relaxed)},
+        {"bytes_written", bytesWritten_.load(std::memory_order_relaxed)},
+        {"buffer_bytes", bufferBytes_},
+        {"producer_waits", producerWaits_.load(std::memory_order_relaxed)},
+        {"failed", writeFailed_.load(std::memory_order_relaxed)}
+    };
+}
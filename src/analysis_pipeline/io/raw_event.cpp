@@ -0,0 +1,49 @@
+#include "analysis_pipeline/io/raw_event.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr size_t kLengthPrefixBytes = 4;
+constexpr size_t kMidasHeaderBytes = 16;
+constexpr size_t kMidasDataSizeOffset = 12;
+
+uint32_t readLittleEndian32(const std::byte* p) {
+    return static_cast<uint32_t>(p[0]) |
+           (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) |
+           (static_cast<uint32_t>(p[3]) << 24);
+}
+
+} // anonymous namespace
+
+std::optional<EventFraming> parseEventFraming(const std::string& name) {
+    if (name == "length_prefixed") {
+        return EventFraming::LengthPrefixed;
+    }
+    if (name == "midas") {
+        return EventFraming::Midas;
+    }
+    return std::nullopt;
+}
+
+size_t frameHeaderSize(EventFraming framing) {
+    return framing == EventFraming::Midas ? kMidasHeaderBytes : kLengthPrefixBytes;
+}
+
+size_t frameTotalSize(EventFraming framing, const std::byte* header) {
+    if (framing == EventFraming::Midas) {
+        return kMidasHeaderBytes + readLittleEndian32(header + kMidasDataSizeOffset);
+    }
+    return kLengthPrefixBytes + readLittleEndian32(header);
+}
+
+size_t framePayloadOffset(EventFraming framing) {
+    return framing == EventFraming::Midas ? 0 : kLengthPrefixBytes;
+}
+
+std::shared_ptr<const InputBundle> makeRawEventBundle(RawEvent event) {
+    auto bundle = std::make_shared<InputBundle>();
+    bundle->set<RawEvent>(std::move(event));
+    return bundle;
+}
@@ -0,0 +1,175 @@
+#include "analysis_pipeline/io/stream_event_source.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+bool startsWith(const std::string& s, const char* prefix) {
+    return s.rfind(prefix, 0) == 0;
+}
+
+int connectUnixSocket(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        int err = errno;
+        ::close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+} // anonymous namespace
+
+StreamEventSource::StreamEventSource(std::string location, EventFraming framing)
+    : location_(std::move(location)), framing_(framing),
+      header_(frameHeaderSize(framing)) {}
+
+StreamEventSource::~StreamEventSource() {
+    close();
+}
+
+bool StreamEventSource::open() {
+    if (fd_ >= 0) {
+        return true;
+    }
+
+    if (location_ == "-" || location_ == "pipe:-") {
+        fd_ = STDIN_FILENO;
+        owns_fd_ = false;
+    } else if (startsWith(location_, "unix:")) {
+        fd_ = connectUnixSocket(location_.substr(5));
+        owns_fd_ = true;
+    } else {
+        std::string path = location_;
+        if (startsWith(path, "file:") || startsWith(path, "pipe:")) {
+            path = path.substr(5);
+        }
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        owns_fd_ = true;
+    }
+
+    if (fd_ < 0) {
+        spdlog::error("[StreamEventSource] Failed to open '{}': {}", location_, std::strerror(errno));
+        failed_ = true;
+        return false;
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (owns_fd_) {
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+
+    spdlog::debug("[StreamEventSource] Opened '{}'", location_);
+    return true;
+}
+
+void StreamEventSource::close() {
+    if (fd_ >= 0 && owns_fd_) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    owns_fd_ = false;
+}
+
+size_t StreamEventSource::readFully(std::byte* out, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = ::read(fd_, out + done, size - done);
+        if (n > 0) {
+            done += static_cast<size_t>(n);
+        } else if (n == 0) {
+            break;
+        } else if (errno != EINTR) {
+            spdlog::error("[StreamEventSource] Read from '{}' failed: {}", location_, std::strerror(errno));
+            failed_ = true;
+            break;
+        }
+    }
+    return done;
+}
+
+bool StreamEventSource::readEvent(RawEvent& event) {
+    if (failed_ || (fd_ < 0 && !open())) {
+        return false;
+    }
+
+    const size_t headerSize = header_.size();
+    size_t got = readFully(header_.data(), headerSize);
+    if (got == 0) {
+        return false;  // clean end of stream
+    }
+    if (got < headerSize) {
+        spdlog::error("[StreamEventSource] Truncated frame header at event {} in '{}'",
+                      events_.load(std::memory_order_relaxed), location_);
+        failed_ = true;
+        return false;
+    }
+
+    const size_t total = frameTotalSize(framing_, header_.data());
+    if (total > max_event_bytes_) {
+        spdlog::error("[StreamEventSource] Frame of {} bytes at event {} exceeds limit of {} bytes",
+                      total, events_.load(std::memory_order_relaxed), max_event_bytes_);
+        failed_ = true;
+        return false;
+    }
+
+    auto buffer = std::make_shared<std::vector<std::byte>>(total);
+    std::memcpy(buffer->data(), header_.data(), headerSize);
+    const size_t body = total - headerSize;
+    if (readFully(buffer->data() + headerSize, body) < body) {
+        spdlog::error("[StreamEventSource] Truncated frame body at event {} in '{}'",
+                      events_.load(std::memory_order_relaxed), location_);
+        failed_ = true;
+        return false;
+    }
+
+    const size_t offset = framePayloadOffset(framing_);
+    event.index = events_.fetch_add(1, std::memory_order_relaxed);
+    event.data = buffer->data() + offset;
+    event.size = total - offset;
+    event.storage = std::move(buffer);
+    bytes_.fetch_add(total, std::memory_order_relaxed);
+    return true;
+}
+
+bool StreamEventSource::next(std::shared_ptr<const InputBundle>& input) {
+    RawEvent event;
+    if (!readEvent(event)) {
+        return false;
+    }
+    input = makeRawEventBundle(std::move(event));
+    return true;
+}
+
+std::string StreamEventSource::describe() const {
+    return location_;
+}
+
+nlohmann::json StreamEventSource::statsToJson() const {
+    return {
+        {"location", location_},
+        {"events", events_.load(std::memory_order_relaxed)},
+        {"bytes", bytes_.load(std::memory_order_relaxed)},
+        {"failed", failed_.load(std::memory_order_relaxed)}
+    };
+}
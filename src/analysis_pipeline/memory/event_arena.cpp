@@ -0,0 +1,143 @@
+#include "analysis_pipeline/memory/event_arena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace {
+thread_local EventArena* currentArena = nullptr;
+} // anonymous namespace
+
+EventArena::Chunk::Chunk(size_t bytes)
+    : data(new std::byte[bytes]), size(bytes) {}
+
+EventArena::EventArena(size_t initialBytes) {
+    chunks_.push_back(std::make_unique<Chunk>(std::max<size_t>(initialBytes, 4096)));
+    current_.store(chunks_.front().get(), std::memory_order_release);
+}
+
+void* EventArena::do_allocate(size_t bytes, size_t alignment) {
+    while (true) {
+        Chunk* chunk = current_.load(std::memory_order_acquire);
+        size_t used = chunk->used.load(std::memory_order_relaxed);
+
+        const auto base = reinterpret_cast<uintptr_t>(chunk->data.get());
+        const uintptr_t aligned = (base + used + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        const size_t end = static_cast<size_t>(aligned - base) + bytes;
+
+        if (end <= chunk->size) {
+            if (chunk->used.compare_exchange_weak(used, end, std::memory_order_relaxed)) {
+                return reinterpret_cast<void*>(aligned);
+            }
+            continue;
+        }
+
+        advance(chunk, bytes + alignment);
+    }
+}
+
+void EventArena::advance(Chunk* exhausted, size_t minimumBytes) {
+    std::lock_guard<std::mutex> lock(growMutex_);
+    if (current_.load(std::memory_order_relaxed) != exhausted) {
+        return; // another thread already moved on
+    }
+
+    overflows_.fetch_add(1, std::memory_order_relaxed);
+    ++currentIndex_;
+    if (currentIndex_ == chunks_.size() || chunks_[currentIndex_]->size < minimumBytes) {
+        const size_t bytes = std::max(minimumBytes, exhausted->size * 2);
+        chunks_.insert(chunks_.begin() + static_cast<std::ptrdiff_t>(currentIndex_), std::make_unique<Chunk>(bytes));
+    }
+    current_.store(chunks_[currentIndex_].get(), std::memory_order_release);
+}
+
+void EventArena::do_deallocate(void*, size_t, size_t) {
+    // Memory is reclaimed by reset()
+}
+
+bool EventArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+void EventArena::reset() {
+    std::lock_guard<std::mutex> lock(growMutex_);
+
+    highWaterBytes_ = std::max(highWaterBytes_, bytesInUseLocked());
+    ++resets_;
+
+    if (currentIndex_ > 0) {
+        // The event overflowed: replace the chunks by one that fits the high-water mark
+        const size_t capacity = capacityBytesLocked();
+        chunks_.clear();
+        chunks_.push_back(std::make_unique<Chunk>(std::max(capacity, highWaterBytes_)));
+    } else {
+        chunks_.front()->used.store(0, std::memory_order_relaxed);
+    }
+
+    currentIndex_ = 0;
+    current_.store(chunks_.front().get(), std::memory_order_release);
+}
+
+size_t EventArena::bytesInUseLocked() const {
+    size_t used = 0;
+    for (const auto& chunk : chunks_) {
+        used += chunk->used.load(std::memory_order_relaxed);
+    }
+    return used;
+}
+
+size_t EventArena::capacityBytesLocked() const {
+    size_t capacity = 0;
+    for (const auto& chunk : chunks_) {
+        capacity += chunk->size;
+    }
+    return capacity;
+}
+
+size_t EventArena::bytesInUse() const {
+    std::lock_guard<std::mutex> lock(growMutex_);
+    return bytesInUseLocked();
+}
+
+size_t EventArena::capacityBytes() const {
+    std::lock_guard<std::mutex> lock(growMutex_);
+    return capacityBytesLocked();
+}
+
+size_t EventArena::highWaterBytes() const {
+    std::lock_guard<std::mutex> lock(growMutex_);
+    return std::max(highWaterBytes_, bytesInUseLocked());
+}
+
+uint64_t EventArena::resetCount() const {
+    std::lock_guard<std::mutex> lock(growMutex_);
+    return resets_;
+}
+
+uint64_t EventArena::overflowCount() const {
+    return overflows_.load(std::memory_order_relaxed);
+}
+
+nlohmann::json EventArena::statsToJson() const {
+    std::lock_guard<std::mutex> lock(growMutex_);
+    const size_t used = bytesInUseLocked();
+    nlohmann::json j;
+    j["capacity_bytes"] = capacityBytesLocked();
+    j["in_use_bytes"] = used;
+    j["high_water_bytes"] = std::max(highWaterBytes_, used);
+    j["resets"] = resets_;
+    j["overflows"] = overflowCount();
+    return j;
+}
+
+EventArena* EventArena::current() {
+    return currentArena;
+}
+
+EventArena::Scope::Scope(EventArena* arena)
+    : previous_(currentArena) {
+    currentArena = arena;
+}
+
+EventArena::Scope::~Scope() {
+    currentArena = previous_;
+}
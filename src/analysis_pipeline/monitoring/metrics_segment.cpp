@@ -0,0 +1,253 @@
+#include "analysis_pipeline/monitoring/metrics_segment.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace L = MetricsSegmentLayout;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "metrics segment needs address-free 64-bit atomics");
+
+namespace {
+
+inline size_t stageBase(size_t stage) {
+    return L::kHeaderWords + L::kFieldCount + stage * L::kStageWords;
+}
+
+} // anonymous namespace
+
+// ---------------------------------------------------------------- writer
+
+MetricsSegmentWriter::~MetricsSegmentWriter() {
+    close();
+}
+
+bool MetricsSegmentWriter::create(const std::string& name, size_t stageCapacity) {
+    close();
+
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        // Most likely left behind by a run that did not shut down cleanly
+        spdlog::warn("[MetricsSegment] Replacing existing segment '{}'.", name);
+        ::shm_unlink(name.c_str());
+        fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if (fd < 0) {
+        spdlog::error("[MetricsSegment] Failed to create '{}': {}", name, std::strerror(errno));
+        return false;
+    }
+
+    const size_t words = L::wordCount(stageCapacity);
+    const size_t bytes = words * sizeof(uint64_t);
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        spdlog::error("[MetricsSegment] Failed to size '{}': {}", name, std::strerror(errno));
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* addr = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        spdlog::error("[MetricsSegment] Failed to map '{}': {}", name, std::strerror(errno));
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    words_ = static_cast<std::atomic<uint64_t>*>(addr);
+    for (size_t i = 0; i < words; ++i) {
+        new (&words_[i]) std::atomic<uint64_t>(0);
+    }
+    wordCount_ = words;
+    stageCapacity_ = stageCapacity;
+    name_ = name;
+
+    words_[L::kVersionWord].store(L::kVersion, std::memory_order_relaxed);
+    words_[L::kCapacityWord].store(stageCapacity, std::memory_order_relaxed);
+    // Readers accept the segment only once the magic is visible
+    words_[L::kMagicWord].store(L::kMagic, std::memory_order_release);
+
+    spdlog::info("[MetricsSegment] Publishing metrics to shared memory '{}' ({} bytes).", name, bytes);
+    return true;
+}
+
+void MetricsSegmentWriter::close() {
+    if (!words_) {
+        return;
+    }
+    ::munmap(words_, wordCount_ * sizeof(uint64_t));
+    ::shm_unlink(name_.c_str());
+    words_ = nullptr;
+    wordCount_ = 0;
+    stageCapacity_ = 0;
+    name_.clear();
+}
+
+void MetricsSegmentWriter::publish(const MetricsSample& sample) {
+    if (!words_) {
+        return;
+    }
+
+    std::atomic<uint64_t>& sequence = words_[L::kSequenceWord];
+    const uint64_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto field = [this](size_t f, uint64_t value) {
+        words_[L::kHeaderWords + f].store(value, std::memory_order_relaxed);
+    };
+    field(L::kPid, sample.pid);
+    field(L::kStartNs, sample.startNs);
+    field(L::kUpdateNs, sample.updateNs);
+    field(L::kUpdates, sample.updates);
+    field(L::kEvents, sample.events);
+    field(L::kInFlight, sample.inFlight);
+    field(L::kMaxInFlight, sample.maxInFlight);
+    field(L::kInputEvents, sample.inputEvents);
+    field(L::kInputBytes, sample.inputBytes);
+    field(L::kInputQueued, sample.inputQueued);
+    field(L::kInputHighWater, sample.inputHighWater);
+    field(L::kInputDropped, sample.inputDropped);
+
+    const size_t stageCount = std::min(sample.stages.size(), stageCapacity_);
+    field(L::kStageCount, stageCount);
+
+    for (size_t s = 0; s < stageCount; ++s) {
+        const auto& stage = sample.stages[s];
+        std::atomic<uint64_t>* base = words_ + stageBase(s);
+
+        uint64_t packed[L::kStageIdWords] = {};
+        std::memcpy(packed, stage.id.data(), std::min(stage.id.size(), L::kStageIdBytes - 1));
+        for (size_t w = 0; w < L::kStageIdWords; ++w) {
+            base[w].store(packed[w], std::memory_order_relaxed);
+        }
+        base[L::kCalls].store(stage.calls, std::memory_order_relaxed);
+        base[L::kTotalNs].store(stage.totalNs, std::memory_order_relaxed);
+        base[L::kMaxNs].store(stage.maxNs, std::memory_order_relaxed);
+        base[L::kQueueWaitNs].store(stage.queueWaitNs, std::memory_order_relaxed);
+        base[L::kRejected].store(stage.rejected, std::memory_order_relaxed);
+    }
+
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+// ---------------------------------------------------------------- reader
+
+MetricsSegmentReader::~MetricsSegmentReader() {
+    close();
+}
+
+bool MetricsSegmentReader::open(const std::string& name) {
+    close();
+
+    int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        spdlog::error("[MetricsSegment] Failed to open '{}': {}", name, std::strerror(errno));
+        return false;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < L::wordCount(0) * sizeof(uint64_t)) {
+        spdlog::error("[MetricsSegment] '{}' is not a metrics segment.", name);
+        ::close(fd);
+        return false;
+    }
+
+    const size_t bytes = static_cast<size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        spdlog::error("[MetricsSegment] Failed to map '{}': {}", name, std::strerror(errno));
+        return false;
+    }
+
+    const auto* words = static_cast<const std::atomic<uint64_t>*>(addr);
+    const uint64_t capacity = words[L::kCapacityWord].load(std::memory_order_relaxed);
+    if (words[L::kMagicWord].load(std::memory_order_acquire) != L::kMagic ||
+        words[L::kVersionWord].load(std::memory_order_relaxed) != L::kVersion ||
+        L::wordCount(capacity) * sizeof(uint64_t) > bytes) {
+        spdlog::error("[MetricsSegment] '{}' is not initialized or has an unknown layout.", name);
+        ::munmap(addr, bytes);
+        return false;
+    }
+
+    words_ = words;
+    wordCount_ = bytes / sizeof(uint64_t);
+    stageCapacity_ = capacity;
+    return true;
+}
+
+void MetricsSegmentReader::close() {
+    if (!words_) {
+        return;
+    }
+    ::munmap(const_cast<std::atomic<uint64_t>*>(words_), wordCount_ * sizeof(uint64_t));
+    words_ = nullptr;
+    wordCount_ = 0;
+    stageCapacity_ = 0;
+}
+
+bool MetricsSegmentReader::read(MetricsSample& sample, int maxRetries) const {
+    if (!words_) {
+        return false;
+    }
+
+    const std::atomic<uint64_t>& sequence = words_[L::kSequenceWord];
+    for (int attempt = 0; attempt <= maxRetries; ++attempt) {
+        const uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;  // writer is mid-update
+        }
+
+        auto field = [this](size_t f) {
+            return words_[L::kHeaderWords + f].load(std::memory_order_relaxed);
+        };
+        sample.pid = field(L::kPid);
+        sample.startNs = field(L::kStartNs);
+        sample.updateNs = field(L::kUpdateNs);
+        sample.updates = field(L::kUpdates);
+        sample.events = field(L::kEvents);
+        sample.inFlight = field(L::kInFlight);
+        sample.maxInFlight = field(L::kMaxInFlight);
+        sample.inputEvents = field(L::kInputEvents);
+        sample.inputBytes = field(L::kInputBytes);
+        sample.inputQueued = field(L::kInputQueued);
+        sample.inputHighWater = field(L::kInputHighWater);
+        sample.inputDropped = field(L::kInputDropped);
+
+        const size_t stageCount = std::min<size_t>(field(L::kStageCount), stageCapacity_);
+        sample.stages.resize(stageCount);
+        for (size_t s = 0; s < stageCount; ++s) {
+            const std::atomic<uint64_t>* base = words_ + stageBase(s);
+            auto& stage = sample.stages[s];
+
+            char id[L::kStageIdBytes];
+            for (size_t w = 0; w < L::kStageIdWords; ++w) {
+                const uint64_t packed = base[w].load(std::memory_order_relaxed);
+                std::memcpy(id + w * sizeof(uint64_t), &packed, sizeof(uint64_t));
+            }
+            id[L::kStageIdBytes - 1] = '\0';
+            stage.id.assign(id);
+            stage.calls = base[L::kCalls].load(std::memory_order_relaxed);
+            stage.totalNs = base[L::kTotalNs].load(std::memory_order_relaxed);
+            stage.maxNs = base[L::kMaxNs].load(std::memory_order_relaxed);
+            stage.queueWaitNs = base[L::kQueueWaitNs].load(std::memory_order_relaxed);
+            stage.rejected = base[L::kRejected].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,109 @@
+#include "analysis_pipeline/monitoring/product_json_cache.h"
+
+#include <unordered_set>
+
+void ProductJsonCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.clear();
+    generations_.reset();
+    entries_.clear();
+    hits_ = 0;
+    misses_ = 0;
+}
+
+size_t ProductJsonCache::track(const std::string& name) {
+    auto it = slots_.emplace(name, slots_.size()).first;
+    return it->second;
+}
+
+void ProductJsonCache::finalizeTracking() {
+    generations_ = std::make_unique<std::atomic<uint64_t>[]>(slots_.size());
+}
+
+bool ProductJsonCache::generationOf(const std::string& name, uint64_t& generation) const {
+    auto it = slots_.find(name);
+    if (it == slots_.end() || !generations_) {
+        return false;
+    }
+    generation = generations_[it->second].load(std::memory_order_acquire);
+    return true;
+}
+
+const nlohmann::json& ProductJsonCache::refresh(PipelineDataProductManager& manager,
+                                                const std::string& name, Entry& entry,
+                                                bool tracked, uint64_t generation) {
+    if (tracked && entry.cached && entry.cachedGeneration == generation) {
+        ++hits_;
+        return entry.value;
+    }
+    entry.value = manager.checkoutRead(name)->serializeToJson();
+    entry.cachedGeneration = generation;
+    entry.cached = true;
+    ++misses_;
+    return entry.value;
+}
+
+nlohmann::json ProductJsonCache::serializeDelta(PipelineDataProductManager& manager) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nlohmann::json changed = nlohmann::json::object();
+    nlohmann::json removed = nlohmann::json::array();
+
+    std::unordered_set<std::string> present;
+    for (const auto& name : manager.getAllNames()) {
+        present.insert(name);
+        uint64_t generation = 0;
+        const bool tracked = generationOf(name, generation);
+        Entry& entry = entries_[name];
+
+        if (tracked) {
+            if (entry.reported && entry.reportedGeneration == generation) {
+                ++hits_;
+                continue;
+            }
+            changed[name] = refresh(manager, name, entry, true, generation);
+            entry.reportedGeneration = generation;
+        } else {
+            const nlohmann::json& value = refresh(manager, name, entry, false, 0);
+            if (entry.reported && entry.reportedValue == value) {
+                continue;
+            }
+            entry.reportedValue = value;
+            changed[name] = value;
+        }
+        entry.reported = true;
+    }
+
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (present.count(it->first)) {
+            ++it;
+            continue;
+        }
+        if (it->second.reported) {
+            removed.push_back(it->first);
+        }
+        it = entries_.erase(it);
+    }
+
+    return {{"changed", std::move(changed)}, {"removed", std::move(removed)}};
+}
+
+nlohmann::json ProductJsonCache::serializeAll(PipelineDataProductManager& manager) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nlohmann::json result = nlohmann::json::object();
+    for (const auto& name : manager.getAllNames()) {
+        uint64_t generation = 0;
+        const bool tracked = generationOf(name, generation);
+        result[name] = refresh(manager, name, entries_[name], tracked, generation);
+    }
+    return result;
+}
+
+nlohmann::json ProductJsonCache::statsToJson() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {
+        {"tracked_products", slots_.size()},
+        {"cached_products", entries_.size()},
+        {"hits", hits_},
+        {"misses", misses_}
+    };
+}
@@ -0,0 +1,128 @@
+#include "analysis_pipeline/monitoring/stage_metrics.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Single-writer update: only the owning thread stores into its Local
+inline void addRelaxed(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+inline size_t bucketFor(uint64_t ns) {
+    size_t bucket = 0;
+    while (ns > 1 && bucket + 1 < StageMetrics::kHistogramBuckets) {
+        ns >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+} // anonymous namespace
+
+uint64_t StageMetrics::nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void StageMetrics::record(uint64_t durationNs, uint64_t queueWaitNs) {
+    Local& local = locals_.local();
+
+    addRelaxed(local.calls, 1);
+    addRelaxed(local.totalNs, durationNs);
+    addRelaxed(local.totalQueueNs, queueWaitNs);
+    addRelaxed(local.histogram[bucketFor(durationNs)], 1);
+
+    if (durationNs < local.minNs.load(std::memory_order_relaxed)) {
+        local.minNs.store(durationNs, std::memory_order_relaxed);
+    }
+    if (durationNs > local.maxNs.load(std::memory_order_relaxed)) {
+        local.maxNs.store(durationNs, std::memory_order_relaxed);
+    }
+    if (queueWaitNs > local.maxQueueNs.load(std::memory_order_relaxed)) {
+        local.maxQueueNs.store(queueWaitNs, std::memory_order_relaxed);
+    }
+}
+
+void StageMetrics::recordRejected() {
+    addRelaxed(locals_.local().rejected, 1);
+}
+
+StageMetrics::Snapshot StageMetrics::snapshot() const {
+    Snapshot snap;
+    uint64_t minNs = UINT64_MAX;
+
+    for (const Local& local : locals_) {
+        snap.calls += local.calls.load(std::memory_order_relaxed);
+        snap.totalNs += local.totalNs.load(std::memory_order_relaxed);
+        snap.totalQueueNs += local.totalQueueNs.load(std::memory_order_relaxed);
+        snap.rejected += local.rejected.load(std::memory_order_relaxed);
+        minNs = std::min(minNs, local.minNs.load(std::memory_order_relaxed));
+        snap.maxNs = std::max(snap.maxNs, local.maxNs.load(std::memory_order_relaxed));
+        snap.maxQueueNs = std::max(snap.maxQueueNs, local.maxQueueNs.load(std::memory_order_relaxed));
+        for (size_t b = 0; b < kHistogramBuckets; ++b) {
+            snap.histogram[b] += local.histogram[b].load(std::memory_order_relaxed);
+        }
+    }
+
+    snap.minNs = snap.calls > 0 ? minNs : 0;
+    return snap;
+}
+
+void StageMetrics::reset() {
+    locals_.clear();
+}
+
+double StageMetrics::Snapshot::percentileNs(double q) const {
+    uint64_t count = 0;
+    for (uint64_t c : histogram) {
+        count += c;
+    }
+    if (count == 0) {
+        return 0.0;
+    }
+
+    const double target = std::clamp(q, 0.0, 1.0) * static_cast<double>(count);
+    double seen = 0.0;
+    for (size_t b = 0; b < kHistogramBuckets; ++b) {
+        if (histogram[b] == 0) {
+            continue;
+        }
+        const double next = seen + static_cast<double>(histogram[b]);
+        if (next >= target) {
+            const double lower = b == 0 ? 0.0 : static_cast<double>(1ULL << b);
+            const double upper = static_cast<double>(1ULL << (b + 1));
+            const double fraction = (target - seen) / static_cast<double>(histogram[b]);
+            return std::clamp(lower + fraction * (upper - lower),
+                              static_cast<double>(minNs), static_cast<double>(maxNs));
+        }
+        seen = next;
+    }
+    return static_cast<double>(maxNs);
+}
+
+nlohmann::json StageMetrics::Snapshot::toJson() const {
+    nlohmann::json j;
+    j["calls"] = calls;
+    j["total_ns"] = totalNs;
+    j["mean_ns"] = calls > 0 ? static_cast<double>(totalNs) / static_cast<double>(calls) : 0.0;
+    j["min_ns"] = minNs;
+    j["max_ns"] = maxNs;
+    j["p50_ns"] = percentileNs(0.50);
+    j["p90_ns"] = percentileNs(0.90);
+    j["p99_ns"] = percentileNs(0.99);
+    j["queue_wait_total_ns"] = totalQueueNs;
+    j["queue_wait_mean_ns"] = calls > 0 ? static_cast<double>(totalQueueNs) / static_cast<double>(calls) : 0.0;
+    j["queue_wait_max_ns"] = maxQueueNs;
+    j["rejected"] = rejected;
+
+    nlohmann::json buckets = nlohmann::json::object();
+    for (size_t b = 0; b < kHistogramBuckets; ++b) {
+        if (histogram[b] > 0) {
+            buckets[std::to_string(1ULL << b)] = histogram[b];
+        }
+    }
+    j["histogram_ns"] = std::move(buckets);
+    return j;
+}
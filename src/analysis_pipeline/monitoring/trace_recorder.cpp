@@ -0,0 +1,71 @@
+#include "analysis_pipeline/monitoring/trace_recorder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+namespace {
+std::atomic<int> nextThreadId{1};
+} // anonymous namespace
+
+TraceRecorder::ThreadBuffer::ThreadBuffer()
+    : threadId(nextThreadId.fetch_add(1, std::memory_order_relaxed)) {}
+
+void TraceRecorder::start(uint64_t firstEvent, uint64_t eventCount) {
+    clear();
+    windowBegin_.store(firstEvent, std::memory_order_relaxed);
+    windowEnd_.store(firstEvent + eventCount, std::memory_order_relaxed);
+}
+
+void TraceRecorder::clear() {
+    windowBegin_.store(0, std::memory_order_relaxed);
+    windowEnd_.store(0, std::memory_order_relaxed);
+    for (auto& buffer : buffers_) {
+        buffer.entries.clear();
+    }
+}
+
+void TraceRecorder::record(size_t stageIndex, uint64_t eventIndex, uint64_t startNs, uint64_t durationNs) {
+    buffers_.local().entries.push_back({stageIndex, eventIndex, startNs, durationNs});
+}
+
+bool TraceRecorder::write(const std::string& path, const std::vector<std::string>& stageNames) const {
+    uint64_t originNs = std::numeric_limits<uint64_t>::max();
+    for (const auto& buffer : buffers_) {
+        for (const auto& entry : buffer.entries) {
+            originNs = std::min(originNs, entry.startNs);
+        }
+    }
+
+    nlohmann::json events = nlohmann::json::array();
+    for (const auto& buffer : buffers_) {
+        for (const auto& entry : buffer.entries) {
+            nlohmann::json ev;
+            ev["name"] = entry.stage < stageNames.size() ? stageNames[entry.stage] : std::to_string(entry.stage);
+            ev["cat"] = "stage";
+            ev["ph"] = "X";
+            ev["ts"] = static_cast<double>(entry.startNs - originNs) / 1000.0;
+            ev["dur"] = static_cast<double>(entry.durationNs) / 1000.0;
+            ev["pid"] = 1;
+            ev["tid"] = buffer.threadId;
+            ev["args"] = {{"event", entry.event}};
+            events.push_back(std::move(ev));
+        }
+    }
+
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        spdlog::error("[TraceRecorder] Could not open trace file: {}", path);
+        return false;
+    }
+
+    nlohmann::json trace;
+    trace["traceEvents"] = std::move(events);
+    trace["displayTimeUnit"] = "ns";
+    out << trace.dump();
+    spdlog::info("[TraceRecorder] Wrote {} trace event(s) to {}", trace["traceEvents"].size(), path);
+    return true;
+}
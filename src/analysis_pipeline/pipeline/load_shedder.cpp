@@ -0,0 +1,124 @@
+#include "analysis_pipeline/pipeline/load_shedder.h"
+
+#include <spdlog/spdlog.h>
+
+#include "analysis_pipeline/monitoring/stage_metrics.h"
+
+void LoadShedder::configure(const OverloadConfig& config, std::vector<std::string> stageIds) {
+    clear();
+    enabled_ = config.configured();
+    budgetNs_ = static_cast<uint64_t>(config.latencyBudgetMs * 1e6);
+    queueHigh_ = config.queueHigh;
+    queueLow_ = config.queueLow;
+    holdNs_ = static_cast<uint64_t>(config.holdMs * 1e6);
+
+    stageIds_ = std::move(stageIds);
+    shed_ = std::make_unique<std::atomic<uint64_t>[]>(stageIds_.size());
+    resetCounters();
+}
+
+void LoadShedder::clear() {
+    enabled_ = false;
+    budgetNs_ = 0;
+    queueHigh_ = 0;
+    queueLow_ = 0;
+    holdNs_ = 0;
+    overloaded_.store(false);
+    overloadSinceNs_.store(0);
+    lastLateNs_.store(0);
+    stageIds_.clear();
+    shed_.reset();
+}
+
+bool LoadShedder::admit(size_t queuedEvents, uint64_t nowNs) {
+    if (!overloaded_.load(std::memory_order_relaxed)) {
+        if (queueHigh_ != 0 && queuedEvents >= queueHigh_) {
+            enter(nowNs);
+        }
+    } else {
+        const bool queueDrained = queueHigh_ == 0 || queuedEvents <= queueLow_;
+        const uint64_t lastLateNs = lastLateNs_.load(std::memory_order_relaxed);
+        const bool onTime = nowNs >= lastLateNs && nowNs - lastLateNs >= holdNs_;
+        if (queueDrained && onTime) {
+            leave(nowNs);
+        }
+    }
+
+    if (overloaded_.load(std::memory_order_relaxed)) {
+        degradedEvents_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void LoadShedder::retired(uint64_t admitNs, uint64_t nowNs) {
+    if (budgetNs_ == 0 || nowNs - admitNs <= budgetNs_) {
+        return;
+    }
+    lateEvents_.fetch_add(1, std::memory_order_relaxed);
+    lastLateNs_.store(nowNs, std::memory_order_relaxed);
+    if (!overloaded_.load(std::memory_order_relaxed)) {
+        enter(nowNs);
+    }
+}
+
+void LoadShedder::enter(uint64_t nowNs) {
+    // Hold counts from entry even when the queue, not latency, triggered it
+    lastLateNs_.store(nowNs, std::memory_order_relaxed);
+    if (overloaded_.exchange(true, std::memory_order_relaxed)) {
+        return;
+    }
+    overloadSinceNs_.store(nowNs, std::memory_order_relaxed);
+    overloadEntries_.fetch_add(1, std::memory_order_relaxed);
+    spdlog::warn("[LoadShedder] Overload: shedding optional stages.");
+}
+
+void LoadShedder::leave(uint64_t nowNs) {
+    if (!overloaded_.exchange(false, std::memory_order_relaxed)) {
+        return;
+    }
+    const uint64_t sinceNs = overloadSinceNs_.load(std::memory_order_relaxed);
+    const uint64_t durationNs = nowNs > sinceNs ? nowNs - sinceNs : 0;
+    overloadNs_.fetch_add(durationNs, std::memory_order_relaxed);
+    spdlog::info("[LoadShedder] Overload cleared after {:.1f} ms.", durationNs / 1e6);
+}
+
+void LoadShedder::recordShed(size_t stageIndex) {
+    if (stageIndex < stageIds_.size()) {
+        shed_[stageIndex].fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+nlohmann::json LoadShedder::toJson() const {
+    nlohmann::json j;
+    const bool overloaded = overloaded_.load(std::memory_order_relaxed);
+    uint64_t overloadNs = overloadNs_.load(std::memory_order_relaxed);
+    if (overloaded) {
+        const uint64_t nowNs = StageMetrics::nowNs();
+        const uint64_t sinceNs = overloadSinceNs_.load(std::memory_order_relaxed);
+        overloadNs += nowNs > sinceNs ? nowNs - sinceNs : 0;
+    }
+    j["overloaded"] = overloaded;
+    j["overload_entries"] = overloadEntries_.load(std::memory_order_relaxed);
+    j["overload_ms"] = overloadNs / 1e6;
+    j["degraded_events"] = degradedEvents_.load(std::memory_order_relaxed);
+    j["late_events"] = lateEvents_.load(std::memory_order_relaxed);
+    j["shed"] = nlohmann::json::object();
+    for (size_t i = 0; i < stageIds_.size(); ++i) {
+        const uint64_t shed = shed_[i].load(std::memory_order_relaxed);
+        if (shed != 0) {
+            j["shed"][stageIds_[i]] = shed;
+        }
+    }
+    return j;
+}
+
+void LoadShedder::resetCounters() {
+    overloadEntries_.store(0);
+    overloadNs_.store(0);
+    degradedEvents_.store(0);
+    lateEvents_.store(0);
+    for (size_t i = 0; i < stageIds_.size(); ++i) {
+        shed_[i].store(0);
+    }
+}
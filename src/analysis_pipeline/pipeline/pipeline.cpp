@@ -1,20 +1,93 @@
 #include "analysis_pipeline/pipeline/pipeline.h"
 
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+#include <unistd.h>
+
+#include <tbb/task_group.h>
+
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+#include <spdlog/sinks/stdout_sinks.h>
+#include <spdlog/async.h>
 
+#include <TBufferFile.h>
 #include <TClass.h>
+#include <TH1.h>
 #include <TROOT.h>
 #include <TSystem.h>
 
 #include "analysis_pipeline/root_util/root_logger.h"
+#include "analysis_pipeline/io/product_output_stage.h"
+
+std::mutex Pipeline::stageFactoriesMutex_;
+std::map<std::string, Pipeline::StageFactory> Pipeline::stageFactories_;
+std::mutex Pipeline::stageClassCacheMutex_;
+std::unordered_map<std::string, TClass*> Pipeline::stageClassCache_;
+
+namespace {
+
+// Stages shipped with the framework itself rather than a plugin library
+void registerBuiltinStages() {
+    static std::once_flag once;
+    std::call_once(once, []() {
+        Pipeline::registerStageFactory("ProductOutputStage", [](const nlohmann::json& params) -> BaseStage* {
+            return new ProductOutputStage(params);
+        });
+    });
+}
+
+// Copy of a product object, kept out of gDirectory like the histograms stages create
+std::unique_ptr<TObject> detachedClone(const TObject& object) {
+    std::unique_ptr<TObject> copy(object.Clone());
+    if (auto* hist = dynamic_cast<TH1*>(copy.get())) {
+        hist->SetDirectory(nullptr);
+    }
+    return copy;
+}
+
+// Copies product 'name' into another manager; false if there is nothing to copy
+bool copyProduct(PipelineDataProductManager& from, PipelineDataProductManager& to, const std::string& name) {
+    if (!from.hasProduct(name)) {
+        return false;
+    }
+    std::unique_ptr<TObject> copy;
+    {
+        auto product = from.checkoutRead(name);
+        if (const TObject* object = product->getObject()) {
+            copy = detachedClone(*object);
+        }
+    }
+    if (!copy) {
+        return false;
+    }
+    auto product = std::make_unique<PipelineDataProduct>();
+    product->setName(name);
+    product->setObject(std::move(copy));
+    to.addOrUpdate(name, std::move(product));
+    return true;
+}
+
+} // anonymous namespace
 
 Pipeline::Pipeline(std::shared_ptr<ConfigManager> configManager)
-    : configManager_(std::move(configManager)),
+    : graph_(std::make_unique<tbb::flow::graph>()),
+      configManager_(std::move(configManager)),
       enable_thread_safety_if_needed_(true) // default true
 {
     RootLogger::instance(); // Initialize ROOT logger for error handling
+    registerBuiltinStages();
+}
+
+Pipeline::~Pipeline() {
+    // The publisher samples stage metrics and the executor, which go away below
+    stopMetricsPublisher();
+    // Scheduled runs use the stages
+    scheduler_.clear();
 }
 
 std::shared_ptr<ConfigManager> Pipeline::getConfigManager() const {
@@ -33,30 +106,85 @@ void Pipeline::setEnableThreadSafetyIfNeeded(bool enable) {
     enable_thread_safety_if_needed_ = enable;
 }
 
-BaseStage* Pipeline::createStageInstance(const std::string& type, const nlohmann::json& params) {
-    spdlog::debug("[Pipeline] Creating stage of type '{}'", type);
-    spdlog::debug("[Pipeline] Parameters: {}", params.dump(4));
+void Pipeline::registerStageFactory(const std::string& type, StageFactory factory) {
+    std::lock_guard<std::mutex> lock(stageFactoriesMutex_);
+    stageFactories_[type] = std::move(factory);
+}
+
+void Pipeline::unregisterStageFactory(const std::string& type) {
+    std::lock_guard<std::mutex> lock(stageFactoriesMutex_);
+    stageFactories_.erase(type);
+}
+
+TClass* Pipeline::findStageClass(const std::string& type) {
+    {
+        std::lock_guard<std::mutex> lock(stageClassCacheMutex_);
+        auto it = stageClassCache_.find(type);
+        if (it != stageClassCache_.end()) {
+            return it->second;
+        }
+    }
 
+    // Misses are not cached: the class may come from a plugin loaded later
     TClass* cls = TClass::GetClass(type.c_str());
-    if (!cls) {
-        spdlog::error("[Pipeline] Class '{}' not found in ROOT dictionary.", type);
-        return nullptr;
+    if (cls) {
+        std::lock_guard<std::mutex> lock(stageClassCacheMutex_);
+        stageClassCache_[type] = cls;
     }
+    return cls;
+}
 
-    TObject* obj = static_cast<TObject*>(cls->New());
-    if (!obj) {
-        spdlog::error("[Pipeline] Failed to instantiate class '{}'.", type);
-        return nullptr;
+BaseStage* Pipeline::createStageInstance(const std::string& type, const nlohmann::json& params,
+                                         StageStartupTiming* timing, PipelineDataProductManager* products) {
+    spdlog::debug("[Pipeline] Creating stage of type '{}'", type);
+    spdlog::debug("[Pipeline] Parameters: {}", params.dump(4));
+
+    const uint64_t constructStartNs = StageMetrics::nowNs();
+
+    StageFactory factory;
+    {
+        std::lock_guard<std::mutex> lock(stageFactoriesMutex_);
+        auto it = stageFactories_.find(type);
+        if (it != stageFactories_.end()) {
+            factory = it->second;
+        }
     }
 
-    BaseStage* stage = dynamic_cast<BaseStage*>(obj);
-    if (!stage) {
-        spdlog::error("[Pipeline] Created object is not a BaseStage.");
-        delete obj;
-        return nullptr;
+    BaseStage* stage = nullptr;
+    if (factory) {
+        stage = factory(params);
+        if (!stage) {
+            spdlog::error("[Pipeline] Factory for '{}' returned no stage.", type);
+            return nullptr;
+        }
+    } else {
+        TClass* cls = findStageClass(type);
+        if (!cls) {
+            spdlog::error("[Pipeline] Class '{}' not found in ROOT dictionary.", type);
+            return nullptr;
+        }
+
+        TObject* obj = static_cast<TObject*>(cls->New());
+        if (!obj) {
+            spdlog::error("[Pipeline] Failed to instantiate class '{}'.", type);
+            return nullptr;
+        }
+
+        stage = dynamic_cast<BaseStage*>(obj);
+        if (!stage) {
+            spdlog::error("[Pipeline] Created object is not a BaseStage.");
+            delete obj;
+            return nullptr;
+        }
     }
 
-    stage->Init(params, &dataProductManager_);
+    const uint64_t initStartNs = StageMetrics::nowNs();
+    stage->Init(params, products ? products : &dataProductManager_);
+
+    if (timing) {
+        timing->constructNs = initStartNs - constructStartNs;
+        timing->initNs = StageMetrics::nowNs() - initStartNs;
+    }
     return stage;
 }
 
@@ -68,25 +196,86 @@ void Pipeline::configureLogger(const nlohmann::json& loggerConfig) {
         }
 
         std::vector<spdlog::sink_ptr> sinks;
-        if (loggerConfig.value("console_enabled", true)) {
-            sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
-        }
+        if (loggerConfig.contains("sinks")) {
+            const auto& sinksConfig = loggerConfig["sinks"];
+
+            const nlohmann::json console = sinksConfig.value("console", nlohmann::json::object());
+            if (console.value("enabled", true)) {
+                if (console.value("color", true)) {
+                    sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+                } else {
+                    sinks.push_back(std::make_shared<spdlog::sinks::stdout_sink_mt>());
+                }
+            }
 
-        if (loggerConfig.value("file_enabled", false)) {
-            if (loggerConfig.contains("file_path")) {
-                sinks.push_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>(
-                    loggerConfig["file_path"].get<std::string>(), true));
+            const nlohmann::json file = sinksConfig.value("file", nlohmann::json::object());
+            if (file.value("enabled", false)) {
+                const std::string filename = file.value("filename", std::string("logs/app.log"));
+                const size_t maxSize = file.value("max_size", size_t(0));
+                if (maxSize > 0) {
+                    sinks.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+                        filename, maxSize, file.value("max_files", size_t(3))));
+                } else {
+                    sinks.push_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>(filename, true));
+                }
+            }
+        } else {
+            // Flat legacy keys
+            if (loggerConfig.value("console_enabled", true)) {
+                sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+            }
+
+            if (loggerConfig.value("file_enabled", false)) {
+                if (loggerConfig.contains("file_path")) {
+                    sinks.push_back(std::make_shared<spdlog::sinks::basic_file_sink_mt>(
+                        loggerConfig["file_path"].get<std::string>(), true));
+                }
             }
         }
 
         std::string loggerName = loggerConfig.value("name", "pipeline_logger");
-        auto logger = std::make_shared<spdlog::logger>(loggerName, sinks.begin(), sinks.end());
+        std::shared_ptr<spdlog::logger> logger;
+
+        // Async mode: callers only enqueue; formatting and sink I/O happen on
+        // the logger's own thread(s), so workers never contend on sink mutexes
+        const nlohmann::json asyncConfig = loggerConfig.value("async", nlohmann::json::object());
+        if (asyncConfig.value("enabled", false)) {
+            const size_t queueSize = asyncConfig.value("queue_size", size_t(8192));
+            const size_t threads = std::max<size_t>(1, asyncConfig.value("threads", size_t(1)));
+            const std::string policyName = asyncConfig.value("overflow_policy", std::string("block"));
+
+            auto policy = spdlog::async_overflow_policy::block;
+            if (policyName == "overrun_oldest") {
+                policy = spdlog::async_overflow_policy::overrun_oldest;
+            } else if (policyName != "block") {
+                spdlog::warn("[Pipeline] Unknown async overflow_policy '{}', using 'block'.", policyName);
+            }
+
+            // The pool is process-wide and created once. Replacing it on a
+            // reload or replica build would pull it from under async loggers
+            // that are still in use, so later queue_size/threads are ignored.
+            {
+                static std::mutex threadPoolMutex;
+                std::lock_guard<std::mutex> lock(threadPoolMutex);
+                if (!spdlog::thread_pool()) {
+                    spdlog::init_thread_pool(queueSize, threads);
+                }
+            }
+            logger = std::make_shared<spdlog::async_logger>(
+                loggerName, sinks.begin(), sinks.end(), spdlog::thread_pool(), policy);
+        } else {
+            logger = std::make_shared<spdlog::logger>(loggerName, sinks.begin(), sinks.end());
+        }
         spdlog::set_default_logger(logger);
 
         logger->set_pattern(loggerConfig.value("pattern", "[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] %v"));
         logger->set_level(level);
+        if (loggerConfig.contains("flush_level")) {
+            logger->flush_on(spdlog::level::from_str(loggerConfig["flush_level"].get<std::string>()));
+        }
 
-        spdlog::debug("[Pipeline] Logger '{}' configured.", loggerName);
+        spdlog::debug("[Pipeline] Logger '{}' configured ({} sink(s){}).", loggerName, sinks.size(),
+                      asyncConfig.value("enabled", false) ? ", async" : "");
     } catch (const std::exception& e) {
         spdlog::error("[Pipeline] Logger config error: {}", e.what());
     }
@@ -104,9 +293,14 @@ bool Pipeline::buildFromConfig() {
         configureLogger(loggerConfig);
     }
 
+    const uint64_t buildStartNs = StageMetrics::nowNs();
+    startupReport_ = nlohmann::json::object();
+    nlohmann::json pluginTimings = nlohmann::json::array();
+
     // 2. Load plugin libraries
     const auto& pluginLibs = configManager_->getPluginLibraries();
     for (const auto& libPath : pluginLibs) {
+        const uint64_t loadStartNs = StageMetrics::nowNs();
         std::filesystem::path path(libPath);
         if (path.is_relative()) {
             std::filesystem::path baseDir = std::filesystem::current_path();
@@ -120,121 +314,1471 @@ bool Pipeline::buildFromConfig() {
         } else {
             spdlog::info("[Pipeline] Successfully loaded plugin: {}", path.string());
         }
+        pluginTimings.push_back({{"path", path.string()},
+                                 {"ms", (StageMetrics::nowNs() - loadStartNs) / 1e6},
+                                 {"loaded", status >= 0}});
     }
 
     // 3. Setup pipeline graph and stages
-    const auto& stagesConfig = configManager_->getPipelineStages();
+    // Copied: 'next' is rewritten below when edges are derived from products
+    std::vector<StageConfig> stagesConfig = configManager_->getPipelineStages();
     if (stagesConfig.empty()) {
         spdlog::error("[Pipeline] No pipeline stages loaded.");
         return false;
     }
 
-    graph_.reset();
+    // Recreated at the end of the build, sized for the new stages
+    stopMetricsPublisher();
+    scheduler_.clear();
+    scheduledByIndex_.clear();
+    loadShedder_.clear();
+    optionalByIndex_.clear();
+
+    executor_.reset();
     nodes_.clear();
+    graph_.reset();
+    fusedChains_.clear();
     stages_.clear();
     incomingCount_.clear();
     startNodes_.clear();
     input_stages_.clear();
+    topology_.clear();
+    stageByIndex_.clear();
+    inputStageByIndex_.clear();
+    batchStageByIndex_.clear();
+    sharedInputStageByIndex_.clear();
+    filterStageByIndex_.clear();
+    activatesByIndex_.clear();
+    stageArenaByIndex_.clear();
+    shared_input_stages_.clear();
+    allStagesBatchCapable_ = true;
+    stageMetrics_.clear();
+    trace_.clear();
+    productJsonCache_.clear();
+    stageOutputSlots_.clear();
+    productTable_.clear();
+    stageOutputHandles_.clear();
+    stageCopiedHandles_.clear();
+    slotProductCopies_.clear();
+    indirectReaders_.clear();
+    stageProducts_.clear();
+
+    // Detect parallelism flag
+    parallelismDetected_ = false;
 
-    // Initialize incoming counts
-    for (const auto& sc : stagesConfig) {
-        incomingCount_[sc.id] = 0;
+    if (!taskArenas_.configure(configManager_->getExecutionConfig())) {
+        spdlog::error("[Pipeline] Failed to set up the task arenas from the 'execution' config.");
+        graph_ = std::make_unique<tbb::flow::graph>();
+        return false;
     }
+    graph_ = taskArenas_.execute([] { return std::make_unique<tbb::flow::graph>(); });
 
-    // Detect parallelism flag
-    bool parallelismDetected = false;
+    if (deferOutputFiles_) {
+        for (auto& sc : stagesConfig) {
+            if (sc.type == "ProductOutputStage" && sc.parameters.is_object()) {
+                sc.parameters["defer_open"] = true;
+            }
+        }
+    }
+
+    // 3a. Settle the edges the config declares ('next' and product
+    // parameters), so stages can be initialized in dependency order
+    std::vector<StageProducts> stageProducts(stagesConfig.size());
+    for (size_t i = 0; i < stagesConfig.size(); ++i) {
+        stageProducts[i] = declaredProducts(stagesConfig[i]);
+    }
+    if (!dependencies_.derive(stagesConfig, stageProducts, configManager_->getEdgeMode())) {
+        return false;
+    }
+    StageTopology declaredTopology;
+    if (!declaredTopology.build(stagesConfig)) {
+        return false;
+    }
 
-    for (const auto& sc : stagesConfig) {
+    // Leave out the stages none of the requested outputs depend on before
+    // any is constructed, so pruned stages cost nothing and open no files
+    prunedStages_.clear();
+    const OutputsConfig outputs = requestedOutputs_ ? *requestedOutputs_ : configManager_->getOutputsConfig();
+    if (!outputs.empty()) {
+        std::vector<std::string> unknown;
+        const StageDemand demand = StageDemand::resolve(declaredTopology, stageProducts, outputs, unknown);
+        if (!unknown.empty()) {
+            spdlog::error("[Pipeline] Requested outputs match no stage or written product: {}",
+                          nlohmann::json(unknown).dump());
+            return false;
+        }
+
+        std::set<std::string> keptIds;
+        size_t kept = 0;
+        for (size_t i = 0; i < stagesConfig.size(); ++i) {
+            if (!demand.needs(i)) {
+                prunedStages_.push_back(stagesConfig[i].id);
+                continue;
+            }
+            keptIds.insert(stagesConfig[i].id);
+            if (kept != i) {
+                stagesConfig[kept] = std::move(stagesConfig[i]);
+                stageProducts[kept] = std::move(stageProducts[i]);
+            }
+            ++kept;
+        }
+        stagesConfig.resize(kept);
+        stageProducts.resize(kept);
+        // Edges into pruned stages lead nowhere needed
+        for (auto& sc : stagesConfig) {
+            sc.next.erase(std::remove_if(sc.next.begin(), sc.next.end(),
+                                         [&keptIds](const std::string& id) { return keptIds.count(id) == 0; }),
+                          sc.next.end());
+        }
+        if (!dependencies_.derive(stagesConfig, stageProducts, configManager_->getEdgeMode()) ||
+            !declaredTopology.build(stagesConfig)) {
+            return false;
+        }
+        spdlog::info("[Pipeline] Requested outputs need {} of {} stage(s); {} pruned.",
+                     kept, declaredTopology.size() + prunedStages_.size(), prunedStages_.size());
+    }
+
+    // 3b. Construct and initialize the stages. With parallel init, the stages
+    // of one topological level are built concurrently and a level starts once
+    // the previous one is done, so an Init() may rely on its upstream stages.
+    // It is only used when the graph branches, i.e. when ROOT thread safety
+    // would be enabled for execution anyway.
+    const uint64_t stagesStartNs = StageMetrics::nowNs();
+    bool branching = declaredTopology.startStages().size() > 1;
+    for (size_t i = 0; i < declaredTopology.size(); ++i) {
+        branching = branching || declaredTopology.successors(i).size() > 1;
+    }
+    const bool parallelInit = parallelStageInit_ && enable_thread_safety_if_needed_ && branching;
+    if (parallelInit) {
+        // Concurrent TClass::New() and Init() need ROOT's locks
+        parallelismDetected_ = true;
+        enableRootThreadSafetyIfNeeded();
+    }
+
+    // Non-blocking scheduled stages run on copies, in a manager of their own
+    scheduledProducts_.clear();
+    scheduledProducts_.resize(stagesConfig.size());
+    for (size_t i = 0; i < stagesConfig.size(); ++i) {
+        if (stagesConfig[i].schedule.scheduled() && !stagesConfig[i].schedule.blocking) {
+            scheduledProducts_[i] = std::make_unique<PipelineDataProductManager>();
+        }
+    }
+
+    std::vector<std::unique_ptr<BaseStage>> createdStages(stagesConfig.size());
+    std::vector<StageStartupTiming> stageTimings(stagesConfig.size());
+    auto constructStage = [&](size_t i) {
+        const auto& sc = stagesConfig[i];
+        try {
+            createdStages[i].reset(createStageInstance(sc.type, sc.parameters, &stageTimings[i],
+                                                       scheduledProducts_[i].get()));
+        } catch (const std::exception& e) {
+            spdlog::error("[Pipeline] Exception while creating stage '{}': {}", sc.id, e.what());
+        }
+    };
+
+    if (parallelInit) {
+        // Resolve classes serially so dictionary autoloading is not done under contention
+        std::set<std::string> types;
+        for (const auto& sc : stagesConfig) {
+            types.insert(sc.type);
+        }
+        for (const auto& type : types) {
+            bool hasFactory = false;
+            {
+                std::lock_guard<std::mutex> lock(stageFactoriesMutex_);
+                hasFactory = stageFactories_.count(type) > 0;
+            }
+            if (!hasFactory) {
+                findStageClass(type);
+            }
+        }
+
+        taskArenas_.execute([&]() {
+            for (const auto& level : declaredTopology.levels()) {
+                tbb::task_group initTasks;
+                for (size_t i : level) {
+                    initTasks.run([&constructStage, i]() { constructStage(i); });
+                }
+                initTasks.wait();
+                for (size_t i : level) {
+                    if (!createdStages[i]) {
+                        return;
+                    }
+                }
+            }
+        });
+    } else {
+        for (size_t i = 0; i < stagesConfig.size(); ++i) {
+            constructStage(i);
+            if (!createdStages[i]) {
+                break;
+            }
+        }
+    }
+
+    nlohmann::json stageReport = nlohmann::json::object();
+    for (size_t i = 0; i < stagesConfig.size(); ++i) {
+        stageReport[stagesConfig[i].id] = {
+            {"type", stagesConfig[i].type},
+            {"construct_ms", stageTimings[i].constructNs / 1e6},
+            {"init_ms", stageTimings[i].initNs / 1e6}
+        };
+    }
+    startupReport_["plugins"] = std::move(pluginTimings);
+    startupReport_["stages"] = std::move(stageReport);
+    startupReport_["parallel_init"] = parallelInit;
+    startupReport_["stages_ms"] = (StageMetrics::nowNs() - stagesStartNs) / 1e6;
+
+    // 3c. Add the products stages declare themselves and settle the edges again
+    for (size_t i = 0; i < stagesConfig.size(); ++i) {
+        if (!createdStages[i]) {
+            return false;
+        }
+        if (auto* access = dynamic_cast<ProductAccessStage*>(createdStages[i].get())) {
+            for (auto& name : access->InputProducts()) {
+                stageProducts[i].reads.push_back(std::move(name));
+            }
+            for (auto& name : access->OutputProducts()) {
+                stageProducts[i].writes.push_back(std::move(name));
+            }
+        }
+    }
+    if (!dependencies_.derive(stagesConfig, stageProducts, configManager_->getEdgeMode())) {
+        return false;
+    }
+
+    startupReport_["pruned_stages"] = prunedStages_;
+    startupReport_["critical_path_length"] = dependencies_.criticalPath().size();
+
+    // 3d. Register the stages in config order
+    for (size_t i = 0; i < stagesConfig.size(); ++i) {
+        const auto& sc = stagesConfig[i];
         spdlog::debug("[Pipeline] Registering stage id: {} type: {}", sc.id, sc.type);
 
         if (sc.next.size() > 1) {
-            parallelismDetected = true;  // branching detected
+            parallelismDetected_ = true;  // branching detected
         }
 
-        std::unique_ptr<BaseStage> stagePtr(createStageInstance(sc.type, sc.parameters));
+        std::unique_ptr<BaseStage> stagePtr = std::move(createdStages[i]);
         if (!stagePtr) return false;
 
         BaseStage* stageRaw = stagePtr.get();
 
-        if (auto* inputStage = dynamic_cast<BaseInputStage*>(stageRaw)) {
+        auto* inputStage = dynamic_cast<BaseInputStage*>(stageRaw);
+        if (inputStage) {
             registerInputStage(inputStage);
         }
+        auto* batchStage = dynamic_cast<BatchStage*>(stageRaw);
+        auto* filterStage = dynamic_cast<FilterStage*>(stageRaw);
+        if (!batchStage || filterStage) {
+            // Verdicts are per event, so a filter cannot take a whole batch
+            allStagesBatchCapable_ = false;
+        }
+
+        stageByIndex_.push_back(stageRaw);
+        inputStageByIndex_.push_back(inputStage);
+        batchStageByIndex_.push_back(batchStage);
+        sharedInputStageByIndex_.push_back(dynamic_cast<SharedInputStage*>(stageRaw));
+        filterStageByIndex_.push_back(filterStage);
+        stageArenaByIndex_.push_back(taskArenas_.stageArena(sc.id));
+        stageMetrics_.push_back(std::make_unique<StageMetrics>());
+
+        std::vector<size_t> outputSlots;
+        for (const auto& output : stageProducts[i].writes) {
+            outputSlots.push_back(productJsonCache_.track(output));
+        }
+        stageOutputSlots_.push_back(std::move(outputSlots));
 
         stages_[sc.id] = std::move(stagePtr);
+    }
 
-        auto node = std::make_unique<tbb::flow::continue_node<tbb::flow::continue_msg>>(graph_,
-            [stageRaw](const tbb::flow::continue_msg&) {
-                spdlog::debug("[Pipeline] Executing stage: {}", stageRaw->Name());
-                stageRaw->Process();
-            });
+    productJsonCache_.finalizeTracking();
 
-        nodes_[sc.id] = std::move(node);
+    // 3e. Resolve product names to handles and let stages subscribe to them
+    for (const auto& products : stageProducts) {
+        for (const auto& name : products.writes) {
+            productTable_.resolve(name);
+        }
+        for (const auto& name : products.reads) {
+            productTable_.resolve(name);
+        }
     }
+    productTable_.finalize();
+    std::vector<std::vector<ProductHandle>> stageSubscriptions;
+    for (BaseStage* stage : stageByIndex_) {
+        if (auto* handleStage = dynamic_cast<ProductHandleStage*>(stage)) {
+            handleStage->BindProducts(productTable_);
+        }
+        stageSubscriptions.push_back(productTable_.takeSubscriptions());
+    }
+    size_t publishedProducts = 0;
+    for (const auto& products : stageProducts) {
+        std::vector<ProductHandle> handles;
+        for (const auto& name : products.writes) {
+            ProductHandle handle = productTable_.find(name);
+            if (productTable_.isSubscribed(handle)) {
+                handles.push_back(handle);
+            }
+        }
+        publishedProducts += handles.size();
+        stageOutputHandles_.push_back(std::move(handles));
+    }
+    spdlog::debug("[Pipeline] {} product handle(s), {} published per event.", productTable_.size(), publishedProducts);
 
-    for (const auto& sc : stagesConfig) {
-        auto& fromNode = nodes_.at(sc.id);
-        for (const auto& nextId : sc.next) {
-            auto toIt = nodes_.find(nextId);
-            if (toIt == nodes_.end()) {
-                spdlog::error("[Pipeline] Invalid next id: {}", nextId);
-                return false;
+    if (!topology_.build(stagesConfig)) {
+        return false;
+    }
+    stageProducts_ = std::move(stageProducts);
+
+    // Derived edges keep transitive edges; a filter on another path to a
+    // stage decides alone whether it runs
+    std::vector<uint8_t> filters(topology_.size(), 0);
+    if (configManager_->getEdgeMode() != EdgeMode::Explicit) {
+        for (size_t i = 0; i < topology_.size(); ++i) {
+            filters[i] = filterStageByIndex_[i] != nullptr;
+        }
+    }
+    activatesByIndex_ = topology_.activationEdges(filters);
+
+    // Scheduled stages leave the per-event traversal; nothing may wait on them
+    std::vector<StageScheduler::Entry> scheduled;
+    scheduledByIndex_.assign(topology_.size(), 0);
+    for (size_t i = 0; i < stagesConfig.size(); ++i) {
+        if (!stagesConfig[i].schedule.scheduled()) {
+            continue;
+        }
+        if (!topology_.successors(i).empty()) {
+            spdlog::error("[Pipeline] Scheduled stage '{}' has successors; only sink stages can be scheduled.",
+                          stagesConfig[i].id);
+            return false;
+        }
+        if (scheduledProducts_[i] && stageProducts_[i].reads.empty()) {
+            spdlog::error("[Pipeline] Scheduled stage '{}' declares no products to read, so none can be copied "
+                          "for it; declare them or set \"blocking\": true in its schedule.", stagesConfig[i].id);
+            return false;
+        }
+        scheduledByIndex_[i] = 1;
+        if (scheduledProducts_[i]) {
+            parallelismDetected_ = true;  // runs alongside the events
+        }
+        scheduled.push_back({i, stagesConfig[i].id, stagesConfig[i].schedule});
+    }
+    if (!scheduled.empty()) {
+        tbb::task_arena* background = taskArenas_.backgroundArena();
+        if (!background) {
+            spdlog::error("[Pipeline] Failed to create the background arena for scheduled stages.");
+            return false;
+        }
+        spdlog::info("[Pipeline] {} scheduled stage(s) run in the background arena.", scheduled.size());
+        scheduler_.configure(std::move(scheduled), background,
+            [this](size_t stageIndex, uint64_t eventIndex, uint64_t readyNs) {
+                runScheduledStage(stageIndex, eventIndex, readyNs);
+            },
+            [this](size_t stageIndex) { prepareScheduledStage(stageIndex); });
+    }
+    // A writer only waits for its direct successors before its next event.
+    // A stage further downstream that reads its products by handle gets a
+    // per-slot copy; one that reads them by name holds the writer back.
+    indirectReaders_.assign(topology_.size(), {});
+    stageCopiedHandles_.assign(topology_.size(), {});
+    for (size_t i = 0; i < topology_.size(); ++i) {
+        const auto& successors = topology_.successors(i);
+        for (size_t reader : topology_.descendants(i)) {
+            if (std::find(successors.begin(), successors.end(), reader) != successors.end() ||
+                scheduledByIndex_[reader]) {
+                continue;
+            }
+            bool readsByName = false;
+            for (const auto& name : stageProducts_[i].writes) {
+                const auto& reads = stageProducts_[reader].reads;
+                if (std::find(reads.begin(), reads.end(), name) == reads.end()) {
+                    continue;
+                }
+                const ProductHandle handle = productTable_.find(name);
+                const auto& subscribed = stageSubscriptions[reader];
+                if (std::find(subscribed.begin(), subscribed.end(), handle) == subscribed.end()) {
+                    readsByName = true;
+                } else if (std::find(stageCopiedHandles_[i].begin(), stageCopiedHandles_[i].end(), handle) ==
+                           stageCopiedHandles_[i].end()) {
+                    stageCopiedHandles_[i].push_back(handle);
+                }
+            }
+            if (readsByName) {
+                indirectReaders_[i].push_back(reader);
             }
-            spdlog::debug("[Pipeline] Connecting {} -> {}", sc.id, nextId);
-            make_edge(*fromNode, *toIt->second);
-            incomingCount_[nextId]++;
         }
     }
 
-    for (const auto& [id, count] : incomingCount_) {
-        if (count == 0) {
-            startNodes_.push_back(id);
+    // A shed stage does not route its event on, so only optional stages may follow it
+    optionalByIndex_.assign(topology_.size(), 0);
+    std::vector<std::string> stageIds;
+    size_t optionalCount = 0;
+    for (size_t i = 0; i < stagesConfig.size(); ++i) {
+        optionalByIndex_[i] = stagesConfig[i].optional;
+        optionalCount += stagesConfig[i].optional;
+        stageIds.push_back(stagesConfig[i].id);
+    }
+    for (size_t i = 0; i < topology_.size(); ++i) {
+        for (size_t prev : topology_.predecessors(i)) {
+            if (!optionalByIndex_[i] && optionalByIndex_[prev]) {
+                spdlog::error("[Pipeline] Essential stage '{}' depends on optional stage '{}'.",
+                              topology_.id(i), topology_.id(prev));
+                return false;
+            }
         }
     }
+    const OverloadConfig& overload = configManager_->getOverloadConfig();
+    if (overload.configured()) {
+        loadShedder_.configure(overload, std::move(stageIds));
+        spdlog::info("[Pipeline] Load shedding for {} optional stage(s): latency budget {} ms, queue high/low {}/{}.",
+                     optionalCount, overload.latencyBudgetMs, overload.queueHigh, overload.queueLow);
+    }
+    stageFinishNs_ = std::make_unique<std::atomic<uint64_t>[]>(topology_.size());
+    graphActiveStages_ = std::make_unique<std::atomic<bool>[]>(topology_.size());
+
+    buildGraphNodes();
 
     spdlog::debug("[Pipeline] Found {} start node(s).", startNodes_.size());
 
     // Refine parallelism detection: multiple start nodes implies parallelism
     if (startNodes_.size() > 1) {
-        parallelismDetected = true;
+        parallelismDetected_ = true;
+    }
+
+    enableRootThreadSafetyIfNeeded();
+
+    startupReport_["execution"] = taskArenas_.toJson();
+    startupReport_["total_ms"] = (StageMetrics::nowNs() - buildStartNs) / 1e6;
+    spdlog::info("[Pipeline] Built {} stage(s) in {:.1f} ms ({} init).", stagesConfig.size(),
+                 startupReport_["total_ms"].get<double>(), parallelInit ? "parallel" : "serial");
+    spdlog::debug("[Pipeline] Startup breakdown: {}", startupReport_.dump());
+
+    const auto& monitoring = configManager_->getMonitoringConfig();
+    if (monitoring.contains("shm_segment")) {
+        metricsSegmentName_ = monitoring.at("shm_segment").get<std::string>();
+        metricsIntervalMs_ = monitoring.value("interval_ms", 500u);
+    }
+    if (!metricsSegmentName_.empty()) {
+        startMetricsPublisher();
+    }
+
+    const auto& checkpoint = configManager_->getCheckpointConfig();
+    if (checkpoint.contains("path") && !checkpointer_.enabled()) {
+        startCheckpointing(checkpoint.at("path").get<std::string>(), checkpoint.value("interval_s", 0.0));
+    }
+
+    return true;
+}
+
+nlohmann::json Pipeline::getDependencyReport() const {
+    // Weight the critical path by measured mean latencies once stages have run
+    std::vector<double> meanNs;
+    bool measured = false;
+    for (const auto& metrics : stageMetrics_) {
+        const auto snap = metrics->snapshot();
+        measured = measured || snap.calls > 0;
+        meanNs.push_back(snap.calls > 0 ? static_cast<double>(snap.totalNs) / static_cast<double>(snap.calls) : 0.0);
+    }
+    if (!measured) {
+        return dependencies_.toJson();
+    }
+    return dependencies_.toJson([&meanNs](size_t index) { return meanNs[index]; });
+}
+
+nlohmann::json Pipeline::getExecutionInfo() const {
+    return taskArenas_.toJson();
+}
+
+void Pipeline::setRequestedOutputs(std::vector<std::string> products, std::vector<std::string> stages) {
+    OutputsConfig outputs;
+    outputs.products = std::move(products);
+    outputs.stages = std::move(stages);
+    requestedOutputs_ = std::move(outputs);
+}
+
+const std::vector<std::string>& Pipeline::getPrunedStages() const {
+    return prunedStages_;
+}
+
+std::shared_ptr<const StageDemand> Pipeline::demandFor(const std::vector<std::string>& products,
+                                                       const std::vector<std::string>& stages) const {
+    OutputsConfig outputs;
+    outputs.products = products;
+    outputs.stages = stages;
+    std::vector<std::string> unknown;
+    auto demand = std::make_shared<const StageDemand>(
+        StageDemand::resolve(topology_, stageProducts_, outputs, unknown));
+    if (!unknown.empty()) {
+        spdlog::error("[Pipeline] Demanded outputs match no built stage or written product: {}",
+                      nlohmann::json(unknown).dump());
+        return nullptr;
     }
+    return demand;
+}
+
+void Pipeline::setDemandSelector(DemandSelector selector) {
+    demandSelector_ = std::move(selector);
+}
 
+void Pipeline::setDeferOutputFiles(bool defer) {
+    deferOutputFiles_ = defer;
+}
+
+std::map<std::string, uint64_t> Pipeline::closeOutputFiles() {
+    std::map<std::string, uint64_t> closed;
+    for (BaseStage* stage : stageByIndex_) {
+        auto* output = dynamic_cast<ProductOutputStage*>(stage);
+        if (output && output->isOutputOpen()) {
+            closed[output->path()] = output->closeOutput();
+        }
+    }
+    return closed;
+}
+
+bool Pipeline::openOutputFiles(const std::map<std::string, uint64_t>& continued) {
+    bool ok = true;
+    for (BaseStage* stage : stageByIndex_) {
+        auto* output = dynamic_cast<ProductOutputStage*>(stage);
+        if (!output || output->isOutputOpen() || output->path().empty()) {
+            continue;
+        }
+        auto it = continued.find(output->path());
+        const bool append = it != continued.end();
+        ok = output->openOutput(append, append ? it->second : 0) && ok;
+    }
+    return ok;
+}
+
+void Pipeline::setParallelStageInit(bool enable) {
+    parallelStageInit_ = enable;
+}
+
+const nlohmann::json& Pipeline::getStartupReport() const {
+    return startupReport_;
+}
+
+void Pipeline::buildGraphNodes() {
+    const size_t stageCount = topology_.size();
+    fusedChains_.clear();
+
+    for (size_t i = 0; i < stageCount; ++i) {
+        incomingCount_[topology_.id(i)] = static_cast<int>(topology_.predecessors(i).size());
+    }
+
+    // A stage continues its predecessor's chain when it is that predecessor's
+    // only successor and has no other predecessor; nothing could run in
+    // parallel with it, so both can share one graph node.
+    auto continuesChain = [this](size_t index) {
+        const auto& preds = topology_.predecessors(index);
+        return fuseLinearChains_ && preds.size() == 1 && topology_.successors(preds.front()).size() == 1;
+    };
+
+    std::vector<size_t> chainOf(stageCount, stageCount);
+    for (size_t head = 0; head < stageCount; ++head) {
+        if (continuesChain(head)) {
+            continue;
+        }
+        std::vector<size_t> chain{head};
+        chainOf[head] = fusedChains_.size();
+        size_t current = head;
+        while (topology_.successors(current).size() == 1) {
+            size_t next = topology_.successors(current).front();
+            if (!continuesChain(next) || chainOf[next] != stageCount) {
+                break;
+            }
+            chainOf[next] = fusedChains_.size();
+            chain.push_back(next);
+            current = next;
+        }
+        fusedChains_.push_back(std::move(chain));
+    }
+
+    // Stages on a cycle of single-successor links have no head; keep them unfused
+    for (size_t i = 0; i < stageCount; ++i) {
+        if (chainOf[i] == stageCount) {
+            chainOf[i] = fusedChains_.size();
+            fusedChains_.push_back({i});
+        }
+    }
+
+    for (const auto& chain : fusedChains_) {
+        if (chain.size() > 1) {
+            std::string description = topology_.id(chain.front());
+            for (size_t k = 1; k < chain.size(); ++k) {
+                description += " -> " + topology_.id(chain[k]);
+            }
+            spdlog::debug("[Pipeline] Fused linear chain: {}", description);
+        }
+
+        auto node = std::make_unique<tbb::flow::continue_node<tbb::flow::continue_msg>>(*graph_,
+            [this, chain](const tbb::flow::continue_msg&) {
+                for (size_t stageIndex : chain) {
+                    runGraphStage(stageIndex);
+                }
+            });
+        nodes_[topology_.id(chain.front())] = std::move(node);
+    }
+
+    for (const auto& chain : fusedChains_) {
+        const std::string& fromId = topology_.id(chain.front());
+        for (size_t next : topology_.successors(chain.back())) {
+            const std::string& toId = topology_.id(fusedChains_[chainOf[next]].front());
+            spdlog::debug("[Pipeline] Connecting {} -> {}", topology_.id(chain.back()), topology_.id(next));
+            make_edge(*nodes_.at(fromId), *nodes_.at(toId));
+        }
+        if (topology_.predecessors(chain.front()).empty()) {
+            startNodes_.push_back(fromId);
+        }
+    }
+
+    spdlog::debug("[Pipeline] {} stage(s) mapped to {} graph node(s).", stageCount, fusedChains_.size());
+}
+
+void Pipeline::setFuseLinearChains(bool enable) {
+    fuseLinearChains_ = enable;
+}
+
+std::vector<std::vector<std::string>> Pipeline::getFusedChains() const {
+    std::vector<std::vector<std::string>> chains;
+    for (const auto& chain : fusedChains_) {
+        std::vector<std::string> ids;
+        for (size_t index : chain) {
+            ids.push_back(topology_.id(index));
+        }
+        chains.push_back(std::move(ids));
+    }
+    return chains;
+}
+
+void Pipeline::enableRootThreadSafetyIfNeeded() {
     // Enable ROOT thread safety only if enabled and parallelism detected
     if (enable_thread_safety_if_needed_) {
         static bool rootThreadSafetyEnabled = false;
-        if (parallelismDetected && !rootThreadSafetyEnabled) {
+        if (parallelismDetected_ && !rootThreadSafetyEnabled) {
             ROOT::EnableThreadSafety();
             spdlog::debug("[Pipeline] ROOT::EnableThreadSafety() called due to detected parallelism.");
             rootThreadSafetyEnabled = true;
-        } else if (!parallelismDetected) {
+        } else if (!parallelismDetected_) {
             spdlog::debug("[Pipeline] No parallelism detected; ROOT thread safety not enabled.");
         }
     } else {
         spdlog::debug("[Pipeline] ROOT thread safety enabling disabled by flag.");
     }
+}
+
+
+void Pipeline::execute() {
+    SPDLOG_DEBUG("[Pipeline] Executing pipeline with {} start node(s).", startNodes_.size());
+    currentGraphEvent_ = eventCounter_.fetch_add(1, std::memory_order_relaxed);
+    graphStartNs_ = profilingEnabled_ ? StageMetrics::nowNs() : 0;
+    if (eventArenaEnabled_) {
+        ensureEventArenas(1);
+        eventArenas_.front()->reset();
+    }
+    graphDemand_ = demandSelector_ ? demandSelector_(nullptr) : nullptr;
+    if (loadShedder_.enabled()) {
+        graphAdmitNs_ = StageMetrics::nowNs();
+        graphDegraded_ = loadShedder_.admit(0, graphAdmitNs_);
+    }
+    for (size_t i = 0; i < topology_.size(); ++i) {
+        graphActiveStages_[i].store(topology_.predecessors(i).empty() && !scheduledByIndex_[i] &&
+                                        (!graphDemand_ || graphDemand_->needs(i)),
+                                    std::memory_order_relaxed);
+    }
+    taskArenas_.execute([this]() {
+        for (const auto& id : startNodes_) {
+            auto it = nodes_.find(id);
+            if (it != nodes_.end()) {
+                it->second->try_put(tbb::flow::continue_msg());
+            }
+        }
+        graph_->wait_for_all();
+    });
+    if (loadShedder_.enabled()) {
+        loadShedder_.retired(graphAdmitNs_, StageMetrics::nowNs());
+    }
+    if (!currentBatch_) {
+        // The graph is idle, so this is a drain boundary
+        scheduler_.eventsRetired(currentGraphEvent_);
+        scheduler_.runDue();
+        if (checkpointer_.due()) {
+            takeCheckpoint();
+        }
+    }
+}
+
+uint64_t Pipeline::executeBatch(const std::vector<InputBundle>& inputs) {
+    if (inputs.empty()) {
+        return 0;
+    }
+
+    if (allStagesBatchCapable_ && !demandSelector_) {
+        spdlog::debug("[Pipeline] Executing batch of {} event(s) in a single graph pass.", inputs.size());
+        currentBatch_ = &inputs;
+        try {
+            execute();
+        } catch (...) {
+            currentBatch_ = nullptr;
+            throw;
+        }
+        currentBatch_ = nullptr;
+        eventCounter_.fetch_add(inputs.size() - 1, std::memory_order_relaxed);
+        scheduler_.eventsRetired(currentGraphEvent_ + inputs.size() - 1, inputs.size());
+        scheduler_.runDue();
+        if (checkpointer_.due()) {
+            takeCheckpoint();
+        }
+        return inputs.size();
+    }
+
+    return streamBatch(std::make_shared<const std::vector<InputBundle>>(inputs));
+}
+
+uint64_t Pipeline::executeBatch(std::vector<InputBundle>&& inputs) {
+    if (inputs.empty()) {
+        return 0;
+    }
+    if (allStagesBatchCapable_ && !demandSelector_) {
+        return executeBatch(static_cast<const std::vector<InputBundle>&>(inputs));
+    }
+    return streamBatch(std::make_shared<const std::vector<InputBundle>>(std::move(inputs)));
+}
+
+uint64_t Pipeline::streamBatch(std::shared_ptr<const std::vector<InputBundle>> batch) {
+    // Every event shares ownership of the batch, so a SharedInputStage may
+    // keep its bundle after the call returns
+    size_t next = 0;
+    return executeStream([&batch, &next](std::shared_ptr<const InputBundle>& input) {
+        if (next >= batch->size()) {
+            return false;
+        }
+        input = std::shared_ptr<const InputBundle>(batch, &(*batch)[next++]);
+        return true;
+    });
+}
+
+void Pipeline::setMaxEventsInFlight(size_t maxEventsInFlight) {
+    maxEventsInFlight_ = std::max<size_t>(1, maxEventsInFlight);
+    executor_.reset();
+}
+
+size_t Pipeline::getMaxEventsInFlight() const {
+    return maxEventsInFlight_;
+}
+
+uint64_t Pipeline::executeStream(const PipelinedExecutor::InputSupplier& nextInput, InputSource* source) {
+    if (topology_.size() == 0) {
+        spdlog::error("[Pipeline] executeStream() called before buildFromConfig().");
+        return 0;
+    }
+
+    if (!executor_) {
+        if (maxEventsInFlight_ > 1) {
+            // Different events now run concurrently even on a linear chain
+            parallelismDetected_ = true;
+            enableRootThreadSafetyIfNeeded();
+        }
+        executor_ = std::make_unique<PipelinedExecutor>(topology_, maxEventsInFlight_,
+            [this](size_t stageIndex, const EventContext& event, uint64_t readyNs) {
+                runStreamingStage(stageIndex, event, readyNs);
+            });
+        executor_->setIndirectReaders(indirectReaders_);
+        productTable_.setSlotCount(executor_->slotCount());
+        slotProductCopies_.clear();
+        slotProductCopies_.resize(executor_->slotCount() * productTable_.size());
+        executor_->setAdmitHook([this](const EventContext& event) {
+            if (eventArenaEnabled_) {
+                eventArenas_[event.slot]->reset();
+            }
+            if (loadShedder_.enabled()) {
+                const uint64_t nowNs = StageMetrics::nowNs();
+                slotAdmitNs_[event.slot] = nowNs;
+                slotDegraded_[event.slot] = loadShedder_.admit(streamSource_ ? streamSource_->queuedEvents() : 0, nowNs);
+            }
+            const StageDemand* demand = demandSelector_ ? demandSelector_(event.input.get()) : nullptr;
+            slotDemand_[event.slot] = demand;
+            // Start stages were activated when the slot was prepared
+            for (size_t start : topology_.startStages()) {
+                if (scheduledByIndex_[start] || (demand && !demand->needs(start))) {
+                    event.activeStages[start].store(false, std::memory_order_relaxed);
+                }
+            }
+        });
+        executor_->setRetireHook([this](const EventContext& event) {
+            if (loadShedder_.enabled()) {
+                loadShedder_.retired(slotAdmitNs_[event.slot], StageMetrics::nowNs());
+            }
+            scheduler_.eventsRetired(streamBaseEvent_ + event.sequence);
+        });
+    }
+    slotDemand_.assign(executor_->slotCount(), nullptr);
+    slotAdmitNs_.assign(executor_->slotCount(), 0);
+    slotDegraded_.assign(executor_->slotCount(), 0);
+    if (eventArenaEnabled_) {
+        ensureEventArenas(executor_->slotCount());
+    }
+
+    spdlog::debug("[Pipeline] Streaming events with up to {} in flight.", maxEventsInFlight_);
+
+    // A due scheduled stage or checkpoint ends the executor run at the next
+    // admission. It runs once the events in flight have retired, and the
+    // stream then resumes.
+    bool drainPause = false;
+    const PipelinedExecutor::InputSupplier drainingInput =
+        [this, &nextInput, &drainPause](std::shared_ptr<const InputBundle>& input) {
+            if (scheduler_.due() || checkpointer_.due()) {
+                drainPause = true;
+                return false;
+            }
+            return nextInput(input);
+        };
+    const PipelinedExecutor::InputSupplier& supplier =
+        (!scheduler_.empty() || checkpointer_.enabled()) ? drainingInput : nextInput;
+
+    streamSource_ = source;
+    if (source) {
+        std::lock_guard<std::mutex> lock(monitorMutex_);
+        activeSource_ = source;
+    }
+    auto releaseSource = [this, source]() {
+        streamSource_ = nullptr;
+        if (source) {
+            std::lock_guard<std::mutex> lock(monitorMutex_);
+            activeSource_ = nullptr;
+        }
+    };
 
+    uint64_t processed = 0;
+    for (;;) {
+        drainPause = false;
+        streamBaseEvent_ = eventCounter_.load(std::memory_order_relaxed);
+        uint64_t segment = 0;
+        streaming_.store(true, std::memory_order_release);
+        try {
+            segment = taskArenas_.execute([&]() { return executor_->run(supplier); });
+        } catch (...) {
+            streaming_.store(false, std::memory_order_release);
+            eventCounter_.store(streamBaseEvent_, std::memory_order_relaxed);
+            releaseSource();
+            throw;
+        }
+        streaming_.store(false, std::memory_order_release);
+        eventCounter_.fetch_add(segment, std::memory_order_relaxed);
+        processed += segment;
+        if (!drainPause) {
+            releaseSource();
+            return processed;
+        }
+        try {
+            scheduler_.runDue();
+            if (checkpointer_.due()) {
+                takeCheckpoint();
+            }
+        } catch (...) {
+            releaseSource();
+            throw;
+        }
+    }
+}
+
+uint64_t Pipeline::run(InputSource& source, uint64_t maxEvents) {
+    spdlog::info("[Pipeline] Reading events from {}", source.describe());
+    uint64_t supplied = 0;
+    const uint64_t processed = executeStream([&source, &supplied, maxEvents](std::shared_ptr<const InputBundle>& input) {
+        if (maxEvents != 0 && supplied >= maxEvents) {
+            return false;
+        }
+        if (!source.next(input)) {
+            return false;
+        }
+        ++supplied;
+        return true;
+    }, &source);
+    finishRun();
+    spdlog::info("[Pipeline] Processed {} events from {}", processed, source.describe());
+    spdlog::debug("[Pipeline] Input stats: {}", source.statsToJson().dump());
+    return processed;
+}
+
+uint64_t Pipeline::run() {
+    if (!inputSource_) {
+        const auto& inputConfig = configManager_ ? configManager_->getInputConfig() : nlohmann::json();
+        if (inputConfig.empty()) {
+            spdlog::error("[Pipeline] run() called without an input source or 'input' config block.");
+            return 0;
+        }
+        inputSource_ = makeInputSource(inputConfig);
+        if (!inputSource_) {
+            return 0;
+        }
+    }
+    return run(*inputSource_);
+}
+
+void Pipeline::finishRun() {
+    scheduler_.finishRun();
+}
+
+nlohmann::json Pipeline::getScheduleStats() const {
+    return scheduler_.toJson();
+}
+
+void Pipeline::setInputSource(std::unique_ptr<InputSource> source) {
+    inputSource_ = std::move(source);
+}
+
+InputSource* Pipeline::getInputSource() const {
+    return inputSource_.get();
+}
+
+void Pipeline::runGraphStage(size_t stageIndex) {
+    // Skipped stages still complete their continue_node so joins are signaled
+    if (!graphActiveStages_[stageIndex].load(std::memory_order_acquire) ||
+        shedStage(stageIndex, graphDegraded_, graphAdmitNs_)) {
+        return;
+    }
+    BaseStage* stage = stageByIndex_[stageIndex];
+    SPDLOG_DEBUG("[Pipeline] Executing stage: {}", topology_.id(stageIndex));
+    EventArena::Scope arenaScope(eventArenaEnabled_ ? eventArenas_.front().get() : nullptr);
+    ProductTable::Scope productScope(currentGraphEvent_);
+
+    uint64_t readyNs = 0;
+    uint64_t startNs = 0;
+    if (profilingEnabled_) {
+        // One event at a time: the stage became ready when its last predecessor finished
+        readyNs = graphStartNs_;
+        for (size_t prev : topology_.predecessors(stageIndex)) {
+            readyNs = std::max(readyNs, stageFinishNs_[prev].load(std::memory_order_acquire));
+        }
+        startNs = StageMetrics::nowNs();
+    }
+
+    runInStageArena(stageIndex, [this, stage, stageIndex]() {
+        if (currentBatch_) {
+            batchStageByIndex_[stageIndex]->ProcessBatch(*currentBatch_);
+        } else {
+            stage->Process();
+        }
+    });
+    markStageOutputs(stageIndex);
+    publishStageOutputs(stageIndex, currentGraphEvent_, 0, false);
+    routeEvent(stageIndex, graphActiveStages_.get(), graphDemand_);
+
+    if (profilingEnabled_) {
+        recordStageTiming(stageIndex, currentGraphEvent_, readyNs, startNs);
+    }
+}
+
+void Pipeline::runStreamingStage(size_t stageIndex, const EventContext& event, uint64_t readyNs) {
+    if (shedStage(stageIndex, slotDegraded_[event.slot], slotAdmitNs_[event.slot])) {
+        return;
+    }
+    const uint64_t startNs = profilingEnabled_ ? StageMetrics::nowNs() : 0;
+    EventArena::Scope arenaScope(eventArenaEnabled_ ? eventArenas_[event.slot].get() : nullptr);
+    ProductTable::Scope productScope(streamBaseEvent_ + event.sequence, event.slot);
+
+    if (auto* sharedStage = sharedInputStageByIndex_[stageIndex]) {
+        sharedStage->SetSharedInput(event.input);
+    } else if (auto* inputStage = inputStageByIndex_[stageIndex]) {
+        inputStage->SetInput(*event.input);
+    }
+    BaseStage* stage = stageByIndex_[stageIndex];
+    SPDLOG_DEBUG("[Pipeline] Executing stage: {} (event {})", topology_.id(stageIndex), event.sequence);
+    runInStageArena(stageIndex, [stage]() { stage->Process(); });
+    markStageOutputs(stageIndex);
+    publishStageOutputs(stageIndex, streamBaseEvent_ + event.sequence, event.slot, executor_->maxInFlight() > 1);
+    routeEvent(stageIndex, event.activeStages, slotDemand_[event.slot]);
+
+    if (profilingEnabled_) {
+        recordStageTiming(stageIndex, streamBaseEvent_ + event.sequence, readyNs, startNs);
+    }
+}
+
+bool Pipeline::shedStage(size_t stageIndex, bool degraded, uint64_t admitNs) {
+    // Skipped without routing; everything downstream is optional too
+    if (!loadShedder_.enabled() || !optionalByIndex_[stageIndex] ||
+        !loadShedder_.shouldShed(degraded, admitNs, StageMetrics::nowNs())) {
+        return false;
+    }
+    loadShedder_.recordShed(stageIndex);
+    SPDLOG_TRACE("[Pipeline] Shed stage {}.", topology_.id(stageIndex));
     return true;
 }
 
+void Pipeline::runScheduledStage(size_t stageIndex, uint64_t eventIndex, uint64_t readyNs) {
+    // Runs in the background arena once every event up to eventIndex has
+    // retired: at the drain boundary when blocking, otherwise on the copies
+    // prepareScheduledStage() took there, while events flow. No ProductTable
+    // scope: handles are published per event, so the stage reads its manager.
+    const uint64_t startNs = profilingEnabled_ ? StageMetrics::nowNs() : 0;
+    SPDLOG_DEBUG("[Pipeline] Executing scheduled stage: {} (after event {})", topology_.id(stageIndex), eventIndex);
+    stageByIndex_[stageIndex]->Process();
+    if (PipelineDataProductManager* products = scheduledProducts_[stageIndex].get()) {
+        // Results go back as copies; the stage may keep updating its own
+        for (const auto& name : stageProducts_[stageIndex].writes) {
+            copyProduct(*products, dataProductManager_, name);
+        }
+    }
+    markStageOutputs(stageIndex);
 
-void Pipeline::execute() {
-    spdlog::debug("[Pipeline] Executing pipeline with {} start node(s).", startNodes_.size());
-    for (const auto& id : startNodes_) {
-        auto it = nodes_.find(id);
-        if (it != nodes_.end()) {
-            it->second->try_put(tbb::flow::continue_msg());
+    if (profilingEnabled_) {
+        recordStageTiming(stageIndex, eventIndex, readyNs, startNs);
+    }
+}
+
+void Pipeline::prepareScheduledStage(size_t stageIndex) {
+    // At a drain boundary: no event is in flight and the stage's previous
+    // run has finished
+    PipelineDataProductManager& products = *scheduledProducts_[stageIndex];
+    for (const auto& name : stageProducts_[stageIndex].reads) {
+        if (!copyProduct(dataProductManager_, products, name)) {
+            SPDLOG_DEBUG("[Pipeline] Product '{}' for scheduled stage {} does not exist yet.",
+                         name, topology_.id(stageIndex));
+        }
+    }
+}
+
+template <typename F>
+void Pipeline::runInStageArena(size_t stageIndex, F&& process) {
+    if (tbb::task_arena* arena = stageArenaByIndex_[stageIndex]) {
+        // The calling thread joins the stage's arena; nested parallelism in
+        // the stage stays on that arena's workers
+        arena->execute(std::forward<F>(process));
+    } else {
+        process();
+    }
+}
+
+void Pipeline::markStageOutputs(size_t stageIndex) {
+    for (size_t slot : stageOutputSlots_[stageIndex]) {
+        productJsonCache_.markWritten(slot);
+    }
+}
+
+void Pipeline::publishStageOutputs(size_t stageIndex, uint64_t sequence, size_t slot, bool copy) {
+    // One manager lookup per written product, instead of one per read
+    const auto& copied = stageCopiedHandles_[stageIndex];
+    for (ProductHandle handle : stageOutputHandles_[stageIndex]) {
+        const std::string& name = productTable_.name(handle);
+        const TObject* object = nullptr;
+        if (dataProductManager_.hasProduct(name)) {
+            auto product = dataProductManager_.checkoutRead(name);
+            object = product->getObject();
+            if (object && copy && std::find(copied.begin(), copied.end(), handle) != copied.end()) {
+                // The slot's previous event has retired, so its copy is unused
+                auto& slotCopy = slotProductCopies_[slot * productTable_.size() + handle];
+                slotCopy = detachedClone(*object);
+                object = slotCopy.get();
+            }
         }
+        productTable_.publish(handle, object, sequence, slot);
     }
-    graph_.wait_for_all();
+}
+
+ProductTable& Pipeline::getProductTable() {
+    return productTable_;
+}
+
+const StageProducts* Pipeline::getStageProducts(const std::string& stageId) const {
+    auto index = topology_.indexOf(stageId);
+    return index && *index < stageProducts_.size() ? &stageProducts_[*index] : nullptr;
+}
+
+void Pipeline::routeEvent(size_t stageIndex, std::atomic<bool>* activeStages, const StageDemand* demand) {
+    const auto& successors = topology_.successors(stageIndex);
+    const auto& activates = activatesByIndex_[stageIndex];
+    FilterStage* filter = filterStageByIndex_[stageIndex];
+    if (!filter) {
+        for (size_t k = 0; k < successors.size(); ++k) {
+            const size_t next = successors[k];
+            if (activates[k] && !scheduledByIndex_[next] && (!demand || demand->needs(next))) {
+                activeStages[next].store(true, std::memory_order_release);
+            }
+        }
+        return;
+    }
+
+    const StageVerdict verdict = filter->Verdict();
+    bool routed = false;
+    for (size_t k = 0; k < successors.size(); ++k) {
+        bool selected = k < 64 && ((verdict.branchMask >> k) & 1) != 0;
+        if (!selected && !verdict.selected.empty()) {
+            const std::string& nextId = topology_.id(successors[k]);
+            selected = std::find(verdict.selected.begin(), verdict.selected.end(), nextId) != verdict.selected.end();
+        }
+        if (selected) {
+            if (activates[k] && !scheduledByIndex_[successors[k]] && (!demand || demand->needs(successors[k]))) {
+                activeStages[successors[k]].store(true, std::memory_order_release);
+            }
+            routed = true;
+        }
+    }
+
+    if (!routed) {
+        SPDLOG_TRACE("[Pipeline] Stage {} rejected the event.", topology_.id(stageIndex));
+        if (profilingEnabled_) {
+            stageMetrics_[stageIndex]->recordRejected();
+        }
+    }
+}
+
+nlohmann::json Pipeline::serializeDelta() {
+    nlohmann::json delta = productJsonCache_.serializeDelta(dataProductManager_);
+    delta["events"] = eventCounter_.load(std::memory_order_relaxed);
+    return delta;
+}
+
+nlohmann::json Pipeline::serializeAllCached() {
+    return productJsonCache_.serializeAll(dataProductManager_);
+}
+
+nlohmann::json Pipeline::getSerializationCacheStats() const {
+    return productJsonCache_.statsToJson();
+}
+
+void Pipeline::recordStageTiming(size_t stageIndex, uint64_t eventIndex, uint64_t readyNs, uint64_t startNs) {
+    const uint64_t endNs = StageMetrics::nowNs();
+    stageMetrics_[stageIndex]->record(endNs - startNs, startNs > readyNs ? startNs - readyNs : 0);
+    stageFinishNs_[stageIndex].store(endNs, std::memory_order_release);
+
+    if (trace_.isRecording(eventIndex)) {
+        trace_.record(stageIndex, eventIndex, startNs, endNs - startNs);
+    }
+}
+
+void Pipeline::setEventArenaEnabled(bool enabled, size_t initialBytes) {
+    if (initialBytes != eventArenaInitialBytes_) {
+        eventArenas_.clear();
+    }
+    eventArenaEnabled_ = enabled;
+    eventArenaInitialBytes_ = initialBytes;
+}
+
+bool Pipeline::isEventArenaEnabled() const {
+    return eventArenaEnabled_;
+}
+
+void Pipeline::ensureEventArenas(size_t count) {
+    while (eventArenas_.size() < count) {
+        eventArenas_.push_back(std::make_unique<EventArena>(eventArenaInitialBytes_));
+    }
+}
+
+nlohmann::json Pipeline::getEventArenaStats() const {
+    nlohmann::json arenas = nlohmann::json::array();
+    size_t highWater = 0;
+    size_t capacity = 0;
+    for (const auto& arena : eventArenas_) {
+        arenas.push_back(arena->statsToJson());
+        highWater = std::max(highWater, arena->highWaterBytes());
+        capacity += arena->capacityBytes();
+    }
+
+    nlohmann::json j;
+    j["enabled"] = eventArenaEnabled_;
+    j["high_water_bytes"] = highWater;
+    j["capacity_bytes"] = capacity;
+    j["arenas"] = std::move(arenas);
+    return j;
+}
+
+void Pipeline::setProfilingEnabled(bool enabled) {
+    profilingEnabled_ = enabled;
+}
+
+bool Pipeline::isProfilingEnabled() const {
+    return profilingEnabled_;
+}
+
+nlohmann::json Pipeline::getStageMetrics() const {
+    nlohmann::json stages = nlohmann::json::object();
+    for (size_t i = 0; i < stageMetrics_.size(); ++i) {
+        stages[topology_.id(i)] = stageMetrics_[i]->snapshot().toJson();
+    }
+
+    nlohmann::json j;
+    j["events"] = eventCounter_.load(std::memory_order_relaxed);
+    j["stages"] = std::move(stages);
+    return j;
+}
+
+void Pipeline::resetStageMetrics() {
+    std::lock_guard<std::mutex> lock(monitorMutex_);
+    for (auto& metrics : stageMetrics_) {
+        metrics->reset();
+    }
+    loadShedder_.resetCounters();
+}
+
+nlohmann::json Pipeline::getLoadSheddingStats() const {
+    return loadShedder_.toJson();
+}
+
+void Pipeline::startTrace(uint64_t eventCount) {
+    trace_.start(eventCounter_.load(std::memory_order_relaxed), eventCount);
+}
+
+bool Pipeline::writeTrace(const std::string& path) const {
+    std::vector<std::string> names;
+    for (size_t i = 0; i < topology_.size(); ++i) {
+        names.push_back(topology_.id(i));
+    }
+    return trace_.write(path, names);
+}
+
+bool Pipeline::startMetricsSegment(const std::string& name, unsigned intervalMs) {
+    stopMetricsPublisher();
+    metricsSegmentName_ = name;
+    metricsIntervalMs_ = std::max(1u, intervalMs);
+    // Before the first build the segment is created by buildFromConfig()
+    return topology_.size() == 0 || startMetricsPublisher();
+}
+
+void Pipeline::stopMetricsSegment() {
+    stopMetricsPublisher();
+    metricsSegmentName_.clear();
+}
+
+MetricsSample Pipeline::sampleMetrics() const {
+    MetricsSample sample;
+    sample.pid = static_cast<uint64_t>(::getpid());
+    sample.updateNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    sample.maxInFlight = maxEventsInFlight_;
+    sample.events = eventCounter_.load(std::memory_order_relaxed);
+    if (streaming_.load(std::memory_order_acquire)) {
+        const uint64_t retired = executor_->retiredCount();
+        const uint64_t admitted = executor_->admittedCount();
+        sample.events += retired;
+        sample.inFlight = admitted > retired ? admitted - retired : 0;
+    }
+
+    std::lock_guard<std::mutex> lock(monitorMutex_);
+    sample.stages.reserve(stageMetrics_.size());
+    for (size_t i = 0; i < stageMetrics_.size(); ++i) {
+        const auto snap = stageMetrics_[i]->snapshot();
+        MetricsSample::Stage stage;
+        stage.id = topology_.id(i);
+        stage.calls = snap.calls;
+        stage.totalNs = snap.totalNs;
+        stage.maxNs = snap.maxNs;
+        stage.queueWaitNs = snap.totalQueueNs;
+        stage.rejected = snap.rejected;
+        sample.stages.push_back(std::move(stage));
+    }
+
+    if (activeSource_) {
+        // PrefetchingSource reports its queue and nests the reader's counters
+        const nlohmann::json stats = activeSource_->statsToJson();
+        const nlohmann::json& reader = stats.contains("upstream") ? stats["upstream"] : stats;
+        sample.inputEvents = reader.value("events", uint64_t(0));
+        sample.inputBytes = activeSource_->bytesRead();
+        sample.inputQueued = stats.value("queued", uint64_t(0));
+        sample.inputHighWater = stats.value("high_water", uint64_t(0));
+        sample.inputDropped = stats.value("dropped", uint64_t(0));
+    }
+    return sample;
+}
+
+bool Pipeline::startMetricsPublisher() {
+    stopMetricsPublisher();
+    if (!metricsSegment_.create(metricsSegmentName_, topology_.size())) {
+        return false;
+    }
+
+    metricsStop_ = false;
+    metricsThread_ = std::thread([this]() {
+        const uint64_t startNs = sampleMetrics().updateNs;
+        uint64_t updates = 0;
+        uint64_t lastEvents = 0;
+
+        std::unique_lock<std::mutex> lock(metricsThreadMutex_);
+        while (!metricsStop_) {
+            lock.unlock();
+            MetricsSample sample = sampleMetrics();
+            sample.startNs = startNs;
+            sample.updates = ++updates;
+            // The stream total is folded into eventCounter_ just after the
+            // executor stops reporting it; keep the count monotonic for readers
+            sample.events = std::max(sample.events, lastEvents);
+            lastEvents = sample.events;
+            metricsSegment_.publish(sample);
+            lock.lock();
+            metricsWake_.wait_for(lock, std::chrono::milliseconds(metricsIntervalMs_),
+                                  [this]() { return metricsStop_; });
+        }
+    });
+    return true;
+}
+
+void Pipeline::stopMetricsPublisher() {
+    if (metricsThread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(metricsThreadMutex_);
+            metricsStop_ = true;
+        }
+        metricsWake_.notify_all();
+        metricsThread_.join();
+    }
+    metricsSegment_.close();
+}
+
+bool Pipeline::startCheckpointing(const std::string& path, double intervalSeconds) {
+    // The checkpoint thread streams object copies while events run
+    ROOT::EnableThreadSafety();
+    return checkpointer_.start(path, intervalSeconds);
+}
+
+void Pipeline::stopCheckpointing(bool finalCheckpoint) {
+    if (!checkpointer_.enabled()) {
+        return;
+    }
+    if (finalCheckpoint) {
+        takeCheckpoint();
+    }
+    checkpointer_.stop();
+}
+
+void Pipeline::checkpointNow() {
+    checkpointer_.request();
+}
+
+nlohmann::json Pipeline::getCheckpointStats() const {
+    nlohmann::json stats = checkpointer_.toJson();
+    stats["enabled"] = checkpointer_.enabled();
+    return stats;
+}
+
+void Pipeline::takeCheckpoint() {
+    // The graph is idle here. Blocking scheduled stages only run at the same
+    // drain boundaries, before this. The others work on copies and only swap
+    // whole products in when they finish, so no object changes while it is
+    // copied. Only the object copies are on the event path; the checkpoint
+    // thread streams them.
+    const uint64_t startNs = StageMetrics::nowNs();
+    CheckpointSnapshot snapshot;
+    snapshot.events = eventCounter_.load(std::memory_order_relaxed);
+    for (const auto& name : dataProductManager_.getAllNames()) {
+        if (!dataProductManager_.hasProduct(name)) {
+            continue;
+        }
+        auto product = dataProductManager_.checkoutRead(name);
+        const TObject* obj = product->getObject();
+        if (!obj) {
+            continue;
+        }
+        std::shared_ptr<TObject> copy(detachedClone(*obj));
+        if (!copy) {
+            spdlog::warn("[Pipeline] Failed to copy product '{}' for the checkpoint; skipped.", name);
+            continue;
+        }
+        CheckpointSnapshot::Product stored;
+        stored.name = name;
+        stored.className = obj->ClassName();
+        stored.serialize = [copy](std::string& payload) {
+            TBufferFile buffer(TBuffer::kWrite);
+            buffer.WriteObject(copy.get());
+            payload.assign(buffer.Buffer(), static_cast<size_t>(buffer.Length()));
+            return true;
+        };
+        snapshot.products.push_back(std::move(stored));
+    }
+    const uint64_t copyNs = StageMetrics::nowNs() - startNs;
+    spdlog::debug("[Pipeline] Checkpoint of {} product(s) after {} event(s) copied in {:.2f} ms",
+                  snapshot.products.size(), snapshot.events, copyNs / 1e6);
+    checkpointer_.submit(std::move(snapshot), copyNs);
+}
+
+bool Pipeline::restoreCheckpoint(const std::string& path) {
+    if (streaming_.load(std::memory_order_acquire)) {
+        spdlog::error("[Pipeline] restoreCheckpoint() called while events are being processed.");
+        return false;
+    }
+
+    CheckpointSnapshot snapshot;
+    if (!Checkpointer::readFile(path, snapshot)) {
+        return false;
+    }
+
+    size_t restored = 0;
+    for (auto& stored : snapshot.products) {
+        TClass* cl = TClass::GetClass(stored.className.c_str());
+        if (!cl) {
+            spdlog::warn("[Pipeline] Checkpoint product '{}' has unknown class '{}'; skipped.",
+                         stored.name, stored.className);
+            continue;
+        }
+        TBufferFile buffer(TBuffer::kRead, static_cast<Int_t>(stored.payload.size()), &stored.payload[0], kFALSE);
+        std::unique_ptr<TObject> obj(buffer.ReadObject(cl));
+        if (!obj) {
+            spdlog::warn("[Pipeline] Failed to read checkpoint product '{}' ({}); skipped.",
+                         stored.name, stored.className);
+            continue;
+        }
+        // Keep restored histograms out of gDirectory, like the ones stages create
+        if (auto* hist = dynamic_cast<TH1*>(obj.get())) {
+            hist->SetDirectory(nullptr);
+        }
+
+        std::unique_ptr<PipelineDataProduct> product;
+        if (dataProductManager_.hasProduct(stored.name)) {
+            product = dataProductManager_.extractProduct(stored.name);
+        }
+        if (!product) {
+            product = std::make_unique<PipelineDataProduct>();
+            product->setName(stored.name);
+        }
+        product->setObject(std::move(obj));
+        dataProductManager_.addOrUpdate(stored.name, std::move(product));
+        ++restored;
+    }
+
+    // Cached JSON of the restored products is stale
+    for (const auto& slots : stageOutputSlots_) {
+        for (size_t slot : slots) {
+            productJsonCache_.markWritten(slot);
+        }
+    }
+    eventCounter_.store(snapshot.events, std::memory_order_relaxed);
+
+    spdlog::info("[Pipeline] Restored {} of {} product(s) from checkpoint '{}' ({} event(s)).",
+                 restored, snapshot.products.size(), path, snapshot.events);
+    return restored == snapshot.products.size();
 }
 
 void Pipeline::setInputData(const InputBundle& input) {
-    for (auto* stage : input_stages_) {
-        if (stage) {
-            stage->SetInput(input);
+    std::shared_ptr<const InputBundle> shared;
+    for (size_t i = 0; i < input_stages_.size(); ++i) {
+        if (auto* sharedStage = shared_input_stages_[i]) {
+            if (!shared) {
+                shared = std::make_shared<const InputBundle>(input);
+            }
+            sharedStage->SetSharedInput(shared);
+        } else if (input_stages_[i]) {
+            input_stages_[i]->SetInput(input);
         }
     }
 }
 
+void Pipeline::setInputData(std::shared_ptr<const InputBundle> input) {
+    if (!input) {
+        spdlog::warn("[Pipeline] setInputData() called with a null input bundle.");
+        return;
+    }
+    for (size_t i = 0; i < input_stages_.size(); ++i) {
+        if (auto* sharedStage = shared_input_stages_[i]) {
+            sharedStage->SetSharedInput(input);
+        } else if (input_stages_[i]) {
+            input_stages_[i]->SetInput(*input);
+        }
+    }
+}
+
+void Pipeline::setInputData(InputBundle&& input) {
+    setInputData(std::make_shared<const InputBundle>(std::move(input)));
+}
+
 void Pipeline::registerInputStage(BaseInputStage* stage) {
     input_stages_.push_back(stage);
+    shared_input_stages_.push_back(dynamic_cast<SharedInputStage*>(stage));
 }
@@ -0,0 +1,225 @@
+#include "analysis_pipeline/pipeline/pipelined_executor.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "analysis_pipeline/monitoring/stage_metrics.h"
+
+PipelinedExecutor::PipelinedExecutor(const StageTopology& topology, size_t maxInFlight, StageFunction stageFunction)
+    : topology_(topology),
+      maxInFlight_(std::max<size_t>(1, maxInFlight)),
+      stageFunction_(std::move(stageFunction)),
+      slots_(maxInFlight_ + 1)
+{
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        slots_[i].event.slot = i;
+    }
+    for (auto& slot : slots_) {
+        slot.pending = std::make_unique<std::atomic<int>[]>(topology_.size());
+        slot.active = std::make_unique<std::atomic<bool>[]>(topology_.size());
+        slot.event.activeStages = slot.active.get();
+    }
+    setIndirectReaders({});
+}
+
+void PipelinedExecutor::setIndirectReaders(const std::vector<std::vector<size_t>>& readers) {
+    readers_.assign(topology_.size(), {});
+    writers_.assign(topology_.size(), {});
+    for (size_t i = 0; i < topology_.size(); ++i) {
+        readers_[i] = topology_.successors(i);
+        if (i < readers.size()) {
+            readers_[i].insert(readers_[i].end(), readers[i].begin(), readers[i].end());
+        }
+        std::sort(readers_[i].begin(), readers_[i].end());
+        readers_[i].erase(std::unique(readers_[i].begin(), readers_[i].end()), readers_[i].end());
+        readers_[i].erase(std::remove(readers_[i].begin(), readers_[i].end(), i), readers_[i].end());
+        for (size_t reader : readers_[i]) {
+            writers_[reader].push_back(i);
+        }
+    }
+}
+
+PipelinedExecutor::Slot& PipelinedExecutor::slotFor(uint64_t sequence) {
+    return slots_[sequence % slots_.size()];
+}
+
+void PipelinedExecutor::prepareSlot(uint64_t sequence) {
+    Slot& slot = slotFor(sequence);
+    const bool hasPreviousEvent = sequence > 0;
+
+    for (size_t i = 0; i < topology_.size(); ++i) {
+        const auto& preds = topology_.predecessors(i);
+        int deps = static_cast<int>(preds.size());
+        if (preds.empty()) {
+            deps += 1; // released by admission
+        }
+        if (hasPreviousEvent) {
+            deps += 1 + static_cast<int>(readers_[i].size());
+        }
+        slot.pending[i].store(deps, std::memory_order_relaxed);
+        slot.active[i].store(preds.empty(), std::memory_order_relaxed);
+    }
+    slot.remaining.store(topology_.size(), std::memory_order_relaxed);
+}
+
+uint64_t PipelinedExecutor::run(const InputSupplier& nextInput) {
+    {
+        std::lock_guard<std::mutex> lock(admissionMutex_);
+        supplier_ = &nextInput;
+        nextSequence_ = 0;
+        admitted_.store(0, std::memory_order_relaxed);
+        exhausted_ = false;
+        oldestActive_.store(0, std::memory_order_relaxed);
+        prepareSlot(0);
+    }
+
+    admitAvailable();
+    tasks_.wait();
+
+    uint64_t admitted = 0;
+    {
+        std::lock_guard<std::mutex> lock(admissionMutex_);
+        supplier_ = nullptr;
+        admitted = nextSequence_;
+        // Every event has retired; progress reads restart from zero
+        admitted_.store(0, std::memory_order_relaxed);
+        oldestActive_.store(0, std::memory_order_relaxed);
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        std::swap(error, firstError_);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return admitted;
+}
+
+void PipelinedExecutor::admitAvailable() {
+    while (true) {
+        uint64_t sequence = 0;
+        {
+            std::lock_guard<std::mutex> lock(admissionMutex_);
+            if (exhausted_ || !supplier_ ||
+                nextSequence_ >= oldestActive_.load(std::memory_order_acquire) + maxInFlight_) {
+                return;
+            }
+
+            Slot& slot = slotFor(nextSequence_);
+            if (!(*supplier_)(slot.event.input)) {
+                exhausted_ = true;
+                return;
+            }
+
+            sequence = nextSequence_++;
+            admitted_.store(nextSequence_, std::memory_order_relaxed);
+            slot.event.sequence = sequence;
+            if (admitHook_) {
+                admitHook_(slot.event);
+            }
+
+            // The event that last used the following slot has retired, so its
+            // counters can be reset before this event's stages touch them.
+            prepareSlot(sequence + 1);
+        }
+
+        for (size_t start : topology_.startStages()) {
+            release(sequence, start);
+        }
+    }
+}
+
+void PipelinedExecutor::release(uint64_t sequence, size_t stageIndex) {
+    Slot& slot = slotFor(sequence);
+    if (slot.pending[stageIndex].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // Every predecessor has finished, so the activation flag is final
+        if (slot.active[stageIndex].load(std::memory_order_acquire)) {
+            const uint64_t readyNs = StageMetrics::nowNs();
+            tasks_.run([this, sequence, stageIndex, readyNs] { runStage(sequence, stageIndex, readyNs); });
+        } else {
+            completeStage(sequence, stageIndex);
+        }
+    }
+}
+
+void PipelinedExecutor::runStage(uint64_t sequence, size_t stageIndex, uint64_t readyNs) {
+    Slot& slot = slotFor(sequence);
+
+    try {
+        stageFunction_(stageIndex, slot.event, readyNs);
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex_);
+            if (!firstError_) {
+                firstError_ = std::current_exception();
+            }
+        }
+        std::lock_guard<std::mutex> lock(admissionMutex_);
+        exhausted_ = true;
+    }
+
+    completeStage(sequence, stageIndex);
+}
+
+void PipelinedExecutor::completeStage(uint64_t sequence, size_t stageIndex) {
+    Slot& slot = slotFor(sequence);
+
+    for (size_t next : topology_.successors(stageIndex)) {
+        release(sequence, next);
+    }
+    release(sequence + 1, stageIndex);
+    for (size_t writer : writers_[stageIndex]) {
+        release(sequence + 1, writer);
+    }
+
+    if (slot.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        finishEvent(sequence);
+    }
+}
+
+void PipelinedExecutor::finishEvent(uint64_t sequence) {
+    {
+        // Events may finish out of order by a few instructions; retire them in order
+        std::lock_guard<std::mutex> lock(completionMutex_);
+        slotFor(sequence).finished = true;
+        uint64_t oldest = oldestActive_.load(std::memory_order_relaxed);
+        while (slotFor(oldest).finished) {
+            slotFor(oldest).finished = false;
+            if (retireHook_) {
+                retireHook_(slotFor(oldest).event);
+            }
+            slotFor(oldest).event.input.reset(); // drop our reference to the event data
+            ++oldest;
+        }
+        oldestActive_.store(oldest, std::memory_order_release);
+    }
+
+    admitAvailable();
+}
+
+uint64_t PipelinedExecutor::admittedCount() const {
+    return admitted_.load(std::memory_order_relaxed);
+}
+
+uint64_t PipelinedExecutor::retiredCount() const {
+    return oldestActive_.load(std::memory_order_relaxed);
+}
+
+size_t PipelinedExecutor::maxInFlight() const {
+    return maxInFlight_;
+}
+
+size_t PipelinedExecutor::slotCount() const {
+    return slots_.size();
+}
+
+void PipelinedExecutor::setAdmitHook(AdmitHook hook) {
+    admitHook_ = std::move(hook);
+}
+
+void PipelinedExecutor::setRetireHook(RetireHook hook) {
+    retireHook_ = std::move(hook);
+}
@@ -0,0 +1,247 @@
+#include "analysis_pipeline/pipeline/product_dependencies.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+void collectNames(const nlohmann::json& params, std::initializer_list<const char*> keys,
+                  std::vector<std::string>& names) {
+    for (const char* key : keys) {
+        if (!params.contains(key)) {
+            continue;
+        }
+        const auto& value = params.at(key);
+        if (value.is_string()) {
+            names.push_back(value.get<std::string>());
+        } else if (value.is_array()) {
+            for (const auto& item : value) {
+                if (item.is_string()) {
+                    names.push_back(item.get<std::string>());
+                }
+            }
+        }
+    }
+}
+
+const char* modeName(EdgeMode mode) {
+    switch (mode) {
+        case EdgeMode::Derived: return "derived";
+        case EdgeMode::Merged: return "merged";
+        case EdgeMode::Explicit: break;
+    }
+    return "explicit";
+}
+
+} // anonymous namespace
+
+StageProducts declaredProducts(const nlohmann::json& params) {
+    StageProducts products;
+    if (!params.is_object()) {
+        return products;
+    }
+    collectNames(params, {"product_name", "output_product", "histogram_name", "output_products", "writes"},
+                 products.writes);
+    collectNames(params, {"input_product", "input_products", "reads"}, products.reads);
+    return products;
+}
+
+StageProducts declaredProducts(const StageConfig& stage) {
+    StageProducts products = declaredProducts(stage.parameters);
+    if (stage.type == "ProductOutputStage" && stage.parameters.is_object()) {
+        collectNames(stage.parameters, {"products"}, products.reads);
+    }
+    return products;
+}
+
+void ProductDependencies::clear() {
+    mode_ = EdgeMode::Explicit;
+    ids_.clear();
+    successors_.clear();
+    order_.clear();
+    edgeProducts_.clear();
+    unproducedInputs_.clear();
+}
+
+bool ProductDependencies::derive(std::vector<StageConfig>& stages, const std::vector<StageProducts>& products,
+                                 EdgeMode mode) {
+    clear();
+    mode_ = mode;
+    const size_t count = stages.size();
+
+    std::unordered_map<std::string, size_t> indexById;
+    for (const auto& stage : stages) {
+        indexById.emplace(stage.id, ids_.size());
+        ids_.push_back(stage.id);
+    }
+    successors_.resize(count);
+
+    auto addEdge = [this](size_t from, size_t to, const std::string& product) {
+        if (from == to) {
+            return;
+        }
+        auto& next = successors_[from];
+        if (std::find(next.begin(), next.end(), to) == next.end()) {
+            next.push_back(to);
+        }
+        if (!product.empty()) {
+            edgeProducts_[{from, to}].push_back(product);
+        }
+    };
+
+    if (mode != EdgeMode::Derived) {
+        for (size_t from = 0; from < count; ++from) {
+            for (const auto& nextId : stages[from].next) {
+                auto it = indexById.find(nextId);
+                if (it == indexById.end()) {
+                    spdlog::error("[ProductDependencies] Stage '{}' lists unknown next id '{}'.", ids_[from], nextId);
+                    return false;
+                }
+                addEdge(from, it->second, std::string());
+            }
+        }
+    }
+
+    if (mode != EdgeMode::Explicit) {
+        std::unordered_map<std::string, size_t> writerOf;
+        for (size_t i = 0; i < count && i < products.size(); ++i) {
+            for (const auto& name : products[i].writes) {
+                auto [it, inserted] = writerOf.emplace(name, i);
+                if (!inserted && it->second != i) {
+                    spdlog::error("[ProductDependencies] Product '{}' is written by both '{}' and '{}'.",
+                                  name, ids_[it->second], ids_[i]);
+                    return false;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < count && i < products.size(); ++i) {
+            for (const auto& name : products[i].reads) {
+                auto it = writerOf.find(name);
+                if (it != writerOf.end()) {
+                    addEdge(it->second, i, name);
+                } else if (std::find(unproducedInputs_.begin(), unproducedInputs_.end(), name) == unproducedInputs_.end()) {
+                    unproducedInputs_.push_back(name);
+                }
+            }
+        }
+        for (const auto& name : unproducedInputs_) {
+            spdlog::warn("[ProductDependencies] Product '{}' is read but no stage declares writing it.", name);
+        }
+    }
+
+    // Kahn's algorithm; stages left over sit on or behind a cycle
+    std::vector<size_t> inDegree(count, 0);
+    for (const auto& next : successors_) {
+        for (size_t to : next) {
+            ++inDegree[to];
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (inDegree[i] == 0) {
+            order_.push_back(i);
+        }
+    }
+    for (size_t k = 0; k < order_.size(); ++k) {
+        for (size_t to : successors_[order_[k]]) {
+            if (--inDegree[to] == 0) {
+                order_.push_back(to);
+            }
+        }
+    }
+    if (order_.size() != count) {
+        std::string involved;
+        for (size_t i = 0; i < count; ++i) {
+            if (inDegree[i] > 0) {
+                involved += (involved.empty() ? "" : ", ") + ids_[i];
+            }
+        }
+        spdlog::error("[ProductDependencies] Stage graph has a cycle through: {}", involved);
+        return false;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        stages[i].next.clear();
+        for (size_t to : successors_[i]) {
+            stages[i].next.push_back(ids_[to]);
+        }
+    }
+
+    const auto path = criticalPath();
+    spdlog::debug("[ProductDependencies] {} edge mode; critical path of {} stage(s).", modeName(mode_), path.size());
+    return true;
+}
+
+std::vector<size_t> ProductDependencies::criticalPath(const std::function<double(size_t)>& stageCostNs) const {
+    const size_t count = ids_.size();
+    if (count == 0 || order_.size() != count) {
+        return {};
+    }
+
+    // reach[v]: longest chain ending right before v; finish[v] includes v
+    std::vector<double> reach(count, 0.0);
+    std::vector<double> finish(count, 0.0);
+    std::vector<size_t> parent(count, count);
+    for (size_t v : order_) {
+        finish[v] = reach[v] + (stageCostNs ? stageCostNs(v) : 1.0);
+        for (size_t to : successors_[v]) {
+            if (parent[to] == count || finish[v] > reach[to]) {
+                reach[to] = finish[v];
+                parent[to] = v;
+            }
+        }
+    }
+
+    size_t last = 0;
+    for (size_t i = 1; i < count; ++i) {
+        if (finish[i] > finish[last]) {
+            last = i;
+        }
+    }
+
+    std::vector<size_t> path;
+    for (size_t v = last; v != count; v = parent[v]) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+nlohmann::json ProductDependencies::toJson(const std::function<double(size_t)>& stageCostNs) const {
+    nlohmann::json edges = nlohmann::json::array();
+    for (size_t from = 0; from < successors_.size(); ++from) {
+        for (size_t to : successors_[from]) {
+            auto it = edgeProducts_.find({from, to});
+            edges.push_back({
+                {"from", ids_[from]},
+                {"to", ids_[to]},
+                {"products", it != edgeProducts_.end() ? nlohmann::json(it->second) : nlohmann::json::array()}
+            });
+        }
+    }
+
+    nlohmann::json pathIds = nlohmann::json::array();
+    double pathNs = 0.0;
+    for (size_t v : criticalPath(stageCostNs)) {
+        pathIds.push_back(ids_[v]);
+        if (stageCostNs) {
+            pathNs += stageCostNs(v);
+        }
+    }
+
+    nlohmann::json critical;
+    critical["stages"] = pathIds;
+    critical["length"] = pathIds.size();
+    if (stageCostNs) {
+        critical["estimated_ns"] = pathNs;
+    }
+
+    nlohmann::json j;
+    j["mode"] = modeName(mode_);
+    j["edges"] = std::move(edges);
+    j["unproduced_inputs"] = unproducedInputs_;
+    j["critical_path"] = std::move(critical);
+    return j;
+}
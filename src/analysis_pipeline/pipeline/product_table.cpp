@@ -0,0 +1,111 @@
+#include "analysis_pipeline/pipeline/product_table.h"
+
+namespace {
+
+thread_local uint64_t currentSequence = UINT64_MAX;
+thread_local size_t currentSlot = 0;
+
+const std::string kUnknownProduct;
+
+} // anonymous namespace
+
+void ProductTable::clear() {
+    handles_.clear();
+    names_.clear();
+    subscribed_.clear();
+    recentSubscriptions_.clear();
+    slotCount_ = 0;
+    entries_.reset();
+}
+
+ProductHandle ProductTable::resolve(const std::string& name) {
+    auto [it, inserted] = handles_.emplace(name, static_cast<ProductHandle>(names_.size()));
+    if (inserted) {
+        names_.push_back(name);
+        subscribed_.push_back(false);
+    }
+    return it->second;
+}
+
+void ProductTable::finalize() {
+    setSlotCount(1);
+}
+
+void ProductTable::setSlotCount(size_t slotCount) {
+    slotCount_ = slotCount;
+    entries_ = std::make_unique<Entry[]>(slotCount_ * names_.size());
+}
+
+size_t ProductTable::slotCount() const {
+    return slotCount_;
+}
+
+ProductHandle ProductTable::subscribe(const std::string& name) {
+    ProductHandle handle = find(name);
+    if (handle != kInvalidProductHandle) {
+        subscribed_[handle] = true;
+        recentSubscriptions_.push_back(handle);
+    }
+    return handle;
+}
+
+std::vector<ProductHandle> ProductTable::takeSubscriptions() {
+    std::vector<ProductHandle> handles;
+    handles.swap(recentSubscriptions_);
+    return handles;
+}
+
+ProductHandle ProductTable::find(const std::string& name) const {
+    auto it = handles_.find(name);
+    return it != handles_.end() ? it->second : kInvalidProductHandle;
+}
+
+bool ProductTable::isSubscribed(ProductHandle handle) const {
+    return handle < subscribed_.size() && subscribed_[handle];
+}
+
+const std::string& ProductTable::name(ProductHandle handle) const {
+    return handle < names_.size() ? names_[handle] : kUnknownProduct;
+}
+
+size_t ProductTable::size() const {
+    return names_.size();
+}
+
+void ProductTable::publish(ProductHandle handle, const TObject* object, uint64_t sequence, size_t slot) {
+    Entry& entry = entries_[slot * names_.size() + handle];
+    entry.sequence.store(kNoEvent, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.object.store(object, std::memory_order_relaxed);
+    entry.sequence.store(sequence, std::memory_order_release);
+}
+
+const TObject* ProductTable::get(ProductHandle handle) const {
+    return get(handle, currentSequence, currentSlot);
+}
+
+const TObject* ProductTable::get(ProductHandle handle, uint64_t sequence, size_t slot) const {
+    if (handle >= names_.size() || slot >= slotCount_ || sequence == kNoEvent) {
+        return nullptr;
+    }
+    const Entry& entry = entries_[slot * names_.size() + handle];
+    if (entry.sequence.load(std::memory_order_acquire) != sequence) {
+        return nullptr;
+    }
+    const TObject* object = entry.object.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // A concurrent publish() for a later event invalidates what was read
+    return entry.sequence.load(std::memory_order_relaxed) == sequence ? object : nullptr;
+}
+
+ProductTable::Scope::Scope(uint64_t sequence, size_t slot)
+    : previousSequence_(currentSequence),
+      previousSlot_(currentSlot) {
+    currentSequence = sequence;
+    currentSlot = slot;
+}
+
+ProductTable::Scope::~Scope() {
+    currentSequence = previousSequence_;
+    currentSlot = previousSlot_;
+}
@@ -0,0 +1,316 @@
+#include "analysis_pipeline/pipeline/reloadable_pipeline.h"
+
+#include <algorithm>
+#include <map>
+
+#include <spdlog/spdlog.h>
+
+#include <TROOT.h>
+
+#include "analysis_pipeline/monitoring/stage_metrics.h"
+
+ReloadablePipeline::ReloadablePipeline(std::shared_ptr<ConfigManager> configManager)
+    : configManager_(std::move(configManager))
+{}
+
+ReloadablePipeline::~ReloadablePipeline() {
+    if (builder_.joinable()) {
+        builder_.join();
+    }
+    if (retirer_.joinable()) {
+        retirer_.join();
+    }
+}
+
+bool ReloadablePipeline::buildFromConfig() {
+    if (!configManager_) {
+        spdlog::error("[ReloadablePipeline] ConfigManager not set.");
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_ = std::make_unique<Pipeline>(configManager_);
+    if (!active_->buildFromConfig()) {
+        active_.reset();
+        return false;
+    }
+    generation_ = 1;
+    return true;
+}
+
+bool ReloadablePipeline::requestRebuild(std::shared_ptr<ConfigManager> configManager, bool carryOverProducts) {
+    if (!configManager) {
+        spdlog::error("[ReloadablePipeline] requestRebuild() called without a ConfigManager.");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_ || building_.load() || swapReady_.load()) {
+        spdlog::warn("[ReloadablePipeline] Rebuild request ignored: {}.",
+                     active_ ? "a rebuild is already in progress" : "no active pipeline");
+        return false;
+    }
+    startBuild([configManager]() { return configManager; }, carryOverProducts);
+    return true;
+}
+
+bool ReloadablePipeline::requestRebuild(std::vector<std::string> configPaths, bool carryOverProducts) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_ || building_.load() || swapReady_.load()) {
+        spdlog::warn("[ReloadablePipeline] Rebuild request ignored: {}.",
+                     active_ ? "a rebuild is already in progress" : "no active pipeline");
+        return false;
+    }
+    startBuild([paths = std::move(configPaths)]() -> std::shared_ptr<ConfigManager> {
+        auto config = std::make_shared<ConfigManager>();
+        if (!config->loadFiles(paths) || !config->validate()) {
+            spdlog::error("[ReloadablePipeline] Failed to load or validate the new configuration.");
+            return nullptr;
+        }
+        return config;
+    }, carryOverProducts);
+    return true;
+}
+
+void ReloadablePipeline::startBuild(std::function<std::shared_ptr<ConfigManager>()> loadConfig,
+                                    bool carryOverProducts) {
+    // Called with mutex_ held; the previous builder has finished
+    if (builder_.joinable()) {
+        builder_.join();
+    }
+
+    // The new stages are created and initialized while the active ones run
+    ROOT::EnableThreadSafety();
+
+    building_.store(true);
+    const size_t maxInFlight = active_->getMaxEventsInFlight();
+    const bool profiling = active_->isProfilingEnabled();
+
+    builder_ = std::thread([this, loadConfig = std::move(loadConfig), carryOverProducts, maxInFlight, profiling]() {
+        const uint64_t startNs = StageMetrics::nowNs();
+        std::shared_ptr<ConfigManager> config = loadConfig();
+        std::unique_ptr<Pipeline> next;
+        if (config) {
+            // The active pipeline owns the process-wide logger, the metrics
+            // segment and the checkpoint file until the swap
+            auto buildConfig = std::make_shared<ConfigManager>(*config);
+            buildConfig->setLoggerConfig(nlohmann::json());
+            buildConfig->setMonitoringConfig(nlohmann::json());
+            buildConfig->setCheckpointConfig(nlohmann::json());
+
+            next = std::make_unique<Pipeline>(buildConfig);
+            // Output files may be the ones the active pipeline is writing;
+            // they are opened at the swap
+            next->setDeferOutputFiles(true);
+            next->setMaxEventsInFlight(maxInFlight);
+            next->setProfilingEnabled(profiling);
+            if (!next->buildFromConfig()) {
+                next.reset();
+            }
+        }
+        const double buildMs = (StageMetrics::nowNs() - startNs) / 1e6;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastBuildMs_ = buildMs;
+        if (!next) {
+            ++failedBuilds_;
+            building_.store(false);
+            spdlog::error("[ReloadablePipeline] Rebuild failed after {:.1f} ms; keeping the active pipeline.", buildMs);
+            return;
+        }
+        pending_ = std::move(next);
+        pendingConfig_ = std::move(config);
+        pendingCarryOver_ = carryOverProducts;
+        building_.store(false);
+        swapReady_.store(true, std::memory_order_release);
+        spdlog::info("[ReloadablePipeline] New pipeline built in {:.1f} ms; swapping at the next event boundary.",
+                     buildMs);
+    });
+}
+
+bool ReloadablePipeline::isSwapReady() const {
+    return swapReady_.load(std::memory_order_acquire);
+}
+
+bool ReloadablePipeline::isRebuildInProgress() const {
+    return building_.load();
+}
+
+bool ReloadablePipeline::swapIfReady() {
+    if (!swapReady_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    std::unique_ptr<Pipeline> retired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        retired = swapLocked();
+    }
+    if (swapCallback_) {
+        swapCallback_(*retired, *active_);
+    }
+    retire(std::move(retired));
+    return true;
+}
+
+std::unique_ptr<Pipeline> ReloadablePipeline::swapLocked() {
+    std::unique_ptr<Pipeline> next = std::move(pending_);
+    swapReady_.store(false);
+
+    // The retired generation's run ends here; its scheduled stages must be
+    // done with the products before they move
+    try {
+        active_->finishRun();
+    } catch (const std::exception& e) {
+        spdlog::error("[ReloadablePipeline] Scheduled stage of the retired pipeline failed: {}", e.what());
+    }
+
+    lastCarried_.clear();
+    if (pendingCarryOver_) {
+        carryOverProducts(*active_, *next, lastCarried_);
+    }
+
+    // Hand the output files over: the old stages write out their records
+    // first, and the new ones append to files they share with them
+    const std::map<std::string, uint64_t> continued = active_->closeOutputFiles();
+    if (!next->openOutputFiles(continued)) {
+        spdlog::error("[ReloadablePipeline] Failed to open the output files of the new pipeline.");
+    }
+
+    // Hand the metrics segment over: the old writer unlinks it first
+    active_->stopMetricsSegment();
+    const auto& monitoring = pendingConfig_->getMonitoringConfig();
+    if (monitoring.contains("shm_segment")) {
+        next->startMetricsSegment(monitoring.at("shm_segment").get<std::string>(),
+                                  monitoring.value("interval_ms", 500u));
+    }
+    // Products just moved; the next checkpoint is the new pipeline's
+    active_->stopCheckpointing(false);
+    const auto& checkpoint = pendingConfig_->getCheckpointConfig();
+    if (checkpoint.contains("path")) {
+        next->startCheckpointing(checkpoint.at("path").get<std::string>(), checkpoint.value("interval_s", 0.0));
+    }
+
+    next->setConfigManager(pendingConfig_);
+    configManager_ = std::move(pendingConfig_);
+
+    std::unique_ptr<Pipeline> retired = std::move(active_);
+    active_ = std::move(next);
+    ++generation_;
+    ++swaps_;
+    spdlog::info("[ReloadablePipeline] Swapped in pipeline generation {} ({} product(s) carried over).",
+                 generation_, lastCarried_.size());
+    return retired;
+}
+
+void ReloadablePipeline::carryOverProducts(Pipeline& from, Pipeline& to, std::vector<std::string>& carried) {
+    std::map<std::string, std::string> oldTypes;
+    for (const auto& stage : from.getConfigManager()->getPipelineStages()) {
+        oldTypes[stage.id] = stage.type;
+    }
+
+    auto& source = from.getDataProductManager();
+    auto& target = to.getDataProductManager();
+    for (const auto& stage : to.getConfigManager()->getPipelineStages()) {
+        auto it = oldTypes.find(stage.id);
+        if (it == oldTypes.end() || it->second != stage.type) {
+            continue;
+        }
+        const StageProducts* oldProducts = from.getStageProducts(stage.id);
+        const StageProducts* newProducts = to.getStageProducts(stage.id);
+        if (!oldProducts || !newProducts) {
+            continue;
+        }
+        // Only products the stage still writes under the same name
+        for (const auto& name : newProducts->writes) {
+            if (std::find(oldProducts->writes.begin(), oldProducts->writes.end(), name) == oldProducts->writes.end() ||
+                !source.hasProduct(name)) {
+                continue;
+            }
+            auto product = source.extractProduct(name);
+            if (product) {
+                target.addOrUpdate(name, std::move(product));
+                carried.push_back(name);
+            }
+        }
+    }
+}
+
+void ReloadablePipeline::retire(std::unique_ptr<Pipeline> pipeline) {
+    // Stage destructors and product cleanup can be slow; keep them off the event path
+    if (retirer_.joinable()) {
+        retirer_.join();
+    }
+    retirer_ = std::thread([retired = std::move(pipeline)]() mutable {
+        retired.reset();
+    });
+}
+
+uint64_t ReloadablePipeline::executeStream(const PipelinedExecutor::InputSupplier& nextInput, InputSource* source) {
+    if (!active_) {
+        spdlog::error("[ReloadablePipeline] executeStream() called before buildFromConfig().");
+        return 0;
+    }
+
+    uint64_t processed = 0;
+    bool exhausted = false;
+    uint64_t drainStartNs = 0;
+    while (!exhausted) {
+        if (drainStartNs != 0) {
+            swapIfReady();
+            std::lock_guard<std::mutex> lock(mutex_);
+            lastDrainMs_ = (StageMetrics::nowNs() - drainStartNs) / 1e6;
+            drainStartNs = 0;
+        }
+
+        processed += active_->executeStream([&](std::shared_ptr<const InputBundle>& input) {
+            // Stop admitting; in-flight events finish on the current pipeline
+            if (swapReady_.load(std::memory_order_acquire)) {
+                drainStartNs = StageMetrics::nowNs();
+                return false;
+            }
+            if (!nextInput(input)) {
+                exhausted = true;
+                return false;
+            }
+            return true;
+        }, source);
+    }
+    return processed;
+}
+
+uint64_t ReloadablePipeline::run(InputSource& source) {
+    spdlog::info("[ReloadablePipeline] Reading events from {}", source.describe());
+    uint64_t processed = executeStream([&source](std::shared_ptr<const InputBundle>& input) {
+        return source.next(input);
+    }, &source);
+    active_->finishRun();
+    spdlog::info("[ReloadablePipeline] Processed {} events from {} over {} pipeline generation(s)",
+                 processed, source.describe(), generation_);
+    return processed;
+}
+
+void ReloadablePipeline::execute() {
+    swapIfReady();
+    active_->execute();
+}
+
+Pipeline& ReloadablePipeline::active() {
+    return *active_;
+}
+
+void ReloadablePipeline::setSwapCallback(SwapCallback callback) {
+    swapCallback_ = std::move(callback);
+}
+
+nlohmann::json ReloadablePipeline::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nlohmann::json j;
+    j["generation"] = generation_;
+    j["swaps"] = swaps_;
+    j["failed_builds"] = failedBuilds_;
+    j["rebuilding"] = building_.load();
+    j["swap_ready"] = swapReady_.load();
+    j["last_build_ms"] = lastBuildMs_;
+    j["last_drain_ms"] = lastDrainMs_;
+    j["last_carried_products"] = lastCarried_;
+    return j;
+}
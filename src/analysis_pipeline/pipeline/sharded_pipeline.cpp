@@ -0,0 +1,333 @@
+#include "analysis_pipeline/pipeline/sharded_pipeline.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+#include <TClass.h>
+#include <TFile.h>
+#include <TH1.h>
+#include <TList.h>
+#include <TObject.h>
+#include <TROOT.h>
+
+#include "analysis_pipeline/monitoring/stage_metrics.h"
+
+namespace {
+
+const std::string kReplicaPlaceholder = "{replica}";
+
+// Replaces "{replica}" in every string of a stage's parameters
+void substituteReplica(nlohmann::json& value, const std::string& replica) {
+    if (value.is_string()) {
+        std::string text = value.get<std::string>();
+        size_t pos = text.find(kReplicaPlaceholder);
+        if (pos == std::string::npos) {
+            return;
+        }
+        while (pos != std::string::npos) {
+            text.replace(pos, kReplicaPlaceholder.size(), replica);
+            pos = text.find(kReplicaPlaceholder, pos + replica.size());
+        }
+        value = text;
+    } else if (value.is_structured()) {
+        for (auto& item : value) {
+            substituteReplica(item, replica);
+        }
+    }
+}
+
+// "out/products.bin" -> "out/products_2.bin"
+std::string replicaFilePath(const std::string& path, size_t replica) {
+    const size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash) || dot == slash + 1) {
+        dot = path.size();
+    }
+    return path.substr(0, dot) + "_" + std::to_string(replica) + path.substr(dot);
+}
+
+} // anonymous namespace
+
+ShardedPipeline::ShardedPipeline(std::shared_ptr<ConfigManager> configManager, size_t replicas)
+    : configManager_(std::move(configManager)),
+      requestedReplicas_(replicas)
+{}
+
+ShardedPipeline::~ShardedPipeline() = default;
+
+bool ShardedPipeline::buildFromConfig() {
+    if (!configManager_) {
+        spdlog::error("[ShardedPipeline] ConfigManager not set.");
+        return false;
+    }
+
+    size_t count = requestedReplicas_;
+    if (count == 0) {
+        count = static_cast<size_t>(configManager_->getExecutionConfig().replicas);
+    }
+    count = std::max<size_t>(1, count);
+
+    if (count > 1) {
+        // Replicas run concurrently; keep their histograms out of the shared
+        // gDirectory, where equal names would replace each other
+        ROOT::EnableThreadSafety();
+        TH1::AddDirectory(kFALSE);
+    }
+
+    replicas_.clear();
+    replicaEvents_ = std::make_unique<std::atomic<uint64_t>[]>(count);
+    for (size_t i = 0; i < count; ++i) {
+        auto config = std::make_shared<ConfigManager>(*configManager_);
+        std::vector<StageConfig> stages = config->getPipelineStages();
+        for (auto& stage : stages) {
+            // Output files are opened for writing by every replica; without
+            // "{replica}" in the path, replicas after the first get a suffix
+            // instead of truncating each other's file
+            if (stage.type == "ProductOutputStage" && i > 0 && stage.parameters.is_object()) {
+                auto path = stage.parameters.find("path");
+                if (path != stage.parameters.end() && path->is_string() &&
+                    path->get<std::string>().find(kReplicaPlaceholder) == std::string::npos) {
+                    *path = replicaFilePath(path->get<std::string>(), i);
+                }
+            }
+            substituteReplica(stage.parameters, std::to_string(i));
+        }
+        config->setPipelineStages(stages);
+        nlohmann::json monitoring = config->getMonitoringConfig();
+        if (monitoring.contains("shm_segment")) {
+            // One metrics segment per replica: "/name_{replica}", or "/name", "/name_1", ...
+            const std::string name = monitoring["shm_segment"].get<std::string>();
+            if (name.find(kReplicaPlaceholder) != std::string::npos) {
+                substituteReplica(monitoring["shm_segment"], std::to_string(i));
+            } else if (i > 0) {
+                monitoring["shm_segment"] = name + "_" + std::to_string(i);
+            }
+            config->setMonitoringConfig(monitoring);
+        }
+        nlohmann::json checkpoint = config->getCheckpointConfig();
+        if (checkpoint.contains("path")) {
+            // Each replica checkpoints its own products, named like the segments
+            const std::string path = checkpoint["path"].get<std::string>();
+            if (path.find(kReplicaPlaceholder) != std::string::npos) {
+                substituteReplica(checkpoint["path"], std::to_string(i));
+            } else if (i > 0) {
+                checkpoint["path"] = path + "_" + std::to_string(i);
+            }
+            config->setCheckpointConfig(checkpoint);
+        }
+        if (i > 0) {
+            // The first replica already set up the process-wide logger
+            config->setLoggerConfig(nlohmann::json());
+        }
+
+        auto replica = std::make_unique<Pipeline>(config);
+        // Stages of one replica never see more than one event at a time
+        replica->setMaxEventsInFlight(1);
+        if (!replica->buildFromConfig()) {
+            spdlog::error("[ShardedPipeline] Failed to build replica {}.", i);
+            replicas_.clear();
+            return false;
+        }
+        replicas_.push_back(std::move(replica));
+    }
+
+    spdlog::info("[ShardedPipeline] Built {} replica(s) of the pipeline.", replicas_.size());
+    return true;
+}
+
+size_t ShardedPipeline::replicaCount() const {
+    return replicas_.size();
+}
+
+Pipeline& ShardedPipeline::replica(size_t index) {
+    return *replicas_.at(index);
+}
+
+uint64_t ShardedPipeline::executeStream(const PipelinedExecutor::InputSupplier& nextInput, InputSource* source) {
+    if (replicas_.empty()) {
+        spdlog::error("[ShardedPipeline] executeStream() called before buildFromConfig().");
+        return 0;
+    }
+
+    std::mutex inputMutex;
+    bool exhausted = false;
+    std::vector<uint64_t> processed(replicas_.size(), 0);
+    std::vector<std::exception_ptr> errors(replicas_.size());
+
+    auto runReplica = [&](size_t index) {
+        auto supplier = [&](std::shared_ptr<const InputBundle>& input) {
+            std::lock_guard<std::mutex> lock(inputMutex);
+            if (exhausted || !nextInput(input)) {
+                exhausted = true;
+                return false;
+            }
+            replicaEvents_[index].fetch_add(1, std::memory_order_relaxed);
+            return true;
+        };
+
+        try {
+            processed[index] = replicas_[index]->executeStream(supplier, source);
+        } catch (...) {
+            errors[index] = std::current_exception();
+            std::lock_guard<std::mutex> lock(inputMutex);
+            exhausted = true; // stop the other replicas as well
+        }
+    };
+
+    // Plain threads rather than TBB tasks: a replica blocked in its own
+    // executor must not pick up and nest another replica's event loop
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < replicas_.size(); ++i) {
+        threads.emplace_back(runReplica, i);
+    }
+    runReplica(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    uint64_t total = 0;
+    for (uint64_t count : processed) {
+        total += count;
+    }
+    return total;
+}
+
+uint64_t ShardedPipeline::run(InputSource& source) {
+    spdlog::info("[ShardedPipeline] Reading events from {} with {} replica(s)", source.describe(), replicas_.size());
+    uint64_t processed = executeStream([&source](std::shared_ptr<const InputBundle>& input) {
+        return source.next(input);
+    }, &source);
+    // Scheduled stages see their own replica's products, before any reduce()
+    for (auto& replica : replicas_) {
+        replica->finishRun();
+    }
+    spdlog::info("[ShardedPipeline] Processed {} events from {}", processed, source.describe());
+    return processed;
+}
+
+void ShardedPipeline::registerMerger(const std::string& productName, Merger merger) {
+    std::lock_guard<std::mutex> lock(mergersMutex_);
+    mergers_[productName] = std::move(merger);
+}
+
+void ShardedPipeline::setReducedProducts(std::vector<std::string> names) {
+    reducedProducts_ = std::move(names);
+}
+
+bool ShardedPipeline::mergeProduct(const std::string& name, TObject* target,
+                                   const std::vector<const TObject*>& others) {
+    Merger merger;
+    {
+        std::lock_guard<std::mutex> lock(mergersMutex_);
+        auto it = mergers_.find(name);
+        if (it != mergers_.end()) {
+            merger = it->second;
+        }
+    }
+    if (merger) {
+        return merger(target, others);
+    }
+
+    ROOT::MergeFunc_t merge = target->IsA()->GetMerge();
+    if (!merge) {
+        return false;
+    }
+    TList list; // does not own the clones
+    for (const TObject* other : others) {
+        list.Add(const_cast<TObject*>(other));
+    }
+    return merge(target, &list, nullptr) >= 0;
+}
+
+ShardedPipeline::ReducedProducts ShardedPipeline::reduce() {
+    ReducedProducts reduced;
+    if (replicas_.empty()) {
+        return reduced;
+    }
+
+    const uint64_t startNs = StageMetrics::nowNs();
+    std::vector<std::string> names = reducedProducts_;
+    if (names.empty()) {
+        names = replicas_.front()->getDataProductManager().getAllNames();
+    }
+
+    nlohmann::json unmerged = nlohmann::json::array();
+    for (const auto& name : names) {
+        // Clone under each replica's read lock, merge without holding any
+        std::vector<std::unique_ptr<TObject>> parts;
+        for (auto& replica : replicas_) {
+            auto& manager = replica->getDataProductManager();
+            if (!manager.hasProduct(name)) {
+                continue;
+            }
+            auto product = manager.checkoutRead(name);
+            const TObject* obj = product->getObject();
+            if (obj) {
+                parts.emplace_back(obj->Clone());
+            }
+        }
+        if (parts.empty()) {
+            continue;
+        }
+
+        std::unique_ptr<TObject> result = std::move(parts.front());
+        std::vector<const TObject*> others;
+        for (size_t i = 1; i < parts.size(); ++i) {
+            others.push_back(parts[i].get());
+        }
+        if (!others.empty() && !mergeProduct(name, result.get(), others)) {
+            spdlog::debug("[ShardedPipeline] Product '{}' ({}) is not mergeable.", name, result->ClassName());
+            unmerged.push_back(name);
+            continue;
+        }
+        reduced[name] = std::move(result);
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    lastReduce_ = {
+        {"merged", reduced.size()},
+        {"unmerged", std::move(unmerged)},
+        {"ms", (StageMetrics::nowNs() - startNs) / 1e6}
+    };
+    return reduced;
+}
+
+bool ShardedPipeline::writeReduced(const std::string& path) {
+    ReducedProducts reduced = reduce();
+
+    std::unique_ptr<TFile> file(TFile::Open(path.c_str(), "RECREATE"));
+    if (!file || file->IsZombie()) {
+        spdlog::error("[ShardedPipeline] Cannot open '{}' for writing.", path);
+        return false;
+    }
+    for (const auto& [name, obj] : reduced) {
+        file->WriteTObject(obj.get(), name.c_str());
+    }
+    file->Close();
+
+    spdlog::info("[ShardedPipeline] Wrote {} reduced product(s) to {}", reduced.size(), path);
+    return true;
+}
+
+nlohmann::json ShardedPipeline::getStats() const {
+    nlohmann::json events = nlohmann::json::array();
+    for (size_t i = 0; i < replicas_.size(); ++i) {
+        events.push_back(replicaEvents_[i].load(std::memory_order_relaxed));
+    }
+
+    nlohmann::json j;
+    j["replicas"] = replicas_.size();
+    j["events"] = std::move(events);
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    j["last_reduce"] = lastReduce_;
+    return j;
+}
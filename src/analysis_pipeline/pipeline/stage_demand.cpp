@@ -0,0 +1,48 @@
+#include "analysis_pipeline/pipeline/stage_demand.h"
+
+#include <algorithm>
+
+StageDemand StageDemand::resolve(const StageTopology& topology,
+                                 const std::vector<StageProducts>& products,
+                                 const OutputsConfig& outputs,
+                                 std::vector<std::string>& unknown) {
+    StageDemand demand;
+    demand.needed_.assign(topology.size(), 0);
+
+    std::vector<size_t> pending;
+    for (const auto& id : outputs.stages) {
+        if (auto index = topology.indexOf(id)) {
+            pending.push_back(*index);
+        } else {
+            unknown.push_back(id);
+        }
+    }
+    for (const auto& name : outputs.products) {
+        bool written = false;
+        for (size_t i = 0; i < products.size() && i < topology.size(); ++i) {
+            const auto& writes = products[i].writes;
+            if (std::find(writes.begin(), writes.end(), name) != writes.end()) {
+                pending.push_back(i);
+                written = true;
+            }
+        }
+        if (!written) {
+            unknown.push_back(name);
+        }
+    }
+
+    // Walk the predecessors of every sink
+    while (!pending.empty()) {
+        const size_t index = pending.back();
+        pending.pop_back();
+        if (demand.needed_[index]) {
+            continue;
+        }
+        demand.needed_[index] = 1;
+        ++demand.count_;
+        for (size_t prev : topology.predecessors(index)) {
+            pending.push_back(prev);
+        }
+    }
+    return demand;
+}
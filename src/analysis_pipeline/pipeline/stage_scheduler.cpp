@@ -0,0 +1,251 @@
+#include "analysis_pipeline/pipeline/stage_scheduler.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+#include <tbb/task_group.h>
+
+#include "analysis_pipeline/monitoring/stage_metrics.h"
+
+StageScheduler::~StageScheduler() {
+    wait();
+}
+
+void StageScheduler::configure(std::vector<Entry> entries, tbb::task_arena* arena, RunFunction run,
+                               PrepareFunction prepare) {
+    clear();
+    const uint64_t nowNs = StageMetrics::nowNs();
+    for (auto& entry : entries) {
+        auto state = std::make_unique<State>();
+        state->entry = std::move(entry);
+        state->lastDueNs = nowNs;
+        states_.push_back(std::move(state));
+    }
+    arena_ = arena;
+    run_ = std::move(run);
+    prepare_ = std::move(prepare);
+}
+
+void StageScheduler::clear() {
+    wait();
+    states_.clear();
+    arena_ = nullptr;
+    run_ = nullptr;
+    prepare_ = nullptr;
+    lastEventIndex_ = 0;
+    eventsSinceFinish_ = false;
+    anyDue_.store(false, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    firstError_ = nullptr;
+}
+
+bool StageScheduler::empty() const {
+    return states_.empty();
+}
+
+void StageScheduler::eventsRetired(uint64_t eventIndex, uint64_t count) {
+    if (states_.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    lastEventIndex_ = eventIndex;
+    eventsSinceFinish_ = true;
+
+    uint64_t nowNs = 0;
+    for (auto& state : states_) {
+        const StageSchedule& schedule = state->entry.schedule;
+        bool due = false;
+        if (schedule.everyEvents > 0) {
+            state->eventsSinceRun += count;
+            due = state->eventsSinceRun >= schedule.everyEvents;
+        }
+        if (!due && schedule.everySeconds > 0.0) {
+            if (nowNs == 0) {
+                nowNs = StageMetrics::nowNs();
+            }
+            due = static_cast<double>(nowNs - state->lastDueNs) >= schedule.everySeconds * 1e9;
+        }
+        if (!due) {
+            continue;
+        }
+
+        state->eventsSinceRun = 0;
+        state->lastDueNs = nowNs != 0 ? nowNs : StageMetrics::nowNs();
+        if (state->running.load(std::memory_order_acquire)) {
+            // The previous background run has not finished; catch up next time
+            state->skipped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (state->dueNs == 0) {
+            state->dueNs = state->lastDueNs;
+        }
+        anyDue_.store(true, std::memory_order_release);
+    }
+}
+
+bool StageScheduler::due() const {
+    return anyDue_.load(std::memory_order_acquire);
+}
+
+void StageScheduler::runDue() {
+    if (!due()) {
+        return;
+    }
+
+    std::vector<State*> background;
+    std::vector<State*> blocking;
+    uint64_t eventIndex = 0;
+    uint64_t readyNs = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        eventIndex = lastEventIndex_;
+        for (auto& state : states_) {
+            if (state->dueNs != 0) {
+                readyNs = readyNs == 0 ? state->dueNs : std::min(readyNs, state->dueNs);
+                state->dueNs = 0;
+                (copiesInputs(*state) && arena_ ? background : blocking).push_back(state.get());
+            }
+        }
+        anyDue_.store(false, std::memory_order_relaxed);
+    }
+    runStages(background, eventIndex, readyNs, true);
+    runStages(blocking, eventIndex, readyNs, false);
+}
+
+void StageScheduler::wait() {
+    if (arena_) {
+        arena_->execute([this]() { background_.wait(); });
+    } else {
+        background_.wait();
+    }
+}
+
+bool StageScheduler::copiesInputs(const State& state) const {
+    return prepare_ && !state.entry.schedule.blocking;
+}
+
+void StageScheduler::runStages(const std::vector<State*>& states, uint64_t eventIndex, uint64_t readyNs,
+                               bool background) {
+    std::vector<State*> ready;
+    for (State* state : states) {
+        if (copiesInputs(*state)) {
+            const uint64_t startNs = StageMetrics::nowNs();
+            try {
+                prepare_(state->entry.stageIndex);
+            } catch (...) {
+                recordFailure(*state, eventIndex);
+                continue;
+            }
+            state->heldNs.fetch_add(StageMetrics::nowNs() - startNs, std::memory_order_relaxed);
+        }
+        ready.push_back(state);
+    }
+    if (ready.empty()) {
+        return;
+    }
+
+    if (background) {
+        // Spawned into the arena; its workers run them while events flow
+        for (State* state : ready) {
+            state->running.store(true, std::memory_order_release);
+            arena_->execute([this, state, eventIndex, readyNs]() {
+                background_.run([this, state, eventIndex, readyNs]() {
+                    runOne(*state, eventIndex, readyNs);
+                    state->running.store(false, std::memory_order_release);
+                });
+            });
+        }
+        return;
+    }
+
+    auto runAll = [&]() {
+        tbb::task_group group;
+        for (State* state : ready) {
+            group.run([this, state, eventIndex, readyNs]() { runOne(*state, eventIndex, readyNs); });
+        }
+        group.wait();
+    };
+    if (arena_) {
+        // The calling thread joins through the arena's reserved slot, so the
+        // runs make progress even while every worker is busy elsewhere
+        arena_->execute(runAll);
+    } else {
+        runAll();
+    }
+}
+
+void StageScheduler::runOne(State& state, uint64_t eventIndex, uint64_t readyNs) {
+    const uint64_t startNs = StageMetrics::nowNs();
+    try {
+        run_(state.entry.stageIndex, eventIndex, readyNs);
+        state.runs.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+        recordFailure(state, eventIndex);
+    }
+    const uint64_t runNs = StageMetrics::nowNs() - startNs;
+    state.lastEvent.store(eventIndex, std::memory_order_relaxed);
+    state.lastRunNs.store(runNs, std::memory_order_relaxed);
+    state.totalRunNs.fetch_add(runNs, std::memory_order_relaxed);
+    if (!copiesInputs(state)) {
+        state.heldNs.fetch_add(runNs, std::memory_order_relaxed);
+    }
+}
+
+void StageScheduler::recordFailure(State& state, uint64_t eventIndex) {
+    // Called from inside a catch block
+    state.failed.fetch_add(1, std::memory_order_relaxed);
+    spdlog::error("[StageScheduler] Scheduled stage '{}' failed for event {}.", state.entry.id, eventIndex);
+    std::lock_guard<std::mutex> lock(errorMutex_);
+    if (!firstError_) {
+        firstError_ = std::current_exception();
+    }
+}
+
+void StageScheduler::finishRun() {
+    wait();
+    runDue();
+    wait();
+
+    std::vector<State*> endOfRun;
+    uint64_t eventIndex = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        eventIndex = lastEventIndex_;
+        if (eventsSinceFinish_) {
+            for (auto& state : states_) {
+                if (state->entry.schedule.endOfRun) {
+                    endOfRun.push_back(state.get());
+                }
+            }
+        }
+        eventsSinceFinish_ = false;
+    }
+    runStages(endOfRun, eventIndex, StageMetrics::nowNs(), false);
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(errorMutex_);
+        std::swap(error, firstError_);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+nlohmann::json StageScheduler::toJson() const {
+    nlohmann::json j = nlohmann::json::object();
+    for (const auto& state : states_) {
+        j[state->entry.id] = {
+            {"blocking", !copiesInputs(*state)},
+            {"runs", state->runs.load(std::memory_order_relaxed)},
+            {"failed", state->failed.load(std::memory_order_relaxed)},
+            {"skipped", state->skipped.load(std::memory_order_relaxed)},
+            {"last_event", state->lastEvent.load(std::memory_order_relaxed)},
+            {"last_run_ms", state->lastRunNs.load(std::memory_order_relaxed) / 1e6},
+            {"total_run_ms", state->totalRunNs.load(std::memory_order_relaxed) / 1e6},
+            {"held_ms", state->heldNs.load(std::memory_order_relaxed) / 1e6}
+        };
+    }
+    return j;
+}
@@ -0,0 +1,176 @@
+#include "analysis_pipeline/pipeline/stage_topology.h"
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+// Every stage reachable from 'index' through 'edges', excluding 'index'
+std::vector<size_t> reachable(size_t index, const std::vector<std::vector<size_t>>& edges) {
+    std::vector<bool> seen(edges.size(), false);
+    std::vector<size_t> stack(edges[index].begin(), edges[index].end());
+    while (!stack.empty()) {
+        const size_t current = stack.back();
+        stack.pop_back();
+        if (current == index || seen[current]) {
+            continue;
+        }
+        seen[current] = true;
+        stack.insert(stack.end(), edges[current].begin(), edges[current].end());
+    }
+
+    std::vector<size_t> result;
+    for (size_t i = 0; i < seen.size(); ++i) {
+        if (seen[i]) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+} // anonymous namespace
+
+bool StageTopology::build(const std::vector<StageConfig>& stages) {
+    clear();
+
+    std::unordered_map<std::string, size_t> indexById;
+    for (const auto& sc : stages) {
+        indexById.emplace(sc.id, ids_.size());
+        ids_.push_back(sc.id);
+    }
+
+    successors_.resize(ids_.size());
+    predecessors_.resize(ids_.size());
+
+    for (size_t from = 0; from < stages.size(); ++from) {
+        for (const auto& nextId : stages[from].next) {
+            auto it = indexById.find(nextId);
+            if (it == indexById.end()) {
+                spdlog::error("[StageTopology] Invalid next id: {}", nextId);
+                clear();
+                return false;
+            }
+            size_t to = it->second;
+            if (std::find(successors_[from].begin(), successors_[from].end(), to) != successors_[from].end()) {
+                continue;
+            }
+            successors_[from].push_back(to);
+            predecessors_[to].push_back(from);
+        }
+    }
+
+    for (size_t i = 0; i < ids_.size(); ++i) {
+        if (predecessors_[i].empty()) {
+            startStages_.push_back(i);
+        }
+        ancestors_.push_back(reachable(i, predecessors_));
+        descendants_.push_back(reachable(i, successors_));
+    }
+
+    return true;
+}
+
+void StageTopology::clear() {
+    ids_.clear();
+    successors_.clear();
+    predecessors_.clear();
+    ancestors_.clear();
+    descendants_.clear();
+    startStages_.clear();
+}
+
+size_t StageTopology::size() const {
+    return ids_.size();
+}
+
+const std::string& StageTopology::id(size_t index) const {
+    return ids_.at(index);
+}
+
+std::optional<size_t> StageTopology::indexOf(const std::string& id) const {
+    auto it = std::find(ids_.begin(), ids_.end(), id);
+    if (it == ids_.end()) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(std::distance(ids_.begin(), it));
+}
+
+const std::vector<size_t>& StageTopology::successors(size_t index) const {
+    return successors_.at(index);
+}
+
+const std::vector<size_t>& StageTopology::predecessors(size_t index) const {
+    return predecessors_.at(index);
+}
+
+const std::vector<size_t>& StageTopology::ancestors(size_t index) const {
+    return ancestors_.at(index);
+}
+
+const std::vector<size_t>& StageTopology::descendants(size_t index) const {
+    return descendants_.at(index);
+}
+
+std::vector<size_t> StageTopology::between(size_t from, size_t to) const {
+    // Descendants of 'from' that are ancestors of 'to'; both lists are sorted
+    std::vector<size_t> result;
+    const auto& below = descendants_.at(from);
+    const auto& above = ancestors_.at(to);
+    std::set_intersection(below.begin(), below.end(), above.begin(), above.end(), std::back_inserter(result));
+    return result;
+}
+
+std::vector<std::vector<uint8_t>> StageTopology::activationEdges(const std::vector<uint8_t>& isFilter) const {
+    std::vector<std::vector<uint8_t>> result(ids_.size());
+    for (size_t from = 0; from < ids_.size(); ++from) {
+        for (size_t to : successors_[from]) {
+            const std::vector<size_t> path = between(from, to);
+            const bool filtered = std::any_of(path.begin(), path.end(), [&isFilter](size_t index) {
+                return index < isFilter.size() && isFilter[index];
+            });
+            result[from].push_back(!filtered);
+        }
+    }
+    return result;
+}
+
+const std::vector<size_t>& StageTopology::startStages() const {
+    return startStages_;
+}
+
+std::vector<std::vector<size_t>> StageTopology::levels() const {
+    std::vector<size_t> pending(ids_.size());
+    std::vector<size_t> levelOf(ids_.size(), 0);
+    std::vector<size_t> ready = startStages_;
+    for (size_t i = 0; i < ids_.size(); ++i) {
+        pending[i] = predecessors_[i].size();
+    }
+
+    std::vector<std::vector<size_t>> result;
+    size_t visited = 0;
+    while (!ready.empty()) {
+        const size_t index = ready.back();
+        ready.pop_back();
+        ++visited;
+        if (levelOf[index] >= result.size()) {
+            result.resize(levelOf[index] + 1);
+        }
+        result[levelOf[index]].push_back(index);
+        for (size_t next : successors_[index]) {
+            levelOf[next] = std::max(levelOf[next], levelOf[index] + 1);
+            if (--pending[next] == 0) {
+                ready.push_back(next);
+            }
+        }
+    }
+    if (visited != ids_.size()) {
+        return {};
+    }
+    for (auto& level : result) {
+        std::sort(level.begin(), level.end());
+    }
+    return result;
+}
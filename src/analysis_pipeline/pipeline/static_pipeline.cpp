@@ -0,0 +1,103 @@
+#include "analysis_pipeline/pipeline/static_pipeline.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+#include <TROOT.h>
+
+namespace {
+
+void printStaticUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [OPTIONS]\n"
+              << "\n"
+              << "Runs the pipeline compiled into this executable.\n"
+              << "\n"
+              << "Options:\n"
+              << "  -i, --input <path>      Replay events from a file (memory-mapped) to end of file\n"
+              << "  --framing <name>        length_prefixed | midas (default length_prefixed)\n"
+              << "  --max-events <n>        Stop after n events (default: all)\n"
+              << "  --iterations <n>        Graph executions when there is no input (default 3)\n"
+              << "  -h, --help              Display this help message\n"
+              << "\n"
+              << "Without --input the config's \"input\" block is used if it had one; otherwise\n"
+              << "the graph is executed --iterations times without input.\n";
+}
+
+} // anonymous namespace
+
+void prepareStaticPipeline(bool parallel) {
+    if (parallel) {
+        ROOT::EnableThreadSafety();
+    }
+}
+
+bool parseStaticRunOptions(int argc, char** argv, const char* programName,
+                           StaticRunOptions& opts, int& exitCode) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("missing value for " + arg);
+                }
+                return argv[++i];
+            };
+
+            if (arg == "-i" || arg == "--input") {
+                opts.inputPath = value();
+            } else if (arg == "--framing") {
+                opts.framing = value();
+            } else if (arg == "--max-events") {
+                opts.maxEvents = std::stoull(value());
+            } else if (arg == "--iterations") {
+                opts.iterations = std::stoi(value());
+            } else if (arg == "-h" || arg == "--help") {
+                printStaticUsage(programName);
+                exitCode = 0;
+                return false;
+            } else {
+                throw std::invalid_argument("unknown option: " + arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printStaticUsage(programName);
+        exitCode = 1;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<InputSource> openStaticInput(const StaticRunOptions& opts, const nlohmann::json& inputConfig,
+                                             bool& failed) {
+    nlohmann::json config = inputConfig;
+    if (!opts.inputPath.empty()) {
+        config = {{"location", "mmap:" + opts.inputPath}, {"framing", opts.framing}};
+    }
+    if (config.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<InputSource> source = makeInputSource(config);
+    failed = !source;
+    if (source) {
+        spdlog::info("[StaticPipeline] Reading events from {}", source->describe());
+    }
+    return source;
+}
+
+void printStaticRunSummary(uint64_t events, double seconds, const InputSource* source) {
+    const double eventsPerSec = seconds > 0.0 ? events / seconds : 0.0;
+    std::cout << "[StaticPipeline] events: " << events
+              << "  time: " << seconds << " s"
+              << "  rate: " << eventsPerSec << " events/s" << std::endl;
+    if (source && spdlog::should_log(spdlog::level::debug)) {
+        std::cout << "[StaticPipeline] source stats: " << source->statsToJson().dump() << std::endl;
+    }
+}
+
+int staticRunExitCode(const InputSource* source) {
+    return source && source->failed() ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+#include "analysis_pipeline/pipeline/task_arenas.h"
+
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+#include <tbb/task_scheduler_observer.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// CPUs of a NUMA node as listed by the kernel
+bool numaNodeCpus(int node, std::vector<int>& cpus) {
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string list;
+    if (!in || !std::getline(in, list)) {
+        return false;
+    }
+    return ConfigManager::parseCpuList(list, cpus) && !cpus.empty();
+}
+
+} // anonymous namespace
+
+// Pins threads to a CPU set while they work in the observed arena
+class TaskArenas::PinningObserver : public tbb::task_scheduler_observer {
+public:
+    PinningObserver(tbb::task_arena& arena, const std::vector<int>& cpus)
+        : tbb::task_scheduler_observer(arena) {
+#ifdef __linux__
+        CPU_ZERO(&mask_);
+        for (int cpu : cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &mask_);
+            }
+        }
+#else
+        (void)cpus;
+#endif
+        observe(true);
+    }
+
+    ~PinningObserver() override {
+        observe(false);
+    }
+
+    void on_scheduler_entry(bool) override {
+#ifdef __linux__
+        cpu_set_t previous;
+        if (pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous) != 0) {
+            return;
+        }
+        if (pthread_setaffinity_np(pthread_self(), sizeof(mask_), &mask_) == 0) {
+            savedMasks().push_back(previous);
+        }
+#endif
+    }
+
+    void on_scheduler_exit(bool) override {
+#ifdef __linux__
+        auto& saved = savedMasks();
+        if (!saved.empty()) {
+            pthread_setaffinity_np(pthread_self(), sizeof(saved.back()), &saved.back());
+            saved.pop_back();
+        }
+#endif
+    }
+
+private:
+#ifdef __linux__
+    // A thread can be nested in several pinned arenas (stage inside pipeline)
+    static std::vector<cpu_set_t>& savedMasks() {
+        thread_local std::vector<cpu_set_t> masks;
+        return masks;
+    }
+
+    cpu_set_t mask_;
+#endif
+};
+
+TaskArenas::TaskArenas() = default;
+
+TaskArenas::~TaskArenas() {
+    clear();
+}
+
+void TaskArenas::clear() {
+    arenaByStage_.clear();
+    stageArenas_.clear();
+    pipeline_.observer.reset();
+    pipeline_.arena.reset();
+    pipeline_.config = ArenaConfig();
+    background_.observer.reset();
+    background_.arena.reset();
+    background_.config = ArenaConfig();
+    backgroundConfig_ = makeBackgroundArenaConfig();
+}
+
+bool TaskArenas::configure(const ExecutionConfig& config) {
+    clear();
+    backgroundConfig_ = config.background;
+    if (!config.configured) {
+        return true;
+    }
+
+    if (!createArena(config.pipeline, pipeline_)) {
+        clear();
+        return false;
+    }
+
+    for (const auto& arenaConfig : config.stageArenas) {
+        auto arena = std::make_unique<Arena>();
+        if (!createArena(arenaConfig, *arena)) {
+            clear();
+            return false;
+        }
+        for (const auto& stageId : arenaConfig.stages) {
+            arenaByStage_[stageId] = arena->arena.get();
+        }
+        stageArenas_.push_back(std::move(arena));
+    }
+
+    return true;
+}
+
+bool TaskArenas::createArena(const ArenaConfig& config, Arena& arena,
+                             tbb::task_arena::priority priority, unsigned reservedSlots) {
+    arena.config = config;
+    if (config.numaNode >= 0 && !numaNodeCpus(config.numaNode, arena.config.cpus)) {
+        spdlog::error("[TaskArenas] Cannot read the CPUs of NUMA node {} for arena '{}'.", config.numaNode, config.name);
+        return false;
+    }
+
+    const int concurrency = config.maxConcurrency > 0 ? config.maxConcurrency : tbb::task_arena::automatic;
+    arena.arena = std::make_unique<tbb::task_arena>(concurrency, reservedSlots, priority);
+    arena.arena->initialize();
+
+    if (!arena.config.cpus.empty()) {
+#ifdef __linux__
+        arena.observer = std::make_unique<PinningObserver>(*arena.arena, arena.config.cpus);
+#else
+        spdlog::warn("[TaskArenas] Thread pinning is not supported on this platform; arena '{}' is not pinned.", config.name);
+#endif
+    }
+
+    spdlog::info("[TaskArenas] Arena '{}': max concurrency {}, {} pinned CPU(s), {} stage(s).",
+                 config.name, arena.arena->max_concurrency(), arena.config.cpus.size(), config.stages.size());
+    return true;
+}
+
+tbb::task_arena* TaskArenas::stageArena(const std::string& stageId) const {
+    auto it = arenaByStage_.find(stageId);
+    return it != arenaByStage_.end() ? it->second : nullptr;
+}
+
+tbb::task_arena* TaskArenas::backgroundArena() {
+    ArenaConfig config = backgroundConfig_;
+    if (config.maxConcurrency > 0) {
+        ++config.maxConcurrency;  // the caller's reserved slot
+    }
+    if (!background_.arena && !createArena(config, background_, tbb::task_arena::priority::low)) {
+        background_.arena.reset();
+        return nullptr;
+    }
+    return background_.arena.get();
+}
+
+nlohmann::json TaskArenas::toJson() const {
+    auto describe = [](const Arena& arena) {
+        nlohmann::json j;
+        j["name"] = arena.config.name;
+        j["max_concurrency"] = arena.arena->max_concurrency();
+        j["cpus"] = arena.config.cpus;
+        j["stages"] = arena.config.stages;
+        return j;
+    };
+
+    nlohmann::json j;
+    j["pipeline"] = pipeline_.arena ? describe(pipeline_) : nlohmann::json();
+    j["arenas"] = nlohmann::json::array();
+    for (const auto& arena : stageArenas_) {
+        j["arenas"].push_back(describe(*arena));
+    }
+    j["background"] = background_.arena ? describe(background_) : nlohmann::json();
+    return j;
+}
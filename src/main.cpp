@@ -1,44 +1,232 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <filesystem>
 #include <memory>
+#include <string>
+#include <vector>
 #include "analysis_pipeline/config/config_manager.h"
+#include "analysis_pipeline/io/mapped_file_source.h"
 #include "analysis_pipeline/pipeline/pipeline.h"
 #include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
 
-int main(int argc, char** argv) {
-    // Locate config directory relative to this source file
-    std::filesystem::path sourcePath = __FILE__;
-    std::filesystem::path configDir = sourcePath.parent_path().parent_path() / "config";
+namespace {
+
+struct RunOptions {
+    std::vector<std::string> configPaths;
+    std::string inputPath;
+    std::string framing = "length_prefixed";
+    size_t inFlight = 0;          // 0 keeps the pipeline's default
+    uint64_t maxEvents = 0;       // 0 runs to end of file
+    size_t maxEventBytes = 0;     // 0 keeps the source's default
+    int iterations = 3;           // graph executions without an input
+    std::vector<std::string> outputProducts;  // empty builds every stage
+    std::string checkpointPath;
+    double checkpointInterval = 60.0;
+    std::string restorePath;
+};
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        const size_t end = std::min(text.find(',', begin), text.size());
+        if (end > begin) {
+            items.push_back(text.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return items;
+}
+
+void printUsage() {
+    std::cout << "Usage: analysis_pipeline_exec [OPTIONS] [CONFIG.json ...]\n"
+              << "\n"
+              << "Config files are merged in order (default: config/plugins.json,\n"
+              << "config/logger.json and config/pipeline.json next to the sources).\n"
+              << "\n"
+              << "Options:\n"
+              << "  -i, --input <path>      Replay events from a file (memory-mapped) to end of file\n"
+              << "  --framing <name>        length_prefixed | midas (default length_prefixed)\n"
+              << "  --in-flight <n>         Max events traversing the graph concurrently\n"
+              << "  --max-events <n>        Stop after n events (default: all)\n"
+              << "  --max-event-bytes <n>   Treat larger frames as corruption\n"
+              << "  --iterations <n>        Graph executions when there is no input (default 3)\n"
+              << "  --outputs <a,b,...>     Only build the stages these products need\n"
+              << "  --checkpoint <path>     Checkpoint products to path while running\n"
+              << "  --checkpoint-every <s>  Seconds between checkpoints (default 60)\n"
+              << "  --restore <path>        Restore products from a checkpoint before running\n"
+              << "  -h, --help              Display this help message\n"
+              << "\n"
+              << "Without --input the config's \"input\" block is used if present; otherwise\n"
+              << "the graph is executed --iterations times without input.\n";
+}
+
+void parseArgs(int argc, char** argv, RunOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            return argv[++i];
+        };
 
-    std::vector<std::string> configPaths = {
-        (configDir / "plugins.json").string(),
-        (configDir / "logger.json").string(),
-        (configDir / "pipeline.json").string()
-    };
+        if (arg == "-i" || arg == "--input") {
+            opts.inputPath = value();
+        } else if (arg == "--framing") {
+            opts.framing = value();
+        } else if (arg == "--in-flight") {
+            opts.inFlight = std::max<size_t>(1, std::stoul(value()));
+        } else if (arg == "--max-events") {
+            opts.maxEvents = std::stoull(value());
+        } else if (arg == "--max-event-bytes") {
+            opts.maxEventBytes = std::stoul(value());
+        } else if (arg == "--iterations") {
+            opts.iterations = std::stoi(value());
+        } else if (arg == "--outputs") {
+            opts.outputProducts = splitList(value());
+        } else if (arg == "--checkpoint") {
+            opts.checkpointPath = value();
+        } else if (arg == "--checkpoint-every") {
+            opts.checkpointInterval = std::stod(value());
+        } else if (arg == "--restore") {
+            opts.restorePath = value();
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage();
+            std::exit(0);
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::invalid_argument("unknown option: " + arg);
+        } else {
+            opts.configPaths.push_back(arg);
+        }
+    }
+
+    if (opts.configPaths.empty()) {
+        // Locate config directory relative to this source file
+        std::filesystem::path sourcePath = __FILE__;
+        std::filesystem::path configDir = sourcePath.parent_path().parent_path() / "config";
+        opts.configPaths = {
+            (configDir / "plugins.json").string(),
+            (configDir / "logger.json").string(),
+            (configDir / "pipeline.json").string()
+        };
+    }
+}
+
+// Streams 'source' to its end (or maxEvents) and prints throughput
+bool replay(Pipeline& pipeline, InputSource& source, uint64_t maxEvents) {
+    std::cout << "\n[Replay] " << source.describe() << std::endl;
+
+    // run() registers the source, so the metrics segment sees its counters
+    // and load shedding sees its read-ahead queue
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t processed = pipeline.run(source, maxEvents);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const uint64_t bytes = source.bytesRead();
+    const double eventsPerSec = seconds > 0.0 ? processed / seconds : 0.0;
+    const double mbPerSec = seconds > 0.0 ? bytes / seconds / 1e6 : 0.0;
+
+    std::cout << "[Replay] events: " << processed
+              << "  bytes: " << bytes
+              << "  time: " << seconds << " s"
+              << "  rate: " << eventsPerSec << " events/s, " << mbPerSec << " MB/s" << std::endl;
+    if (spdlog::should_log(spdlog::level::debug)) {
+        std::cout << "[Replay] source stats: " << source.statsToJson().dump() << std::endl;
+    }
+    return !source.failed();
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    RunOptions opts;
+    try {
+        parseArgs(argc, argv, opts);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
 
     auto configManager = std::make_shared<ConfigManager>();
-    if (!configManager->loadFiles(configPaths) || !configManager->validate()) {
+    if (!configManager->loadFiles(opts.configPaths) || !configManager->validate()) {
         std::cerr << "Error: Failed to load or validate configuration." << std::endl;
         return 1;
     }
 
     Pipeline pipeline(configManager);
+    if (!opts.outputProducts.empty()) {
+        pipeline.setRequestedOutputs(opts.outputProducts);
+    }
     if (!pipeline.buildFromConfig()) {
         std::cerr << "Error: Failed to build pipeline." << std::endl;
         return 1;
     }
+    if (opts.inFlight != 0) {
+        pipeline.setMaxEventsInFlight(opts.inFlight);
+    }
+    if (!opts.restorePath.empty() && !pipeline.restoreCheckpoint(opts.restorePath)) {
+        std::cerr << "Error: Failed to restore checkpoint '" << opts.restorePath << "'." << std::endl;
+        return 1;
+    }
+    if (!opts.checkpointPath.empty()) {
+        pipeline.startCheckpointing(opts.checkpointPath, opts.checkpointInterval);
+    }
 
-    // Run the pipeline multiple times (e.g., 3 iterations)
-    for (int i = 1; i <= 3; ++i) {
-        pipeline.execute();
+    bool ok = true;
+    if (!opts.inputPath.empty()) {
+        auto framing = parseEventFraming(opts.framing);
+        if (!framing) {
+            std::cerr << "Error: Unknown framing '" << opts.framing << "'." << std::endl;
+            return 1;
+        }
+        MappedFileSource source(opts.inputPath, *framing);
+        if (opts.maxEventBytes != 0) {
+            source.setMaxEventBytes(opts.maxEventBytes);
+        }
+        if (!source.open()) {
+            std::cerr << "Error: Failed to map '" << opts.inputPath << "'." << std::endl;
+            return 1;
+        }
+        ok = replay(pipeline, source, opts.maxEvents);
+    } else if (!configManager->getInputConfig().empty()) {
+        auto source = makeInputSource(configManager->getInputConfig());
+        if (!source) {
+            std::cerr << "Error: Invalid 'input' config block." << std::endl;
+            return 1;
+        }
+        ok = replay(pipeline, *source, opts.maxEvents);
+    } else {
+        for (int i = 1; i <= opts.iterations; ++i) {
+            pipeline.execute();
 
-        auto jsonData = pipeline.getDataProductManager().serializeAll();
-        std::cout << "\n[Pretty JSON Dump after run " << i << "]" << std::endl;
-        std::cout << jsonData.dump(4) << std::endl;
+            // Products are persisted by output stages (e.g. ProductOutputStage);
+            // the JSON dump is for debugging only
+            if (spdlog::should_log(spdlog::level::debug)) {
+                auto jsonData = pipeline.serializeAllCached();
+                std::cout << "\n[Pretty JSON Dump after run " << i << "]" << std::endl;
+                std::cout << jsonData.dump(4) << std::endl;
+            }
+        }
+        pipeline.finishRun();
     }
 
+    // The last checkpoint covers the whole run
+    pipeline.stopCheckpointing();
+
+    std::cout << "\n[Stage Metrics]" << std::endl;
+    std::cout << pipeline.getStageMetrics().dump(4) << std::endl;
+
     // Clear data product manager once at the end
     pipeline.getDataProductManager().clear();
 
-    return 0;
+    // Drains the async logger queue, if one is configured
+    spdlog::shutdown();
+
+    return ok ? 0 : 1;
 }
@@ -0,0 +1,106 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "analysis_pipeline/io/checkpointer.h"
+#include "test_support.h"
+
+namespace {
+
+std::string tempPath(const std::string& name) {
+    return "/tmp/analysis_pipeline_test_" + std::to_string(::getpid()) + "_" + name;
+}
+
+CheckpointSnapshot::Product makeProduct(const std::string& name, const std::string& payload) {
+    CheckpointSnapshot::Product product;
+    product.name = name;
+    product.className = "TH1D";
+    product.payload = payload;
+    return product;
+}
+
+void testFileRoundTrip() {
+    const std::string path = tempPath("roundtrip.ckpt");
+    CheckpointSnapshot snapshot;
+    snapshot.events = 1234;
+    snapshot.products.push_back(makeProduct("hits", std::string("\0\1\2binary", 9)));
+    snapshot.products.push_back(makeProduct("empty", ""));
+    EXPECT(Checkpointer::writeFile(path, snapshot));
+
+    CheckpointSnapshot restored;
+    EXPECT(Checkpointer::readFile(path, restored));
+    EXPECT_EQ(restored.events, 1234u);
+    EXPECT_EQ(restored.products.size(), 2u);
+    if (restored.products.size() == 2) {
+        EXPECT_EQ(restored.products[0].name, std::string("hits"));
+        EXPECT_EQ(restored.products[0].className, std::string("TH1D"));
+        EXPECT_EQ(restored.products[0].payload, snapshot.products[0].payload);
+        EXPECT(restored.products[1].payload.empty());
+    }
+
+    // A truncated file is rejected and leaves the snapshot empty
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes.substr(0, bytes.size() - 3);
+    EXPECT(!Checkpointer::readFile(path, restored));
+    EXPECT(restored.products.empty());
+    std::remove(path.c_str());
+}
+
+void testWriterThreadSerializes() {
+    const std::string path = tempPath("writer.ckpt");
+    Checkpointer checkpointer;
+    EXPECT(checkpointer.start(path, 0.0));
+    EXPECT(!checkpointer.due());
+    checkpointer.request();
+    EXPECT(checkpointer.due());
+
+    const std::thread::id submitter = std::this_thread::get_id();
+    bool offThread = false;
+    CheckpointSnapshot snapshot;
+    snapshot.events = 42;
+    CheckpointSnapshot::Product deferred = makeProduct("deferred", "");
+    deferred.serialize = [&offThread, submitter](std::string& payload) {
+        offThread = std::this_thread::get_id() != submitter;
+        payload = "streamed";
+        return true;
+    };
+    CheckpointSnapshot::Product broken = makeProduct("broken", "");
+    broken.serialize = [](std::string&) { return false; };
+    snapshot.products.push_back(std::move(deferred));
+    snapshot.products.push_back(std::move(broken));
+    snapshot.products.push_back(makeProduct("ready", "bytes"));
+    checkpointer.submit(std::move(snapshot), 0);
+    EXPECT(!checkpointer.due());
+    EXPECT(checkpointer.flush());
+    EXPECT(offThread);
+
+    CheckpointSnapshot restored;
+    EXPECT(Checkpointer::readFile(path, restored));
+    EXPECT_EQ(restored.events, 42u);
+    EXPECT_EQ(restored.products.size(), 2u);
+    if (restored.products.size() == 2) {
+        EXPECT_EQ(restored.products[0].name, std::string("deferred"));
+        EXPECT_EQ(restored.products[0].payload, std::string("streamed"));
+        EXPECT_EQ(restored.products[1].name, std::string("ready"));
+    }
+    EXPECT_EQ(checkpointer.toJson()["written"].get<uint64_t>(), 1u);
+    checkpointer.stop();
+    EXPECT(!checkpointer.enabled());
+    std::remove(path.c_str());
+}
+
+} // anonymous namespace
+
+int main() {
+    testFileRoundTrip();
+    testWriterThreadSerializes();
+    return testResult();
+}
@@ -0,0 +1,59 @@
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/config/config_manager.h"
+#include "test_support.h"
+
+namespace {
+
+void testCpuList() {
+    std::vector<int> cpus;
+    EXPECT(ConfigManager::parseCpuList("0-3,8, 10-11", cpus));
+    EXPECT(cpus == std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+    EXPECT(ConfigManager::parseCpuList("", cpus));
+    EXPECT(cpus.empty());
+
+    for (const std::string bad : {"3abc", "1-2x", "-1", "4-2", "1--3", "a", "1,2;3", "99999999999"}) {
+        cpus = {42};
+        EXPECT(!ConfigManager::parseCpuList(bad, cpus));
+        EXPECT(cpus == std::vector<int>({42}));
+    }
+}
+
+nlohmann::json pipelineWithArenas(const nlohmann::json& arenas) {
+    return {
+        {"pipeline", {{{"id", "a"}, {"type", "Stage"}, {"parameters", nlohmann::json::object()}, {"next", {"b"}}},
+                      {{"id", "b"}, {"type", "Stage"}, {"parameters", nlohmann::json::object()},
+                       {"next", nlohmann::json::array()}}}},
+        {"execution", {{"arenas", arenas}}}
+    };
+}
+
+void testArenaNames() {
+    ConfigManager unique;
+    EXPECT(unique.addJsonObject(pipelineWithArenas({{{"name", "x"}, {"stages", {"a"}}},
+                                                    {{"name", "y"}, {"stages", {"b"}}}})));
+    EXPECT(unique.validate());
+
+    ConfigManager duplicate;
+    EXPECT(duplicate.addJsonObject(pipelineWithArenas({{{"name", "x"}, {"stages", {"a"}}},
+                                                       {{"name", "x"}, {"stages", {"b"}}}})));
+    EXPECT(!duplicate.validate());
+
+    ConfigManager reserved;
+    EXPECT(reserved.addJsonObject(pipelineWithArenas({{{"name", "background"}, {"stages", {"a"}}}})));
+    EXPECT(!reserved.validate());
+
+    ConfigManager badCpus;
+    EXPECT(!badCpus.addJsonObject(pipelineWithArenas({{{"name", "x"}, {"cpus", "3abc"}}})));
+}
+
+} // anonymous namespace
+
+int main() {
+    testCpuList();
+    testArenaNames();
+    return testResult();
+}
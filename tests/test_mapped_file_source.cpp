@@ -0,0 +1,165 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "analysis_pipeline/io/input_source.h"
+#include "analysis_pipeline/io/mapped_file_source.h"
+#include "analysis_pipeline/io/prefetching_source.h"
+#include "analysis_pipeline/io/raw_event.h"
+#include "test_support.h"
+
+namespace {
+
+std::string tempPath(const std::string& name) {
+    return "/tmp/analysis_pipeline_test_" + std::to_string(::getpid()) + "_" + name;
+}
+
+void appendLittleEndian32(std::string& bytes, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        bytes.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+std::string lengthPrefixed(const std::string& payload) {
+    std::string frame;
+    appendLittleEndian32(frame, static_cast<uint32_t>(payload.size()));
+    return frame + payload;
+}
+
+std::string midasFrame(uint32_t serial, const std::string& data) {
+    std::string frame;
+    appendLittleEndian32(frame, 1);       // event_id, trigger_mask
+    appendLittleEndian32(frame, serial);  // serial_number
+    appendLittleEndian32(frame, 0);       // time_stamp
+    appendLittleEndian32(frame, static_cast<uint32_t>(data.size()));
+    return frame + data;
+}
+
+std::string writeFile(const std::string& name, const std::string& bytes) {
+    const std::string path = tempPath(name);
+    std::ofstream(path, std::ios::binary) << bytes;
+    return path;
+}
+
+// Reads every event; returns the payloads and whether the source failed
+std::vector<std::string> readAll(InputSource& source, bool& failed) {
+    std::vector<std::string> payloads;
+    std::shared_ptr<const InputBundle> input;
+    while (source.next(input)) {
+        const auto& event = input->get<RawEvent>();
+        payloads.emplace_back(reinterpret_cast<const char*>(event.data), event.size);
+    }
+    failed = source.failed();
+    return payloads;
+}
+
+void testLengthPrefixed() {
+    const std::string path = writeFile("ok.bin", lengthPrefixed("first") + lengthPrefixed("") + lengthPrefixed("third"));
+    MappedFileSource source(path, EventFraming::LengthPrefixed);
+    EXPECT(source.open());
+    bool failed = true;
+    const auto payloads = readAll(source, failed);
+    EXPECT(!failed);
+    EXPECT(payloads == std::vector<std::string>({"first", "", "third"}));
+    EXPECT_EQ(source.statsToJson().value("events", uint64_t(0)), 3u);
+    std::remove(path.c_str());
+}
+
+void testMidas() {
+    const std::string path = writeFile("ok.mid", midasFrame(7, "abcd") + midasFrame(8, "xy"));
+    MappedFileSource source(path, EventFraming::Midas);
+    bool failed = true;
+    const auto payloads = readAll(source, failed);
+    EXPECT(!failed);
+    EXPECT_EQ(payloads.size(), 2u);
+    if (payloads.size() == 2) {
+        // MIDAS events keep their 16-byte header
+        EXPECT_EQ(payloads[0].size(), 20u);
+        EXPECT_EQ(payloads[1].substr(16), std::string("xy"));
+    }
+    std::remove(path.c_str());
+}
+
+void testTruncatedHeader() {
+    const std::string path = writeFile("short_header.bin", lengthPrefixed("event") + std::string("\x05\x00", 2));
+    MappedFileSource source(path, EventFraming::LengthPrefixed);
+    bool failed = false;
+    const auto payloads = readAll(source, failed);
+    EXPECT(failed);
+    EXPECT(payloads == std::vector<std::string>({"event"}));
+    std::remove(path.c_str());
+}
+
+void testTruncatedBody() {
+    std::string bytes = lengthPrefixed("event") + lengthPrefixed("cut off");
+    bytes.resize(bytes.size() - 3);
+    const std::string path = writeFile("short_body.bin", bytes);
+    MappedFileSource source(path, EventFraming::LengthPrefixed);
+    bool failed = false;
+    const auto payloads = readAll(source, failed);
+    EXPECT(failed);
+    EXPECT(payloads == std::vector<std::string>({"event"}));
+    std::remove(path.c_str());
+}
+
+void testPrefetchedTruncated() {
+    // The prefetcher nests its reader's counters, but failure and bytes pass through
+    std::string bytes = lengthPrefixed("event") + lengthPrefixed("cut off");
+    bytes.resize(bytes.size() - 3);
+    const std::string path = writeFile("prefetched_short_body.bin", bytes);
+    PrefetchingSource source(std::make_unique<MappedFileSource>(path, EventFraming::LengthPrefixed), 4);
+    bool failed = false;
+    const auto payloads = readAll(source, failed);
+    EXPECT(failed);
+    EXPECT(payloads == std::vector<std::string>({"event"}));
+    EXPECT_EQ(source.bytesRead(), 9u);
+
+    // A "file:" location is read through a prefetcher by default
+    auto configured = makeInputSource({{"location", "file:" + path}});
+    EXPECT(configured != nullptr);
+    if (configured) {
+        EXPECT(configured->statsToJson().contains("upstream"));
+        const auto streamed = readAll(*configured, failed);
+        EXPECT(failed);
+        EXPECT(streamed == std::vector<std::string>({"event"}));
+        EXPECT_EQ(configured->bytesRead(), 9u);
+    }
+    std::remove(path.c_str());
+}
+
+void testOversizedFrame() {
+    const std::string path = writeFile("oversized.bin", lengthPrefixed("tiny") + lengthPrefixed(std::string(64, 'x')));
+    MappedFileSource source(path, EventFraming::LengthPrefixed);
+    source.setMaxEventBytes(32);
+    bool failed = false;
+    const auto payloads = readAll(source, failed);
+    EXPECT(failed);
+    EXPECT(payloads == std::vector<std::string>({"tiny"}));
+    std::remove(path.c_str());
+}
+
+void testMissingFile() {
+    MappedFileSource source(tempPath("does_not_exist.bin"), EventFraming::LengthPrefixed);
+    EXPECT(!source.open());
+    std::shared_ptr<const InputBundle> input;
+    EXPECT(!source.next(input));
+    EXPECT(source.failed());
+}
+
+} // anonymous namespace
+
+int main() {
+    testLengthPrefixed();
+    testMidas();
+    testTruncatedHeader();
+    testTruncatedBody();
+    testPrefetchedTruncated();
+    testOversizedFrame();
+    testMissingFile();
+    return testResult();
+}
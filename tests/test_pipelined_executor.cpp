@@ -0,0 +1,174 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tbb/global_control.h>
+#include <tbb/task_arena.h>
+
+#include "analysis_pipeline/config/config_manager.h"
+#include "analysis_pipeline/pipeline/pipelined_executor.h"
+#include "analysis_pipeline/pipeline/stage_topology.h"
+#include "test_support.h"
+
+namespace {
+
+constexpr uint64_t kEvents = 200;
+
+std::vector<StageConfig> makeChain(size_t length) {
+    std::vector<StageConfig> stages(length);
+    for (size_t i = 0; i < length; ++i) {
+        stages[i].id = "s" + std::to_string(i);
+        stages[i].type = "Stage";
+        if (i + 1 < length) {
+            stages[i].next.push_back("s" + std::to_string(i + 1));
+        }
+    }
+    return stages;
+}
+
+// Each stage writes one "product" per event. Every stage checks that all
+// upstream products, including those of non-adjacent stages, still hold the
+// current event. Shared products, as in the product manager, need the
+// non-adjacent readers declared; slot-keyed ones, as in the ProductTable, do
+// not.
+void runChainTest(size_t length, size_t maxInFlight, bool slotKeyed) {
+    StageTopology topology;
+    EXPECT(topology.build(makeChain(length)));
+
+    const size_t copies = slotKeyed ? maxInFlight + 1 : 1;
+    std::vector<std::atomic<int64_t>> products(length * copies);
+    std::vector<std::atomic<int64_t>> lastSeen(length);
+    for (auto& product : products) {
+        product.store(-1);
+    }
+    for (auto& seen : lastSeen) {
+        seen.store(-1);
+    }
+    std::atomic<int> inconsistent{0};
+    std::atomic<int> outOfOrder{0};
+
+    PipelinedExecutor executor(topology, maxInFlight,
+                               [&](size_t stage, const EventContext& event, uint64_t) {
+        const auto sequence = static_cast<int64_t>(event.sequence);
+        const size_t copy = slotKeyed ? event.slot : 0;
+        if (lastSeen[stage].exchange(sequence) != sequence - 1) {
+            ++outOfOrder;
+        }
+        for (size_t upstream = 0; upstream < stage; ++upstream) {
+            if (products[upstream * copies + copy].load() != sequence) {
+                ++inconsistent;
+            }
+        }
+        // Give upstream stages a chance to run ahead
+        if (stage + 1 == length && event.sequence % 3 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        for (size_t upstream = 0; upstream < stage; ++upstream) {
+            if (products[upstream * copies + copy].load() != sequence) {
+                ++inconsistent;
+            }
+        }
+        products[stage * copies + copy].store(sequence);
+        for (size_t next : topology.successors(stage)) {
+            event.activeStages[next].store(true);
+        }
+    });
+    EXPECT_EQ(executor.slotCount(), maxInFlight + 1);
+    if (!slotKeyed) {
+        std::vector<std::vector<size_t>> readers(length);
+        for (size_t i = 0; i < length; ++i) {
+            readers[i] = topology.descendants(i);
+        }
+        executor.setIndirectReaders(readers);
+    }
+
+    std::mutex retiredMutex;
+    std::vector<uint64_t> retired;
+    executor.setRetireHook([&](const EventContext& event) {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        retired.push_back(event.sequence);
+    });
+
+    uint64_t supplied = 0;
+    tbb::task_arena arena(4);
+    uint64_t admitted = 0;
+    arena.execute([&] {
+        admitted = executor.run([&](std::shared_ptr<const InputBundle>& input) {
+            input.reset();
+            return supplied++ < kEvents;
+        });
+    });
+
+    EXPECT_EQ(admitted, kEvents);
+    EXPECT_EQ(inconsistent.load(), 0);
+    EXPECT_EQ(outOfOrder.load(), 0);
+    EXPECT_EQ(retired.size(), kEvents);
+    for (size_t i = 0; i < retired.size(); ++i) {
+        EXPECT_EQ(retired[i], i);
+    }
+    for (size_t i = 0; i < length; ++i) {
+        EXPECT_EQ(products[i * copies + (kEvents - 1) % copies].load(), static_cast<int64_t>(kEvents - 1));
+    }
+}
+
+// Stages of one chain run different events at the same time
+void testChainOverlap() {
+    StageTopology topology;
+    EXPECT(topology.build(makeChain(3)));
+
+    std::atomic<int> running{0};
+    std::atomic<int> maxRunning{0};
+    PipelinedExecutor executor(topology, 4, [&](size_t stage, const EventContext& event, uint64_t) {
+        const int now = ++running;
+        for (int seen = maxRunning.load(); now > seen && !maxRunning.compare_exchange_weak(seen, now);) {
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        --running;
+        for (size_t next : topology.successors(stage)) {
+            event.activeStages[next].store(true);
+        }
+    });
+
+    uint64_t supplied = 0;
+    tbb::task_arena arena(4);
+    arena.execute([&] {
+        executor.run([&](std::shared_ptr<const InputBundle>& input) {
+            input.reset();
+            return supplied++ < 20;
+        });
+    });
+
+    EXPECT(maxRunning.load() >= 2);
+}
+
+void testTransitiveClosure() {
+    std::vector<StageConfig> stages = makeChain(3);
+    stages.push_back(stages[0]);
+    stages[3].id = "side";
+    stages[3].next = {"s2"};
+    StageTopology topology;
+    EXPECT(topology.build(stages));
+    EXPECT_EQ(topology.descendants(0).size(), 2u);
+    EXPECT_EQ(topology.descendants(3).size(), 1u);
+    EXPECT_EQ(topology.ancestors(2).size(), 3u);
+    EXPECT(topology.ancestors(0).empty());
+}
+
+} // anonymous namespace
+
+int main() {
+    // Run several workers even on a single-core machine
+    tbb::global_control parallelism(tbb::global_control::max_allowed_parallelism, 4);
+    testTransitiveClosure();
+    testChainOverlap();
+    runChainTest(3, 4, false);
+    runChainTest(5, 8, false);
+    runChainTest(3, 1, false);
+    runChainTest(3, 4, true);
+    runChainTest(5, 8, true);
+    return testResult();
+}
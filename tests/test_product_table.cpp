@@ -0,0 +1,154 @@
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "analysis_pipeline/pipeline/product_table.h"
+#include "test_support.h"
+
+namespace {
+
+// Stand-ins for product objects; only their addresses are compared
+alignas(8) char objects[16][8];
+
+const TObject* fakeObject(uint64_t sequence) {
+    return reinterpret_cast<const TObject*>(objects[sequence % 16]);
+}
+
+void testHandles() {
+    ProductTable table;
+    const ProductHandle hits = table.resolve("hits");
+    const ProductHandle tracks = table.resolve("tracks");
+    EXPECT_EQ(table.resolve("hits"), hits);
+    table.finalize();
+
+    EXPECT_EQ(table.size(), 2u);
+    EXPECT_EQ(table.find("tracks"), tracks);
+    EXPECT_EQ(table.find("missing"), kInvalidProductHandle);
+    EXPECT_EQ(table.subscribe("missing"), kInvalidProductHandle);
+    EXPECT(!table.isSubscribed(hits));
+    EXPECT_EQ(table.subscribe("hits"), hits);
+    EXPECT(table.isSubscribed(hits));
+    EXPECT(!table.isSubscribed(tracks));
+    EXPECT(table.takeSubscriptions() == std::vector<ProductHandle>{hits});
+    EXPECT(table.takeSubscriptions().empty());
+    EXPECT_EQ(table.name(tracks), std::string("tracks"));
+    EXPECT(table.name(kInvalidProductHandle).empty());
+}
+
+void testPublishAndGet() {
+    ProductTable table;
+    const ProductHandle hits = table.resolve("hits");
+    table.finalize();
+
+    // Nothing published yet, and no event scope on this thread
+    EXPECT(table.get(hits, 0) == nullptr);
+    EXPECT(table.get(hits) == nullptr);
+
+    table.publish(hits, fakeObject(5), 5);
+    EXPECT(table.get(hits, 5) == fakeObject(5));
+    // Another event's reader falls back to the product manager
+    EXPECT(table.get(hits, 4) == nullptr);
+    EXPECT(table.get(hits, 6) == nullptr);
+    EXPECT(table.get(kInvalidProductHandle, 5) == nullptr);
+
+    {
+        ProductTable::Scope scope(5);
+        EXPECT(table.get(hits) == fakeObject(5));
+        {
+            ProductTable::Scope nested(6);
+            EXPECT(table.get(hits) == nullptr);
+        }
+        EXPECT(table.get(hits) == fakeObject(5));
+    }
+    EXPECT(table.get(hits) == nullptr);
+
+    table.publish(hits, fakeObject(6), 6);
+    EXPECT(table.get(hits, 5) == nullptr);
+    EXPECT(table.get(hits, 6) == fakeObject(6));
+}
+
+// Events in flight keep their own entries
+void testSlots() {
+    ProductTable table;
+    const ProductHandle hits = table.resolve("hits");
+    table.finalize();
+    EXPECT_EQ(table.slotCount(), 1u);
+    table.setSlotCount(3);
+    EXPECT_EQ(table.slotCount(), 3u);
+
+    table.publish(hits, fakeObject(4), 4, 1);
+    table.publish(hits, fakeObject(5), 5, 2);
+    EXPECT(table.get(hits, 4, 1) == fakeObject(4));
+    EXPECT(table.get(hits, 5, 2) == fakeObject(5));
+    EXPECT(table.get(hits, 4, 2) == nullptr);
+    EXPECT(table.get(hits, 5, 0) == nullptr);
+    EXPECT(table.get(hits, 5, 3) == nullptr);
+    {
+        ProductTable::Scope scope(4, 1);
+        EXPECT(table.get(hits) == fakeObject(4));
+        {
+            ProductTable::Scope nested(5, 2);
+            EXPECT(table.get(hits) == fakeObject(5));
+        }
+        EXPECT(table.get(hits) == fakeObject(4));
+    }
+
+    // Resizing drops what was published
+    table.setSlotCount(3);
+    EXPECT(table.get(hits, 4, 1) == nullptr);
+}
+
+// Readers racing a writer never see one event's tag with another's object
+void testConcurrentPublish() {
+    ProductTable table;
+    const ProductHandle hits = table.resolve("hits");
+    table.finalize();
+
+    constexpr uint64_t kEvents = 200000;
+    std::atomic<uint64_t> latest{0};
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> mismatches{0};
+    std::atomic<uint64_t> hitsSeen{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&]() {
+            // One more read after the writer is done, so every reader sees a product
+            for (bool finished = false; !finished;) {
+                finished = done.load(std::memory_order_acquire);
+                const uint64_t sequence = latest.load(std::memory_order_acquire);
+                const TObject* object = table.get(hits, sequence);
+                if (object) {
+                    hitsSeen.fetch_add(1, std::memory_order_relaxed);
+                    if (object != fakeObject(sequence)) {
+                        mismatches.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            }
+        });
+    }
+    for (uint64_t sequence = 1; sequence <= kEvents; ++sequence) {
+        table.publish(hits, fakeObject(sequence), sequence);
+        latest.store(sequence, std::memory_order_release);
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(mismatches.load(), 0u);
+    EXPECT(hitsSeen.load() > 0);
+    EXPECT(table.get(hits, kEvents) == fakeObject(kEvents));
+}
+
+} // anonymous namespace
+
+int main() {
+    testHandles();
+    testPublishAndGet();
+    testSlots();
+    testConcurrentPublish();
+    return testResult();
+}
@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "analysis_pipeline/io/product_writer.h"
+#include "analysis_pipeline/io/raw_event.h"
+#include "analysis_pipeline/io/stream_event_source.h"
+#include "test_support.h"
+
+namespace {
+
+void writeEvents(ProductWriter& writer, uint64_t first, uint64_t count) {
+    for (uint64_t index = first; index < first + count; ++index) {
+        const std::string payload = "payload" + std::to_string(index);
+        writer.beginEvent(index);
+        writer.addProduct("hist", "TH1D", payload.data(), payload.size());
+        writer.endEvent();
+    }
+}
+
+// Event index of every record in the file
+std::vector<uint64_t> readIndices(const std::string& path, bool& failed) {
+    StreamEventSource source(path, EventFraming::LengthPrefixed);
+    std::vector<uint64_t> indices;
+    std::shared_ptr<const InputBundle> input;
+    while (source.next(input)) {
+        const auto& event = input->get<RawEvent>();
+        uint64_t index = 0;
+        if (event.size >= sizeof(index)) {
+            std::memcpy(&index, event.data, sizeof(index));
+        }
+        indices.push_back(index);
+    }
+    failed = source.statsToJson().value("failed", false);
+    return indices;
+}
+
+void testTruncateAndAppend() {
+    const std::string path = "/tmp/analysis_pipeline_test_" + std::to_string(::getpid()) + "_products.bin";
+
+    ProductWriter writer(4096);
+    EXPECT(writer.open(path));
+    writeEvents(writer, 0, 3);
+    EXPECT(writer.close());
+
+    // A reload hands the file to a new writer, which continues it
+    ProductWriter next(4096);
+    EXPECT(next.open(path, true));
+    writeEvents(next, 3, 2);
+    EXPECT(next.close());
+
+    bool failed = true;
+    EXPECT(readIndices(path, failed) == std::vector<uint64_t>({0, 1, 2, 3, 4}));
+    EXPECT(!failed);
+
+    // Without 'append' the file starts over
+    ProductWriter fresh(4096);
+    EXPECT(fresh.open(path));
+    writeEvents(fresh, 0, 1);
+    EXPECT(fresh.close());
+    EXPECT(readIndices(path, failed) == std::vector<uint64_t>({0}));
+
+    std::remove(path.c_str());
+}
+
+} // anonymous namespace
+
+int main() {
+    testTruncateAndAppend();
+    return testResult();
+}
@@ -0,0 +1,117 @@
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/config/config_manager.h"
+#include "analysis_pipeline/pipeline/product_dependencies.h"
+#include "analysis_pipeline/pipeline/stage_demand.h"
+#include "analysis_pipeline/pipeline/stage_topology.h"
+#include "test_support.h"
+
+namespace {
+
+StageConfig makeStage(const std::string& id, const std::string& type, nlohmann::json parameters,
+                      std::vector<std::string> next = {}) {
+    StageConfig sc;
+    sc.id = id;
+    sc.type = type;
+    sc.parameters = std::move(parameters);
+    sc.next = std::move(next);
+    return sc;
+}
+
+// Settles the edges the way Pipeline::buildFromConfig does before construction
+StageDemand resolve(std::vector<StageConfig> stages, EdgeMode mode, const OutputsConfig& outputs,
+                    std::vector<std::string>& unknown) {
+    std::vector<StageProducts> products;
+    for (const auto& stage : stages) {
+        products.push_back(declaredProducts(stage));
+    }
+    ProductDependencies dependencies;
+    EXPECT(dependencies.derive(stages, products, mode));
+    StageTopology topology;
+    EXPECT(topology.build(stages));
+    return StageDemand::resolve(topology, products, outputs, unknown);
+}
+
+void testExplicitEdges() {
+    // source -> hist -> summary, source -> unused
+    const std::vector<StageConfig> stages = {
+        makeStage("source", "Input", nlohmann::json::object(), {"hist", "unused"}),
+        makeStage("hist", "Fill", {{"histogram_name", "pt_hist"}}, {"summary"}),
+        makeStage("summary", "Summary", nlohmann::json::object()),
+        makeStage("unused", "Fill", {{"histogram_name", "eta_hist"}})
+    };
+    OutputsConfig outputs;
+    outputs.products = {"pt_hist"};
+    std::vector<std::string> unknown;
+    const StageDemand demand = resolve(stages, EdgeMode::Explicit, outputs, unknown);
+    EXPECT(unknown.empty());
+    EXPECT_EQ(demand.count(), 2u);
+    EXPECT(demand.needs(0));
+    EXPECT(demand.needs(1));
+    EXPECT(!demand.needs(2));
+    EXPECT(!demand.needs(3));
+}
+
+void testDerivedEdges() {
+    // No 'next' at all: edges come from products
+    const std::vector<StageConfig> stages = {
+        makeStage("hits", "Decode", {{"output_product", "hits"}}),
+        makeStage("tracks", "Fit", {{"input_product", "hits"}, {"output_product", "tracks"}}),
+        makeStage("pedestals", "Calib", {{"input_product", "hits"}, {"output_product", "pedestals"}}),
+        makeStage("display", "Display", {{"input_product", "pedestals"}})
+    };
+    OutputsConfig outputs;
+    outputs.stages = {"display"};
+    std::vector<std::string> unknown;
+    const StageDemand demand = resolve(stages, EdgeMode::Derived, outputs, unknown);
+    EXPECT(unknown.empty());
+    EXPECT(demand.needs(0));
+    EXPECT(!demand.needs(1));
+    EXPECT(demand.needs(2));
+    EXPECT(demand.needs(3));
+}
+
+void testOutputStageReads() {
+    // The writer's "products" are its reads, so their producers are kept
+    const std::vector<StageConfig> stages = {
+        makeStage("hits", "Decode", {{"output_product", "hits"}}),
+        makeStage("tracks", "Fit", {{"input_product", "hits"}, {"output_product", "tracks"}}),
+        makeStage("pedestals", "Calib", {{"input_product", "hits"}, {"output_product", "pedestals"}}),
+        makeStage("writer", "ProductOutputStage", {{"path", "out.bin"}, {"products", {"tracks"}}})
+    };
+    OutputsConfig outputs;
+    outputs.stages = {"writer"};
+    std::vector<std::string> unknown;
+    const StageDemand demand = resolve(stages, EdgeMode::Derived, outputs, unknown);
+    EXPECT(unknown.empty());
+    EXPECT(demand.needs(0));
+    EXPECT(demand.needs(1));
+    EXPECT(!demand.needs(2));
+    EXPECT(demand.needs(3));
+
+    // Only ProductOutputStage takes reads from "products"
+    EXPECT(declaredProducts(makeStage("x", "Other", {{"products", {"tracks"}}})).reads.empty());
+}
+
+void testUnknownOutput() {
+    const std::vector<StageConfig> stages = {makeStage("hits", "Decode", {{"output_product", "hits"}})};
+    OutputsConfig outputs;
+    outputs.products = {"missing"};
+    outputs.stages = {"hits"};
+    std::vector<std::string> unknown;
+    resolve(stages, EdgeMode::Derived, outputs, unknown);
+    EXPECT(unknown == std::vector<std::string>({"missing"}));
+}
+
+} // anonymous namespace
+
+int main() {
+    testExplicitEdges();
+    testDerivedEdges();
+    testOutputStageReads();
+    testUnknownOutput();
+    return testResult();
+}
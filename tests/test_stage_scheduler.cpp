@@ -0,0 +1,171 @@
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <tbb/task_arena.h>
+
+#include "analysis_pipeline/config/config_manager.h"
+#include "analysis_pipeline/pipeline/stage_scheduler.h"
+#include "test_support.h"
+
+namespace {
+
+StageScheduler::Entry makeEntry(size_t stageIndex, uint64_t everyEvents, bool endOfRun) {
+    StageScheduler::Entry entry;
+    entry.stageIndex = stageIndex;
+    entry.id = "s" + std::to_string(stageIndex);
+    entry.schedule.everyEvents = everyEvents;
+    entry.schedule.endOfRun = endOfRun;
+    return entry;
+}
+
+void testEveryEvents() {
+    // One thread, reserved for the caller: the runs need no worker
+    tbb::task_arena arena(1, 1, tbb::task_arena::priority::low);
+    std::mutex runsMutex;
+    std::vector<std::pair<size_t, uint64_t>> runs;
+    StageScheduler scheduler;
+    scheduler.configure({makeEntry(0, 3, false), makeEntry(1, 0, true)}, &arena,
+                        [&](size_t stageIndex, uint64_t eventIndex, uint64_t) {
+        std::lock_guard<std::mutex> lock(runsMutex);
+        runs.emplace_back(stageIndex, eventIndex);
+    });
+
+    for (uint64_t event = 0; event < 7; ++event) {
+        scheduler.eventsRetired(event);
+        // Marking a stage due runs nothing until the drain boundary
+        if (event < 4) {
+            EXPECT(runs.empty());
+        }
+        if (event == 4) {
+            // Events 3 and 4 retired before the boundary; the run sees both
+            EXPECT(scheduler.due());
+            scheduler.runDue();
+            EXPECT(!scheduler.due());
+        }
+    }
+    EXPECT(runs == (std::vector<std::pair<size_t, uint64_t>>{{0, 4}}));
+
+    // The stage is due again after event 6; end-of-run follows it
+    scheduler.finishRun();
+    EXPECT(runs == (std::vector<std::pair<size_t, uint64_t>>{{0, 4}, {0, 6}, {1, 6}}));
+
+    // Nothing retired since the last finishRun()
+    scheduler.finishRun();
+    EXPECT_EQ(runs.size(), 3u);
+
+    const auto stats = scheduler.toJson();
+    EXPECT_EQ(stats["s0"]["runs"].get<uint64_t>(), 2u);
+    EXPECT_EQ(stats["s1"]["runs"].get<uint64_t>(), 1u);
+    EXPECT_EQ(stats["s0"]["last_event"].get<uint64_t>(), 6u);
+}
+
+void testBatchRetirement() {
+    std::vector<uint64_t> runs;
+    StageScheduler scheduler;
+    scheduler.configure({makeEntry(0, 10, false)}, nullptr,
+                        [&](size_t, uint64_t eventIndex, uint64_t) { runs.push_back(eventIndex); });
+    scheduler.eventsRetired(7, 8);
+    EXPECT(!scheduler.due());
+    scheduler.eventsRetired(15, 8);
+    EXPECT(scheduler.due());
+    scheduler.runDue();
+    EXPECT(runs == std::vector<uint64_t>({15}));
+}
+
+void testFailureRethrownAtFinish() {
+    StageScheduler scheduler;
+    std::atomic<int> calls{0};
+    scheduler.configure({makeEntry(0, 1, false)}, nullptr, [&](size_t, uint64_t, uint64_t) {
+        ++calls;
+        throw std::runtime_error("fit failed");
+    });
+    scheduler.eventsRetired(0);
+    scheduler.runDue();
+    EXPECT_EQ(calls.load(), 1);
+    bool thrown = false;
+    try {
+        scheduler.finishRun();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    EXPECT(thrown);
+    EXPECT_EQ(scheduler.toJson()["s0"]["failed"].get<uint64_t>(), 1u);
+}
+
+void testBackgroundRun() {
+    // The caller's reserved slot plus one for a worker to take the run
+    tbb::task_arena arena(2, 1, tbb::task_arena::priority::low);
+    std::atomic<int> product{0};
+    std::atomic<int> copied{-1};
+    std::atomic<int> seen{-1};
+    std::atomic<bool> release{false};
+    StageScheduler scheduler;
+    scheduler.configure({makeEntry(0, 2, false)}, &arena,
+        [&](size_t, uint64_t, uint64_t) {
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+            seen = copied.load();
+        },
+        [&](size_t) { copied = product.load(); });
+
+    product = 1;
+    scheduler.eventsRetired(0);
+    product = 2;
+    scheduler.eventsRetired(1);
+    EXPECT(scheduler.due());
+    // Copies at the boundary and returns while the run still waits
+    scheduler.runDue();
+    EXPECT(!scheduler.due());
+    EXPECT_EQ(copied.load(), 2);
+
+    // Events keep retiring; the stage comes due while still busy and is skipped
+    product = 3;
+    scheduler.eventsRetired(2);
+    product = 4;
+    scheduler.eventsRetired(3);
+    EXPECT(!scheduler.due());
+    EXPECT_EQ(copied.load(), 2);
+
+    release = true;
+    scheduler.wait();
+    EXPECT_EQ(seen.load(), 2);
+    const auto stats = scheduler.toJson()["s0"];
+    EXPECT(!stats["blocking"].get<bool>());
+    EXPECT_EQ(stats["runs"].get<uint64_t>(), 1u);
+    EXPECT_EQ(stats["skipped"].get<uint64_t>(), 1u);
+}
+
+void testBlockingOptIn() {
+    // "blocking": true runs on the products themselves, without a copy
+    tbb::task_arena arena(2, 1, tbb::task_arena::priority::low);
+    std::atomic<int> prepared{0};
+    std::atomic<int> runs{0};
+    StageScheduler::Entry entry = makeEntry(0, 1, false);
+    entry.schedule.blocking = true;
+    StageScheduler scheduler;
+    scheduler.configure({entry}, &arena, [&](size_t, uint64_t, uint64_t) { ++runs; },
+                        [&](size_t) { ++prepared; });
+    scheduler.eventsRetired(0);
+    scheduler.runDue();
+    // Finished when runDue() returns
+    EXPECT_EQ(runs.load(), 1);
+    EXPECT_EQ(prepared.load(), 0);
+    EXPECT(scheduler.toJson()["s0"]["blocking"].get<bool>());
+}
+
+} // anonymous namespace
+
+int main() {
+    testEveryEvents();
+    testBatchRetirement();
+    testFailureRethrownAtFinish();
+    testBackgroundRun();
+    testBlockingOptIn();
+    return testResult();
+}
@@ -0,0 +1,86 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/config/config_manager.h"
+#include "analysis_pipeline/pipeline/product_dependencies.h"
+#include "analysis_pipeline/pipeline/stage_topology.h"
+#include "test_support.h"
+
+namespace {
+
+StageConfig makeStage(const std::string& id, std::vector<std::string> next) {
+    StageConfig sc;
+    sc.id = id;
+    sc.type = "Stage";
+    sc.next = std::move(next);
+    return sc;
+}
+
+void testLevels() {
+    // a -> b -> d, a -> c -> d, e -> d; b -> c puts c a level below b
+    StageTopology topology;
+    EXPECT(topology.build({makeStage("a", {"b", "c"}), makeStage("b", {"c", "d"}), makeStage("c", {"d"}),
+                           makeStage("d", {}), makeStage("e", {"d"})}));
+    const auto levels = topology.levels();
+    EXPECT_EQ(levels.size(), 4u);
+    if (levels.size() == 4) {
+        EXPECT(levels[0] == std::vector<size_t>({0, 4}));
+        EXPECT(levels[1] == std::vector<size_t>({1}));
+        EXPECT(levels[2] == std::vector<size_t>({2}));
+        EXPECT(levels[3] == std::vector<size_t>({3}));
+    }
+}
+
+void testCycleHasNoLevels() {
+    StageTopology topology;
+    EXPECT(topology.build({makeStage("a", {"b"}), makeStage("b", {"a"})}));
+    EXPECT(topology.levels().empty());
+}
+
+void testUnknownNext() {
+    StageTopology topology;
+    EXPECT(!topology.build({makeStage("a", {"missing"})}));
+    EXPECT_EQ(topology.size(), 0u);
+}
+
+void testDerivedFilterActivation() {
+    // raw -> cut -> ana, and raw -> ana because ana reads raw as well
+    std::vector<StageConfig> stages = {makeStage("raw", {}), makeStage("cut", {}), makeStage("ana", {})};
+    stages[0].parameters = {{"output_product", "raw"}};
+    stages[1].parameters = {{"input_product", "raw"}, {"output_product", "pass"}};
+    stages[2].parameters = {{"input_products", {"raw", "pass"}}, {"output_product", "hist"}};
+    std::vector<StageProducts> products;
+    for (const auto& stage : stages) {
+        products.push_back(declaredProducts(stage));
+    }
+    ProductDependencies dependencies;
+    EXPECT(dependencies.derive(stages, products, EdgeMode::Derived));
+    StageTopology topology;
+    EXPECT(topology.build(stages));
+    EXPECT(topology.successors(0) == std::vector<size_t>({1, 2}));
+    EXPECT(topology.between(0, 2) == std::vector<size_t>({1}));
+    EXPECT(topology.between(0, 1).empty());
+
+    // A filter 'cut' alone decides whether ana runs; raw only activates cut
+    const auto filtered = topology.activationEdges({0, 1, 0});
+    EXPECT(filtered[0] == std::vector<uint8_t>({1, 0}));
+    EXPECT(filtered[1] == std::vector<uint8_t>({1}));
+    EXPECT(filtered[2].empty());
+
+    // Without a filter on the way, every edge activates
+    const auto plain = topology.activationEdges({0, 0, 0});
+    EXPECT(plain[0] == std::vector<uint8_t>({1, 1}));
+}
+
+} // anonymous namespace
+
+int main() {
+    testLevels();
+    testCycleHasNoLevels();
+    testUnknownNext();
+    testDerivedFilterActivation();
+    return testResult();
+}
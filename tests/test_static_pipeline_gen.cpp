@@ -0,0 +1,151 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include <unistd.h>
+
+#include "analysis_pipeline/pipeline/static_pipeline.h"
+#include "test_support.h"
+
+// Path of analysis_pipeline_static_gen, set by CMake
+#ifndef STATIC_PIPELINE_GEN
+#error "STATIC_PIPELINE_GEN must name the generator executable"
+#endif
+
+namespace {
+
+std::string tempPath(const std::string& name) {
+    return "/tmp/analysis_pipeline_test_" + std::to_string(::getpid()) + "_" + name;
+}
+
+// Runs the generator on 'config'; returns its exit status and the generated source
+int runGenerator(const std::string& name, const std::string& config, std::string& source) {
+    const std::string configPath = tempPath(name + ".json");
+    const std::string outputPath = tempPath(name + ".cpp");
+    std::ofstream(configPath) << config;
+    const std::string command = std::string(STATIC_PIPELINE_GEN) + " -o " + outputPath + " --header stages.h " +
+                                configPath + " > /dev/null 2>&1";
+    const int status = std::system(command.c_str());
+    std::ifstream in(outputPath);
+    source.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    std::remove(configPath.c_str());
+    std::remove(outputPath.c_str());
+    return status;
+}
+
+bool contains(const std::string& text, const std::string& part) {
+    return text.find(part) != std::string::npos;
+}
+
+void testExplicitEdges() {
+    std::string source;
+    EXPECT_EQ(runGenerator("explicit", R"({"pipeline": [
+        {"id": "src", "type": "Src", "parameters": {}, "next": ["a", "b"]},
+        {"id": "a", "type": "Work", "parameters": {}, "next": ["join"]},
+        {"id": "b", "type": "Work", "parameters": {}, "next": ["join"]},
+        {"id": "join", "type": "Work", "parameters": {}, "next": []},
+        {"id": "unused", "type": "Work", "parameters": {}, "next": []}],
+        "outputs": {"stages": ["join"]}})", source), 0);
+    EXPECT(contains(source, "#include \"stages.h\""));
+    EXPECT(contains(source, "// Left out by the config's \"outputs\": unused"));
+    EXPECT(contains(source, "kNext0{{{1, \"a\", true}, {2, \"b\", true}}}"));
+    EXPECT(contains(source, "kNext1{{{3, \"join\", true}}}"));
+    EXPECT(contains(source, "kNext3{{}}"));
+    EXPECT(!contains(source, "kNext4"));
+    // a and b share a level
+    EXPECT(contains(source, "tbb::parallel_invoke(\n            [&]() { run1(input, active); },\n"
+                            "            [&]() { run2(input, active); });"));
+    EXPECT(contains(source, "static_assert(StaticStageCheck<Work, true>::ok, \"stage 'a'\");"));
+    // ROOT is prepared by the first member, before any stage is built
+    EXPECT(contains(source, ": setup_(true),\n          params_("));
+    EXPECT(source.find("StaticPipelineSetup setup_;") < source.find("Src s0_;"));
+}
+
+void testDerivedEdges() {
+    std::string source;
+    EXPECT_EQ(runGenerator("derived", R"({"edges": "derived", "pipeline": [
+        {"id": "hits", "type": "Decode", "parameters": {"output_product": "hits"}, "next": []},
+        {"id": "tracks", "type": "Fit", "parameters": {"input_product": "hits", "output_product": "tracks"}, "next": []},
+        {"id": "writer", "type": "ProductOutputStage",
+         "parameters": {"path": "out.bin", "products": ["tracks"]}, "next": []}]})", source), 0);
+    EXPECT(contains(source, "#include \"analysis_pipeline/io/product_output_stage.h\""));
+    EXPECT(contains(source, "kNext0{{{1, \"tracks\", true}}}"));
+    // The writer depends on the stage whose product it writes out
+    EXPECT(contains(source, "kNext1{{{2, \"writer\", true}}}"));
+    EXPECT(!contains(source, "tbb::parallel_invoke"));
+    EXPECT(contains(source, ": setup_(false),"));
+    // Derived edges may miss products a ProductAccessStage adds once built
+    EXPECT(contains(source, "static_assert(StaticStageCheck<Fit, false>::ok, \"stage 'tracks'\");"));
+    EXPECT(contains(source, "static_assert(StaticStageCheck<ProductOutputStage, true>::ok, \"stage 'writer'\");"));
+}
+
+void testDerivedFilter() {
+    // ana reads raw and pass, so it also gets the transitive edge from raw;
+    // whether 'cut' is a filter decides if that edge activates it
+    std::string source;
+    EXPECT_EQ(runGenerator("derived_filter", R"({"edges": "derived", "pipeline": [
+        {"id": "raw", "type": "Decode", "parameters": {"output_product": "raw"}, "next": []},
+        {"id": "cut", "type": "Cut", "parameters": {"input_product": "raw", "output_product": "pass"}, "next": []},
+        {"id": "ana", "type": "Fill",
+         "parameters": {"input_products": ["raw", "pass"], "output_product": "hist"}, "next": []}]})", source), 0);
+    EXPECT(contains(source, "kNext0{{{1, \"cut\", true}, {2, \"ana\", !anyStaticFilter<Cut>()}}}"));
+    EXPECT(contains(source, "kNext1{{{2, \"ana\", true}}}"));
+}
+
+void testRejected() {
+    std::string source;
+    // A writer of every product cannot be placed by derived edges
+    EXPECT(runGenerator("all_products", R"({"edges": "derived", "pipeline": [
+        {"id": "hits", "type": "Decode", "parameters": {"output_product": "hits"}, "next": []},
+        {"id": "writer", "type": "ProductOutputStage", "parameters": {"path": "out.bin"}, "next": []}]})",
+                    source) != 0);
+    EXPECT(runGenerator("scheduled", R"({"pipeline": [
+        {"id": "fit", "type": "Fit", "parameters": {}, "next": [], "schedule": {"every_events": 10}}]})",
+                    source) != 0);
+}
+
+std::string lengthPrefixed(const std::string& payload) {
+    std::string frame;
+    for (int i = 0; i < 4; ++i) {
+        frame.push_back(static_cast<char>((payload.size() >> (8 * i)) & 0xff));
+    }
+    return frame + payload;
+}
+
+void testTruncatedInput() {
+    // --input goes through makeInputSource; a cut-off frame must fail the run
+    std::string bytes = lengthPrefixed("event") + lengthPrefixed("cut off");
+    bytes.resize(bytes.size() - 3);
+    StaticRunOptions opts;
+    opts.inputPath = tempPath("truncated.bin");
+    std::ofstream(opts.inputPath, std::ios::binary) << bytes;
+
+    bool failed = true;
+    std::unique_ptr<InputSource> source = openStaticInput(opts, nlohmann::json::object(), failed);
+    EXPECT(!failed);
+    EXPECT(source != nullptr);
+    if (source) {
+        EXPECT_EQ(staticRunExitCode(source.get()), 0);
+        uint64_t processed = 0;
+        const uint64_t events = drainStaticInput(*source, 0, [&processed](const auto&) { ++processed; });
+        EXPECT_EQ(events, 1u);
+        EXPECT_EQ(processed, 1u);
+        EXPECT_EQ(staticRunExitCode(source.get()), 1);
+    }
+    EXPECT_EQ(staticRunExitCode(nullptr), 0);
+    std::remove(opts.inputPath.c_str());
+}
+
+} // anonymous namespace
+
+int main() {
+    testExplicitEdges();
+    testDerivedEdges();
+    testDerivedFilter();
+    testRejected();
+    testTruncatedInput();
+    return testResult();
+}
@@ -0,0 +1,42 @@
+#ifndef ANALYSISPIPELINE_TESTS_TESTSUPPORT_H
+#define ANALYSISPIPELINE_TESTS_TESTSUPPORT_H
+
+#include <iostream>
+
+// Minimal checks for the test executables: a failed EXPECT is reported and
+// counted, and main() returns testResult() so ctest sees the failure.
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define EXPECT(condition)                                                                           \
+    do {                                                                                            \
+        if (!(condition)) {                                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": expected " #condition << std::endl;      \
+            ++testFailures();                                                                       \
+        }                                                                                           \
+    } while (false)
+
+#define EXPECT_EQ(actual, expected)                                                                 \
+    do {                                                                                            \
+        const auto& actualValue_ = (actual);                                                        \
+        const auto& expectedValue_ = (expected);                                                    \
+        if (!(actualValue_ == expectedValue_)) {                                                    \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": expected " #actual " == " #expected      \
+                      << ", got " << actualValue_ << " vs " << expectedValue_ << std::endl;         \
+            ++testFailures();                                                                       \
+        }                                                                                           \
+    } while (false)
+
+inline int testResult() {
+    if (testFailures() == 0) {
+        std::cout << "All checks passed" << std::endl;
+        return 0;
+    }
+    std::cerr << testFailures() << " check(s) failed" << std::endl;
+    return 1;
+}
+
+#endif // ANALYSISPIPELINE_TESTS_TESTSUPPORT_H
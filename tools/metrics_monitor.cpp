@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+#include "analysis_pipeline/monitoring/metrics_segment.h"
+
+namespace {
+
+struct MonitorOptions {
+    std::string segment = "/analysis_pipeline";
+    unsigned intervalMs = 1000;
+    bool once = false;
+    bool clear = true;
+};
+
+void printUsage() {
+    std::cout << "Usage: analysis_pipeline_monitor [OPTIONS]\n"
+              << "\n"
+              << "Watches the metrics a running pipeline publishes to shared memory\n"
+              << "(\"monitoring\": {\"shm_segment\": ...} or Pipeline::startMetricsSegment()).\n"
+              << "\n"
+              << "Options:\n"
+              << "  --segment <name>    Shared-memory segment (default /analysis_pipeline)\n"
+              << "  --interval <ms>     Refresh period (default 1000)\n"
+              << "  --once              Print one sample and exit\n"
+              << "  --no-clear          Append samples instead of redrawing the screen\n"
+              << "  -h, --help          Display this help message\n";
+}
+
+void parseArgs(int argc, char** argv, MonitorOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--segment") {
+            opts.segment = value();
+        } else if (arg == "--interval") {
+            opts.intervalMs = std::max(1ul, std::stoul(value()));
+        } else if (arg == "--once") {
+            opts.once = true;
+        } else if (arg == "--no-clear") {
+            opts.clear = false;
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage();
+            std::exit(0);
+        } else {
+            throw std::invalid_argument("unknown option: " + arg);
+        }
+    }
+}
+
+uint64_t wallClockNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// Rate of a counter between two samples; 0 if there is no earlier sample
+double rate(uint64_t now, uint64_t before, double seconds) {
+    return seconds > 0.0 && now >= before ? static_cast<double>(now - before) / seconds : 0.0;
+}
+
+void printSample(const MetricsSample& sample, const MetricsSample* previous, bool clear) {
+    const double seconds = previous && sample.updateNs > previous->updateNs
+        ? static_cast<double>(sample.updateNs - previous->updateNs) / 1e9 : 0.0;
+    const double uptime = sample.updateNs > sample.startNs
+        ? static_cast<double>(sample.updateNs - sample.startNs) / 1e9 : 0.0;
+    const double age = wallClockNs() > sample.updateNs
+        ? static_cast<double>(wallClockNs() - sample.updateNs) / 1e9 : 0.0;
+
+    if (clear) {
+        std::cout << "\033[H\033[2J";
+    }
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "pid " << sample.pid << "  uptime " << uptime << " s  sample age " << age << " s"
+              << "  updates " << sample.updates << "\n";
+    std::cout << "events " << sample.events
+              << "  rate " << (previous ? rate(sample.events, previous->events, seconds) : 0.0) << " /s"
+              << "  in flight " << sample.inFlight << "/" << sample.maxInFlight << "\n";
+    std::cout << "input  events " << sample.inputEvents
+              << "  " << (previous ? rate(sample.inputBytes, previous->inputBytes, seconds) / 1e6 : 0.0) << " MB/s"
+              << "  queued " << sample.inputQueued << " (high water " << sample.inputHighWater << ")"
+              << "  dropped " << sample.inputDropped << "\n\n";
+
+    std::map<std::string, const MetricsSample::Stage*> before;
+    if (previous) {
+        for (const auto& stage : previous->stages) {
+            before[stage.id] = &stage;
+        }
+    }
+
+    std::cout << std::left << std::setw(28) << "stage" << std::right
+              << std::setw(14) << "calls" << std::setw(12) << "calls/s"
+              << std::setw(12) << "mean us" << std::setw(12) << "max us"
+              << std::setw(12) << "wait us" << std::setw(10) << "busy %"
+              << std::setw(12) << "rejected" << "\n";
+    for (const auto& stage : sample.stages) {
+        const auto it = before.find(stage.id);
+        const MetricsSample::Stage* prev = it != before.end() ? it->second : nullptr;
+
+        // Over the last interval when there is one, otherwise since start
+        const uint64_t calls = prev && stage.calls >= prev->calls ? stage.calls - prev->calls : stage.calls;
+        const uint64_t totalNs = prev && stage.totalNs >= prev->totalNs ? stage.totalNs - prev->totalNs : stage.totalNs;
+        const uint64_t waitNs = prev && stage.queueWaitNs >= prev->queueWaitNs
+            ? stage.queueWaitNs - prev->queueWaitNs : stage.queueWaitNs;
+        const double meanUs = calls > 0 ? static_cast<double>(totalNs) / calls / 1e3 : 0.0;
+        const double waitUs = calls > 0 ? static_cast<double>(waitNs) / calls / 1e3 : 0.0;
+        const double busy = prev && seconds > 0.0 ? 100.0 * static_cast<double>(totalNs) / (seconds * 1e9) : 0.0;
+
+        std::cout << std::left << std::setw(28) << stage.id.substr(0, 27) << std::right
+                  << std::setw(14) << stage.calls
+                  << std::setw(12) << (prev ? rate(stage.calls, prev->calls, seconds) : 0.0)
+                  << std::setw(12) << meanUs
+                  << std::setw(12) << static_cast<double>(stage.maxNs) / 1e3
+                  << std::setw(12) << waitUs
+                  << std::setw(10) << busy
+                  << std::setw(12) << stage.rejected << "\n";
+    }
+    std::cout << std::flush;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    MonitorOptions opts;
+    try {
+        parseArgs(argc, argv, opts);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    auto reader = std::make_unique<MetricsSegmentReader>();
+    if (!reader->open(opts.segment)) {
+        return 1;
+    }
+
+    // A sample this old means the writer stopped, or rebuilt its pipeline and
+    // replaced the segment; look for a new one under the same name
+    const uint64_t staleNs = std::max<uint64_t>(5000, 5ull * opts.intervalMs) * 1000000ull;
+
+    MetricsSample previous;
+    bool havePrevious = false;
+    while (true) {
+        MetricsSample sample;
+        if (!reader->read(sample)) {
+            spdlog::warn("[Monitor] Could not get a consistent sample; retrying.");
+        } else if (wallClockNs() > sample.updateNs + staleNs) {
+            auto fresh = std::make_unique<MetricsSegmentReader>();
+            if (fresh->open(opts.segment)) {
+                reader = std::move(fresh);
+                havePrevious = false;
+            }
+            if (opts.once) {
+                printSample(sample, nullptr, false);
+            }
+        } else if (!havePrevious || sample.updateNs != previous.updateNs) {
+            // A new writer starts its counters over
+            if (havePrevious && (sample.pid != previous.pid || sample.startNs != previous.startNs)) {
+                havePrevious = false;
+            }
+            printSample(sample, havePrevious ? &previous : nullptr, opts.clear && !opts.once);
+            previous = std::move(sample);
+            havePrevious = true;
+        }
+        if (opts.once) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(opts.intervalMs));
+    }
+    return 0;
+}
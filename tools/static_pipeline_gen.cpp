@@ -0,0 +1,411 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "analysis_pipeline/config/config_manager.h"
+#include "analysis_pipeline/pipeline/product_dependencies.h"
+#include "analysis_pipeline/pipeline/stage_demand.h"
+#include "analysis_pipeline/pipeline/stage_topology.h"
+
+namespace {
+
+struct GenOptions {
+    std::vector<std::string> configPaths;
+    std::vector<std::string> headers;
+    // Config stage type -> C++ type, for types whose dictionary name differs
+    std::map<std::string, std::string> typeNames;
+    std::string outputPath;
+    std::string programName = "analysis_pipeline_static";
+};
+
+// Raw string delimiter for embedded JSON
+const char* const kDelimiter = "apconfig";
+
+void printUsage() {
+    std::cout << "Usage: analysis_pipeline_static_gen [OPTIONS] CONFIG.json [CONFIG.json ...]\n"
+              << "\n"
+              << "Generates a C++ translation unit that runs the configured pipeline without\n"
+              << "the ROOT dictionary or virtual Process() calls. Build it with the plugin\n"
+              << "sources or libraries and analysis_pipeline (see\n"
+              << "analysis_pipeline_add_static_pipeline() in CMake).\n"
+              << "\n"
+              << "Options:\n"
+              << "  -o, --output <path>     Generated source file (required)\n"
+              << "  --header <path>         Header declaring stage types; repeat as needed\n"
+              << "  --type <Type=CppType>   C++ type for a config stage type (default: same name)\n"
+              << "  --name <name>           Program name shown in --help output\n"
+              << "  -h, --help              Display this help message\n";
+}
+
+void parseArgs(int argc, char** argv, GenOptions& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "-o" || arg == "--output") {
+            opts.outputPath = value();
+        } else if (arg == "--header") {
+            opts.headers.push_back(value());
+        } else if (arg == "--type") {
+            const std::string mapping = value();
+            const size_t eq = mapping.find('=');
+            if (eq == std::string::npos || eq == 0 || eq + 1 == mapping.size()) {
+                throw std::invalid_argument("--type expects Type=CppType, got '" + mapping + "'");
+            }
+            opts.typeNames[mapping.substr(0, eq)] = mapping.substr(eq + 1);
+        } else if (arg == "--name") {
+            opts.programName = value();
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage();
+            std::exit(0);
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::invalid_argument("unknown option: " + arg);
+        } else {
+            opts.configPaths.push_back(arg);
+        }
+    }
+    if (opts.outputPath.empty() || opts.configPaths.empty()) {
+        throw std::invalid_argument("an output path and at least one config file are required");
+    }
+}
+
+std::string quoted(const std::string& text) {
+    return nlohmann::json(text).dump();
+}
+
+std::string rawString(const std::string& text) {
+    if (text.find(std::string(")") + kDelimiter + "\"") != std::string::npos) {
+        throw std::runtime_error("config text contains the raw string delimiter");
+    }
+    return std::string("R\"") + kDelimiter + "(" + text + ")" + kDelimiter + "\"";
+}
+
+// The stages the generated code runs, after edge derivation and output pruning
+struct StaticGraph {
+    std::vector<StageConfig> stages;
+    // Per stage: whether its edges are settled without building it. Products
+    // a ProductAccessStage reports are only known to a built stage, so the
+    // generated code rejects such types where this is false.
+    std::vector<uint8_t> edgesKnown;
+    std::vector<std::vector<size_t>> successors;
+    // Per stage and successor, with derived or merged edges: the stages on
+    // another path to that successor. A filter among them decides alone
+    // whether the successor runs, as in Pipeline.
+    std::vector<std::vector<std::vector<size_t>>> between;
+    // Topological levels; stages of a level only depend on earlier levels
+    std::vector<std::vector<size_t>> levels;
+    std::vector<std::string> pruned;
+};
+
+bool buildGraph(const ConfigManager& config, StaticGraph& graph) {
+    std::vector<StageConfig> stages = config.getPipelineStages();
+    const bool explicitEdges = config.getEdgeMode() == EdgeMode::Explicit;
+    std::vector<StageProducts> products;
+    std::vector<uint8_t> edgesKnown;
+    for (const auto& stage : stages) {
+        if (stage.schedule.scheduled()) {
+            std::cerr << "Error: stage '" << stage.id << "' has a schedule; scheduled stages "
+                      << "are not supported in static pipelines." << std::endl;
+            return false;
+        }
+        // ProductOutputStage reads what its "products" parameter lists;
+        // without it, it reads whatever exists, which no edge can express
+        const bool builtinOutput = stage.type == "ProductOutputStage";
+        if (builtinOutput && !explicitEdges && !stage.parameters.contains("products")) {
+            std::cerr << "Error: ProductOutputStage '" << stage.id << "' lists no \"products\"; "
+                      << "with derived edges it needs them to be placed." << std::endl;
+            return false;
+        }
+        products.push_back(declaredProducts(stage));
+        edgesKnown.push_back(explicitEdges || builtinOutput);
+    }
+
+    ProductDependencies dependencies;
+    if (!dependencies.derive(stages, products, config.getEdgeMode())) {
+        std::cerr << "Error: invalid stage graph." << std::endl;
+        return false;
+    }
+    StageTopology topology;
+    if (!topology.build(stages)) {
+        std::cerr << "Error: invalid 'next' references." << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> keep(stages.size(), 1);
+    if (!config.getOutputsConfig().empty()) {
+        std::vector<std::string> unknown;
+        StageDemand demand = StageDemand::resolve(topology, products, config.getOutputsConfig(), unknown);
+        if (!unknown.empty()) {
+            for (const auto& name : unknown) {
+                std::cerr << "Error: requested output '" << name << "' matches no stage or product." << std::endl;
+            }
+            return false;
+        }
+        for (size_t i = 0; i < stages.size(); ++i) {
+            keep[i] = demand.needs(i);
+        }
+    }
+
+    // Kept stages keep their config order; pruned ones are never upstream of kept ones
+    std::vector<size_t> newIndex(stages.size(), 0);
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (keep[i]) {
+            newIndex[i] = graph.stages.size();
+            graph.stages.push_back(stages[i]);
+            graph.edgesKnown.push_back(edgesKnown[i]);
+        } else {
+            graph.pruned.push_back(stages[i].id);
+        }
+    }
+    graph.successors.assign(graph.stages.size(), {});
+    std::vector<size_t> level(graph.stages.size(), 0);
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (!keep[i]) {
+            continue;
+        }
+        std::vector<std::string> next;
+        for (size_t succ : topology.successors(i)) {
+            if (keep[succ]) {
+                graph.successors[newIndex[i]].push_back(newIndex[succ]);
+                next.push_back(stages[succ].id);
+            }
+        }
+        graph.stages[newIndex[i]].next = std::move(next);
+    }
+    StageTopology kept;
+    if (!kept.build(graph.stages)) {
+        std::cerr << "Error: invalid stage graph." << std::endl;
+        return false;
+    }
+    graph.between.assign(graph.stages.size(), {});
+    for (size_t i = 0; i < graph.stages.size(); ++i) {
+        for (size_t succ : graph.successors[i]) {
+            graph.between[i].push_back(explicitEdges ? std::vector<size_t>() : kept.between(i, succ));
+        }
+    }
+
+    // Longest path from a start stage; derive() has rejected cycles
+    std::vector<size_t> indegree(graph.stages.size(), 0);
+    for (const auto& successors : graph.successors) {
+        for (size_t succ : successors) {
+            ++indegree[succ];
+        }
+    }
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < graph.stages.size(); ++i) {
+        if (indegree[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+    for (size_t head = 0; head < ready.size(); ++head) {
+        const size_t i = ready[head];
+        if (graph.levels.size() <= level[i]) {
+            graph.levels.resize(level[i] + 1);
+        }
+        graph.levels[level[i]].push_back(i);
+        for (size_t succ : graph.successors[i]) {
+            level[succ] = std::max(level[succ], level[i] + 1);
+            if (--indegree[succ] == 0) {
+                ready.push_back(succ);
+            }
+        }
+    }
+    for (auto& members : graph.levels) {
+        std::sort(members.begin(), members.end());
+    }
+    return true;
+}
+
+std::string generate(const GenOptions& opts, const ConfigManager& config, const StaticGraph& graph) {
+    auto cppType = [&opts](const std::string& type) {
+        auto it = opts.typeNames.find(type);
+        return it != opts.typeNames.end() ? it->second : type;
+    };
+    bool parallel = false;
+    for (const auto& members : graph.levels) {
+        parallel = parallel || members.size() > 1;
+    }
+
+    nlohmann::json parameters = nlohmann::json::array();
+    for (const auto& stage : graph.stages) {
+        parameters.push_back(stage.parameters);
+    }
+
+    std::ostringstream out;
+    out << "// Generated by analysis_pipeline_static_gen from:\n";
+    for (const auto& path : opts.configPaths) {
+        out << "//   " << path << "\n";
+    }
+    out << "// Do not edit; regenerate it from the config instead.\n";
+    if (!graph.pruned.empty()) {
+        out << "// Left out by the config's \"outputs\":";
+        for (const auto& id : graph.pruned) {
+            out << " " << id;
+        }
+        out << "\n";
+    }
+    out << "\n#include \"analysis_pipeline/pipeline/static_pipeline.h\"\n";
+    const bool builtinOutput = std::any_of(graph.stages.begin(), graph.stages.end(), [](const StageConfig& stage) {
+        return stage.type == "ProductOutputStage";
+    });
+    if (builtinOutput) {
+        out << "#include \"analysis_pipeline/io/product_output_stage.h\"\n";
+    }
+    for (const auto& header : opts.headers) {
+        out << "#include " << quoted(header) << "\n";
+    }
+
+    out << "\nnamespace {\n\n"
+        << "// Stage parameters, in stage order\n"
+        << "const char* const kParameters = " << rawString(parameters.dump(2)) << ";\n\n"
+        << "const char* const kInputConfig = " << rawString(config.getInputConfig().is_null() ? "{}" : config.getInputConfig().dump()) << ";\n\n";
+
+    out << "// Stage types that cannot run here are rejected when this file is compiled\n";
+    for (size_t i = 0; i < graph.stages.size(); ++i) {
+        out << "static_assert(StaticStageCheck<" << cppType(graph.stages[i].type) << ", "
+            << (graph.edgesKnown[i] ? "true" : "false") << ">::ok, "
+            << quoted("stage '" + graph.stages[i].id + "'") << ");\n";
+    }
+    out << "\n";
+
+    out << "class GeneratedPipeline {\n"
+        << "public:\n"
+        << "    static constexpr size_t kStageCount = " << graph.stages.size() << ";\n\n"
+        << "    GeneratedPipeline()\n"
+        << "        : setup_(" << (parallel ? "true" : "false") << "),\n"
+        << "          params_(nlohmann::json::parse(kParameters))";
+    for (size_t i = 0; i < graph.stages.size(); ++i) {
+        out << ",\n          s" << i << "_(makeStaticStage<" << cppType(graph.stages[i].type) << ">(params_[" << i << "]))";
+    }
+    out << "\n    {\n";
+    for (size_t i = 0; i < graph.stages.size(); ++i) {
+        out << "        s" << i << "_.Init(params_[" << i << "], &products_);\n";
+    }
+    out << "    }\n\n"
+        << "    static nlohmann::json inputConfig() {\n"
+        << "        return nlohmann::json::parse(kInputConfig);\n"
+        << "    }\n\n"
+        << "    PipelineDataProductManager& products() { return products_; }\n\n"
+        << "    void processEvent(const std::shared_ptr<const InputBundle>& input) {\n"
+        << "        std::atomic<bool> active[kStageCount] = {};\n";
+    if (!graph.levels.empty()) {
+        for (size_t i : graph.levels.front()) {
+            out << "        active[" << i << "].store(true, std::memory_order_relaxed);\n";
+        }
+    }
+    for (size_t l = 0; l < graph.levels.size(); ++l) {
+        const auto& members = graph.levels[l];
+        out << "\n        // Level " << l << "\n";
+        if (members.size() == 1) {
+            out << "        run" << members.front() << "(input, active);\n";
+            continue;
+        }
+        out << "        tbb::parallel_invoke(\n";
+        for (size_t k = 0; k < members.size(); ++k) {
+            out << "            [&]() { run" << members[k] << "(input, active); }"
+                << (k + 1 < members.size() ? ",\n" : ");\n");
+        }
+    }
+    out << "    }\n\n"
+        << "private:\n";
+    for (size_t i = 0; i < graph.stages.size(); ++i) {
+        const auto& successors = graph.successors[i];
+        out << "    static constexpr std::array<StaticSuccessor, " << successors.size() << "> kNext" << i << "{{";
+        for (size_t k = 0; k < successors.size(); ++k) {
+            out << (k ? ", " : "") << "{" << successors[k] << ", " << quoted(graph.stages[successors[k]].id) << ", ";
+            const auto& between = graph.between[i][k];
+            if (between.empty()) {
+                out << "true}";
+                continue;
+            }
+            out << "!anyStaticFilter<";
+            for (size_t b = 0; b < between.size(); ++b) {
+                out << (b ? ", " : "") << cppType(graph.stages[between[b]].type);
+            }
+            out << ">()}";
+        }
+        out << "}};\n";
+    }
+    out << "\n";
+    for (size_t i = 0; i < graph.stages.size(); ++i) {
+        out << "    // " << graph.stages[i].id << "\n"
+            << "    void run" << i << "(const std::shared_ptr<const InputBundle>& input, std::atomic<bool>* active) {\n"
+            << "        if (!active[" << i << "].load(std::memory_order_relaxed)) {\n"
+            << "            return;\n"
+            << "        }\n"
+            << "        feedStaticStage(s" << i << "_, input);\n"
+            << "        processStaticStage(s" << i << "_);\n"
+            << "        routeStaticStage(s" << i << "_, active, kNext" << i << ");\n"
+            << "    }\n\n";
+    }
+    out << "    // First, so ROOT is prepared before any stage is constructed\n"
+        << "    StaticPipelineSetup setup_;\n"
+        << "    nlohmann::json params_;\n"
+        << "    PipelineDataProductManager products_;\n";
+    for (size_t i = 0; i < graph.stages.size(); ++i) {
+        out << "    " << cppType(graph.stages[i].type) << " s" << i << "_;  // " << graph.stages[i].id << "\n";
+    }
+    out << "};\n\n"
+        << "} // anonymous namespace\n\n"
+        << "int main(int argc, char** argv) {\n"
+        << "    return runStaticPipeline<GeneratedPipeline>(argc, argv, " << quoted(opts.programName) << ");\n"
+        << "}\n";
+    return out.str();
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    GenOptions opts;
+    try {
+        parseArgs(argc, argv, opts);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    ConfigManager config;
+    if (!config.loadFiles(opts.configPaths) || !config.validate()) {
+        std::cerr << "Error: Failed to load or validate configuration." << std::endl;
+        return 1;
+    }
+
+    StaticGraph graph;
+    if (!buildGraph(config, graph)) {
+        return 1;
+    }
+    if (graph.stages.empty()) {
+        std::cerr << "Error: the configuration has no stages." << std::endl;
+        return 1;
+    }
+
+    std::string source;
+    try {
+        source = generate(opts, config, graph);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::ofstream out(opts.outputPath, std::ios::binary | std::ios::trunc);
+    if (!out || !(out << source) || !out.flush()) {
+        std::cerr << "Error: Failed to write '" << opts.outputPath << "'." << std::endl;
+        return 1;
+    }
+    std::cout << "Generated " << opts.outputPath << ": " << graph.stages.size() << " stage(s) in "
+              << graph.levels.size() << " level(s)" << std::endl;
+    return 0;
+}